@@ -524,6 +524,12 @@ static Heuristic_Span *Heuristic_Span_create(C4_Model *model,
     heuristic_span->curr_dst_region = NULL;
     heuristic_span->dummy_cell = g_new0(C4_Score, cell_size);
     heuristic_span->dummy_cell[0] = C4_IMPOSSIBLY_LOW_SCORE;
+    heuristic_span->query_emit_limit = span->max_query
+                                + heuristic_span->src_bound->query_range
+                                + heuristic_span->dst_bound->query_range;
+    heuristic_span->target_emit_limit = span->max_target
+                                + heuristic_span->src_bound->target_range
+                                + heuristic_span->dst_bound->target_range;
     return heuristic_span;
     }
 /* FIXME: tidy : can use automatic optimal names instead ?
@@ -676,9 +682,6 @@ void Heuristic_Span_integrate(Heuristic_Span *heuristic_span,
 #endif /* 0 */
     return;
     }
-/* FIXME: optimisation: could use a faster algorithm for this
- *                      with precomputed ranges or something.
- */
 
 static gint Heuristic_Span_get_max_query_range(
             Heuristic_Span *heuristic_span){
@@ -696,6 +699,30 @@ static gint Heuristic_Span_get_max_target_range(
 
 /**/
 
+static void Heuristic_Pair_calculate_max_range(Heuristic_Pair *pair){
+    register gint i, range;
+    register Heuristic_Span *heuristic_span;
+    g_assert(pair);
+    g_assert(pair->join);
+    pair->max_query_join_range = pair->join->src_range->external_query
+                               + pair->join->dst_range->external_query;
+    pair->max_target_join_range = pair->join->src_range->external_target
+                                + pair->join->dst_range->external_target;
+    for(i = 0; i < pair->span_list->len; i++){
+        heuristic_span = pair->span_list->pdata[i];
+        range = Heuristic_Span_get_max_query_range(heuristic_span);
+        if(pair->max_query_join_range < range)
+           pair->max_query_join_range = range;
+        range = Heuristic_Span_get_max_target_range(heuristic_span);
+        if(pair->max_target_join_range < range)
+           pair->max_target_join_range = range;
+        }
+    return;
+    }
+/* Called once on creation, as these ranges are used to size
+ * the RangeTree search for every src HSP in HPair.
+ */
+
 static Heuristic_Pair *Heuristic_Pair_create(C4_Model *model,
                        Heuristic_Match *src, Heuristic_Match *dst,
                        Heuristic_ArgumentSet *has){
@@ -727,6 +754,7 @@ static Heuristic_Pair *Heuristic_Pair_create(C4_Model *model,
             g_ptr_array_add(pair->span_list, heuristic_span);
             }
         }
+    Heuristic_Pair_calculate_max_range(pair);
     return pair;
     }
 
@@ -745,23 +773,9 @@ static void Heuristic_Pair_destroy(
 void Heuristic_Pair_get_max_range(Heuristic_Pair *pair,
                                   gint *max_query_join_range,
                                   gint *max_target_join_range){
-    register gint i, range;
-    register Heuristic_Span *heuristic_span;
     g_assert(pair);
-    g_assert(pair->join);
-    (*max_query_join_range) = pair->join->src_range->external_query
-                            + pair->join->dst_range->external_query;
-    (*max_target_join_range) = pair->join->src_range->external_target
-                             + pair->join->dst_range->external_target;
-    for(i = 0; i < pair->span_list->len; i++){
-        heuristic_span = pair->span_list->pdata[i];
-        range = Heuristic_Span_get_max_query_range(heuristic_span);
-        if((*max_query_join_range) < range);
-           (*max_query_join_range) = range;
-        range = Heuristic_Span_get_max_target_range(heuristic_span);
-        if((*max_target_join_range) < range);
-           (*max_target_join_range) = range;
-        }
+    (*max_query_join_range) = pair->max_query_join_range;
+    (*max_target_join_range) = pair->max_target_join_range;
     return;
     }
 
@@ -99,8 +99,13 @@ typedef struct {
                  Region   *curr_src_region;
                  Region   *curr_dst_region;
                C4_Score   *dummy_cell;
+/**/
+                   gint    query_emit_limit;
+                   gint    target_emit_limit;
 } Heuristic_Span;
 /* The sizes of the integration matrices are as in {src,dst}_bound
+ * The {query,target}_emit_limit are the largest emit distances
+ * which can be bridged by the span and its src and dst bounds.
  */
 
 typedef struct {
@@ -124,8 +129,13 @@ typedef struct {
     Heuristic_Match *dst;
      Heuristic_Join *join;
           GPtrArray *span_list; /* Contains (*Heuristic_Span) */
+               gint  max_query_join_range;
+               gint  max_target_join_range;
 } Heuristic_Pair;
-/* A Heuristic_Pair for each valid Heuristic_Match pair */
+/* A Heuristic_Pair for each valid Heuristic_Match pair
+ * The max_{query,target}_join_range are calculated on creation
+ * from the join and each of the spans.
+ */
 
 void Heuristic_Pair_get_max_range(Heuristic_Pair *pair,
                                   gint *max_query_join_range,
@@ -487,18 +487,10 @@ static gboolean HPair_Join_is_valid(Heuristic_Join *join,
     }
 
 static gboolean HPair_Span_is_valid(Heuristic_Span *heuristic_span,
-                                    HSP *src, HSP *dst,
                                     gint query_emit, gint target_emit){
-    register gint effective_query_limit, effective_target_limit;
-    effective_query_limit = heuristic_span->span->max_query
-                          + heuristic_span->src_bound->query_range
-                          + heuristic_span->dst_bound->query_range;
-    effective_target_limit = heuristic_span->span->max_target
-                           + heuristic_span->src_bound->target_range
-                           + heuristic_span->dst_bound->target_range;
-    if(query_emit > effective_query_limit)
+    if(query_emit > heuristic_span->query_emit_limit)
         return FALSE;
-    if(target_emit > effective_target_limit)
+    if(target_emit > heuristic_span->target_emit_limit)
         return FALSE;
     if(query_emit < heuristic_span->span->min_query)
         return FALSE;
@@ -511,6 +503,7 @@ static void HPair_add_candidate_hsp_pair(HPair *hpair,
                               Heuristic_Pair *pair,
                               HSP *src, HSP *dst,
                               gint src_hsp_id, gint dst_hsp_id,
+                              gint query_emit, gint target_emit,
                               C4_Portal *src_portal,
                               C4_Portal *dst_portal,
                               gint *edge_total){
@@ -520,15 +513,10 @@ static void HPair_add_candidate_hsp_pair(HPair *hpair,
     register HPair_EdgeData *hpair_edge_data;
     register Heuristic_Span *heuristic_span;
     register gint i, src_node_id, dst_node_id;
-    gint query_emit, target_emit;
-    if(!HPair_hsp_pair_is_valid(src, dst))
-        return;
     src_node_id = hpair->bsdp_node_offset[pair->src->id]
                 + src_hsp_id - 1;
     dst_node_id = hpair->bsdp_node_offset[pair->dst->id]
                 + dst_hsp_id - 1;
-    HPair_hsp_pair_calc_emit(hpair, src, dst,
-                             &query_emit, &target_emit);
     if((HPair_Join_is_valid(pair->join,
                             query_emit, target_emit))
     && (sar_join = SAR_Join_create(src, dst, hpair, pair))){
@@ -540,7 +528,7 @@ static void HPair_add_candidate_hsp_pair(HPair *hpair,
     } else {
         for(i = 0; i < pair->span_list->len; i++){
             heuristic_span = pair->span_list->pdata[i];
-            if(HPair_Span_is_valid(heuristic_span, src, dst,
+            if(HPair_Span_is_valid(heuristic_span,
                                    query_emit, target_emit)){
                 sar_span = SAR_Span_create(src, dst, hpair,
                         heuristic_span, src_portal, dst_portal);
@@ -573,20 +561,87 @@ typedef struct {
                HSP *src_hsp;
               gint  src_hsp_id;
               gint *edge_total;
+              gint *batch_id;
+              gint *batch_query_emit;
+              gint *batch_target_emit;
+              gint  batch_len;
 } HPair_RangeTree_Report_Data;
+/* The batch arrays are each sized to the dst HSPset,
+ * and are reused for each src HSP.
+ */
 
 static gboolean HPair_RangeTree_ReportFunc(gint x, gint y,
                                 gpointer info, gpointer user_data){
     register HPair_RangeTree_Report_Data *hrtrd = user_data;
-    register gint dst_hsp_id = GPOINTER_TO_INT(info);
-    HPair_add_candidate_hsp_pair(hrtrd->hpair, hrtrd->pair,
-                      hrtrd->src_hsp,
+    hrtrd->batch_id[hrtrd->batch_len++] = GPOINTER_TO_INT(info);
+    return FALSE;
+    }
+
+static void HPair_add_candidate_hsp_batch(
+            HPair_RangeTree_Report_Data *hrtrd){
+    register gint i, dst_hsp_id, valid_len = 0;
+    register gint max_query_emit, max_target_emit;
+    register HSP *dst;
+    register HPair *hpair = hrtrd->hpair;
+    register Heuristic_Pair *pair = hrtrd->pair;
+    gint query_emit, target_emit;
+    /* Filter the reported dst HSPs and calculate their emits */
+    for(i = 0; i < hrtrd->batch_len; i++){
+        dst_hsp_id = hrtrd->batch_id[i];
+        dst = hrtrd->dst_hsp_set->hsp_list->pdata[dst_hsp_id];
+        if(!HPair_hsp_pair_is_valid(hrtrd->src_hsp, dst))
+            continue;
+        HPair_hsp_pair_calc_emit(hpair, hrtrd->src_hsp, dst,
+                                 &query_emit, &target_emit);
+        hrtrd->batch_id[valid_len] = dst_hsp_id;
+        hrtrd->batch_query_emit[valid_len] = query_emit;
+        hrtrd->batch_target_emit[valid_len] = target_emit;
+        valid_len++;
+        }
+    /* Drop those out of reach of the join and every span */
+    max_query_emit = pair->join->bound->query_range;
+    max_target_emit = pair->join->bound->target_range;
+    for(i = 0; i < pair->span_list->len; i++){
+        max_query_emit = MAX(max_query_emit,
+            ((Heuristic_Span*)pair->span_list->pdata[i])
+                                      ->query_emit_limit);
+        max_target_emit = MAX(max_target_emit,
+            ((Heuristic_Span*)pair->span_list->pdata[i])
+                                      ->target_emit_limit);
+        }
+    hrtrd->batch_len = 0;
+    for(i = 0; i < valid_len; i++){
+        hrtrd->batch_id[hrtrd->batch_len] = hrtrd->batch_id[i];
+        hrtrd->batch_query_emit[hrtrd->batch_len]
+            = hrtrd->batch_query_emit[i];
+        hrtrd->batch_target_emit[hrtrd->batch_len]
+            = hrtrd->batch_target_emit[i];
+        hrtrd->batch_len += ((hrtrd->batch_query_emit[i]
+                              <= max_query_emit)
+                           & (hrtrd->batch_target_emit[i]
+                              <= max_target_emit));
+        }
+    /* Build the SARs and find bounds for the survivors */
+    for(i = 0; i < hrtrd->batch_len; i++){
+        dst_hsp_id = hrtrd->batch_id[i];
+        HPair_add_candidate_hsp_pair(hpair, pair, hrtrd->src_hsp,
                       hrtrd->dst_hsp_set->hsp_list->pdata[dst_hsp_id],
                       hrtrd->src_hsp_id, dst_hsp_id,
+                      hrtrd->batch_query_emit[i],
+                      hrtrd->batch_target_emit[i],
                       hrtrd->src_portal, hrtrd->dst_portal,
                       hrtrd->edge_total);
-    return FALSE;
+        }
+    hrtrd->batch_len = 0;
+    return;
     }
+/* The RangeTree hits for each src HSP are collected first,
+ * then filtered in branch-free passes over flat emit arrays,
+ * so that the expensive SAR creation and bound lookups
+ * are only made for pairs which can actually be joined.
+ * Survivors are processed in report order, so the BSDP edges
+ * are added in the same order as before.
+ */
 
 static void HPair_find_candidate_hsp_pairs(HPair *hpair,
                                            Heuristic_Pair *pair,
@@ -618,6 +673,12 @@ static void HPair_find_candidate_hsp_pairs(HPair *hpair,
     hrtrd.dst_portal = dst_portal;
     hrtrd.dst_hsp_set = dst_hsp_set;
     hrtrd.edge_total = edge_total;
+    hrtrd.batch_id = g_new(gint, dst_hsp_set->hsp_list->len * 3);
+    hrtrd.batch_query_emit = hrtrd.batch_id
+                           + dst_hsp_set->hsp_list->len;
+    hrtrd.batch_target_emit = hrtrd.batch_query_emit
+                            + dst_hsp_set->hsp_list->len;
+    hrtrd.batch_len = 0;
     Heuristic_Pair_get_max_range(pair, &max_query_join_range,
                                        &max_target_join_range);
     /* Build RangeTree from the dst HSPset */
@@ -646,8 +707,10 @@ static void HPair_find_candidate_hsp_pairs(HPair *hpair,
                            max_dst_cobs_hsp->target_start)
                        + max_target_join_range,
                        HPair_RangeTree_ReportFunc, &hrtrd);
+        HPair_add_candidate_hsp_batch(&hrtrd);
         }
     RangeTree_destroy(rangetree, NULL, NULL);
+    g_free(hrtrd.batch_id);
     return;
     }
 
@@ -19,6 +19,7 @@
 
 #include "match.h"
 #include "alignment.h"
+#include "alignmentrecord.h"
 #include "exonerate_util.h"
 
 Alignment_ArgumentSet *Alignment_ArgumentSet_create(Argument *arg){
@@ -647,8 +648,8 @@ static void AlignmentView_add_SPLICE_SITE(AlignmentView *av,
                 gint query_pos, gint target_pos, gboolean is_5_prime,
                 C4_Transition *last_match){
     register gchar *gap_string = "  ";
-    static gchar qy_seq_string[3], tg_seq_string[3],
-                 qy_cons_string[3], tg_cons_string[3];
+    gchar qy_seq_string[3], tg_seq_string[3],
+          qy_cons_string[3], tg_cons_string[3];
     qy_cons_string[0] = qy_cons_string[1] = ' ';
     tg_cons_string[0] = tg_cons_string[1] = ' ';
     qy_cons_string[2] = tg_cons_string[2] = '\0';
@@ -1044,7 +1045,7 @@ static void AlignmentView_add_FRAMESHIFT(AlignmentView *av,
     register gint i, j;
     register gint curr_query_pos = query_pos,
                   curr_target_pos = target_pos;
-    static gchar seq_string[4], match_string[4], gap_string[4];
+    gchar seq_string[4], match_string[4], gap_string[4];
     register Alphabet_Type emitted_alphabet_type;
     g_assert(!(advance_query && advance_target));
     match_string[0] = '#'; /* Frameshift */
@@ -1619,9 +1620,23 @@ static gfloat Alignment_get_percent_self(Alignment *alignment,
 
 /**/
 
-static void Alignment_print_sugar_block(Alignment *alignment,
-            Sequence *query, Sequence *target, FILE *fp){
-    fprintf(fp, "%s %d %d %c %s %d %d %c %d",
+static void Alignment_get_run(gpointer run_data, gint pos,
+                              AlignmentRecord_Run *run){
+    register Alignment *alignment = run_data;
+    register AlignmentOperation *ao = alignment->operation_list->pdata[pos];
+    run->label = ao->transition->label;
+    run->advance_query = ao->transition->advance_query;
+    run->advance_target = ao->transition->advance_target;
+    run->length = ao->length;
+    return;
+    }
+
+static AlignmentRecord *Alignment_get_record(Alignment *alignment,
+                                 Sequence *query, Sequence *target){
+    register AlignmentRecord *ar = AlignmentRecord_create();
+    register gint i;
+    AlignmentRecord_Run run;
+    AlignmentRecord_set(ar,
              query->id,
              Alignment_get_coordinate(alignment, query, target,
                                       TRUE, TRUE),
@@ -1635,138 +1650,50 @@ static void Alignment_print_sugar_block(Alignment *alignment,
                                       FALSE, FALSE),
              Sequence_get_strand_as_char(target),
              alignment->score);
-    return;
+    for(i = 0; i < alignment->operation_list->len; i++){
+        Alignment_get_run(alignment, i, &run);
+        AlignmentRecord_add_run(ar, run.label, run.advance_query,
+                                run.advance_target, run.length);
+        }
+    return ar;
     }
+/* Only built for binary output */
 
-static gchar Alignment_get_cigar_type(AlignmentOperation *ao,
-                                      gint *move){
-    if(!ao->transition->advance_query){
-        (*move) = ao->transition->advance_target * ao->length;
-        return 'D';
-        }
-    if(!ao->transition->advance_target){
-        (*move) = ao->transition->advance_query * ao->length;
-        return 'I';
-        }
-    (*move) = MAX(ao->transition->advance_query,
-                  ao->transition->advance_target) * ao->length;
-    return 'M';
+static void Alignment_print_sugar_block(Alignment *alignment,
+            Sequence *query, Sequence *target, FILE *fp){
+    AlignmentRecord_print_sugar(query->id,
+             Alignment_get_coordinate(alignment, query, target,
+                                      TRUE, TRUE),
+             Alignment_get_coordinate(alignment, query, target,
+                                      TRUE, FALSE),
+             Sequence_get_strand_as_char(query),
+             target->id,
+             Alignment_get_coordinate(alignment, query, target,
+                                      FALSE, TRUE),
+             Alignment_get_coordinate(alignment, query, target,
+                                      FALSE, FALSE),
+             Sequence_get_strand_as_char(target),
+             alignment->score, fp);
+    return;
     }
 
 static void Alignment_print_cigar_block(Alignment *alignment,
             Sequence *query, Sequence *target, FILE *fp){
-    register gint i = 0;
-    register gchar *gap = "";
-    register AlignmentOperation *ao;
-    register gchar type, next_type;
-    gint move, next_move;
-    ao = alignment->operation_list->pdata[i];
-    type = Alignment_get_cigar_type(ao, &move);
-    for(i = 1; i < alignment->operation_list->len; i++){
-        ao = alignment->operation_list->pdata[i];
-        next_type = Alignment_get_cigar_type(ao, &next_move);
-        if(type == next_type){
-            move += next_move;
-        } else {
-            if(move)
-                fprintf(fp, "%s%c %d", gap, type, move);
-            move = next_move;
-            type = next_type;
-            gap = " ";
-            }
-        }
-    if(move)
-        fprintf(fp, "%s%c %d", gap, type, move);
+    AlignmentRecord_print_cigar(alignment->operation_list->len,
+                                Alignment_get_run, alignment, fp);
     return;
     }
 
 static void Alignment_print_vulgar_block(Alignment *alignment,
             Sequence *query, Sequence *target, FILE *fp){
-    register gint i;
-    register gchar *gap = "";
-    register C4_Label curr_label;
-    register gint curr_advance_query, curr_advance_target;
-    register AlignmentOperation *ao;
-    register gboolean curr_is_codon = FALSE;
-    ao = alignment->operation_list->pdata[0];
-    curr_label = ao->transition->label;
-    curr_advance_query = (ao->transition->advance_query * ao->length);
-    curr_advance_target = (ao->transition->advance_target * ao->length);
-    for(i = 1; i < alignment->operation_list->len; i++){
-        ao = alignment->operation_list->pdata[i];
-        if((ao->transition->label == curr_label)
-         && (curr_advance_query || (!ao->transition->advance_query))
-         && (curr_advance_target || (!ao->transition->advance_target))
-         && (curr_is_codon == ((ao->transition->advance_query == 3)
-                               && (ao->transition->advance_target == 3)))){
-            curr_advance_query += (ao->transition->advance_query
-                                  * ao->length);
-            curr_advance_target += (ao->transition->advance_target
-                                  * ao->length);
-        } else {
-            switch(curr_label){
-                case C4_Label_NONE:
-                    break;
-                case C4_Label_MATCH:
-                    g_assert(curr_advance_query && curr_advance_target);
-                    fprintf(fp, "%s%c %d %d", gap, curr_is_codon?'C':'M',
-                                              curr_advance_query,
-                                              curr_advance_target);
-                    gap = " ";
-                    break;
-                case C4_Label_GAP:
-                    g_assert(curr_advance_query || curr_advance_target);
-                    g_assert(!  (curr_advance_query
-                              && curr_advance_target));
-                    fprintf(fp, "%sG %d %d", gap, curr_advance_query,
-                                                  curr_advance_target);
-                    gap = " ";
-                    break;
-                case C4_Label_NER:
-                    fprintf(fp, "%sN %d %d", gap, curr_advance_query,
-                                                  curr_advance_target);
-                    gap = " ";
-                    break;
-                case C4_Label_5SS:
-                    fprintf(fp, "%s5 %d %d", gap, curr_advance_query,
-                                                  curr_advance_target);
-                    gap = " ";
-                    break;
-                case C4_Label_3SS:
-                    fprintf(fp, "%s3 %d %d", gap, curr_advance_query,
-                                                  curr_advance_target);
-                    gap = " ";
-                    break;
-                case C4_Label_INTRON:
-                    fprintf(fp, "%sI %d %d", gap, curr_advance_query,
-                                                  curr_advance_target);
-                    gap = " ";
-                    break;
-                case C4_Label_SPLIT_CODON:
-                    fprintf(fp, "%sS %d %d", gap, curr_advance_query,
-                                                  curr_advance_target);
-                    gap = " ";
-                    break;
-                case C4_Label_FRAMESHIFT:
-                    fprintf(fp, "%sF %d %d", gap, curr_advance_query,
-                                                   curr_advance_target);
-                    gap = " ";
-                    break;
-                default:
-                    g_error("Unknown C4_Label [%d]", curr_label);
-                    break;
-                }
-            curr_label = ao->transition->label;
-            curr_is_codon = ((ao->transition->advance_query == 3)
-                          && (ao->transition->advance_target == 3));
-            curr_advance_query = (ao->transition->advance_query
-                                  * ao->length);
-            curr_advance_target = (ao->transition->advance_target
-                                  * ao->length);
-            }
-        }
+    AlignmentRecord_print_vulgar(alignment->operation_list->len,
+                                 Alignment_get_run, alignment, fp);
     return;
     }
+/* The text reports are written by the AlignmentRecord printers
+ * straight from the operation list, so they are the same
+ * whether or not they are read back from binary output.
+ */
 
 typedef enum {
     Alignment_RYO_TOKEN_STRING,
@@ -1823,6 +1750,7 @@ typedef struct {
     Alignment_RYO_Token  token;
                 GString *str;      /* For TOKEN_STRING */
                gboolean  on_query; /* For [QT] */
+                   gint  pto_open; /* For TOKEN_PTO_CLOSE */
 } Alignment_RYO_ComplexToken;
 
 static Alignment_RYO_ComplexToken *Alignment_RYO_ComplexToken_create(
@@ -1835,6 +1763,7 @@ static Alignment_RYO_ComplexToken *Alignment_RYO_ComplexToken_create(
     else
         rct->str = NULL;
     rct->on_query = on_query;
+    rct->pto_open = -1;
     return rct;
     }
 
@@ -2219,6 +2148,47 @@ static void Alignment_RYO_token_list_destroy(GPtrArray *token_list){
     return;
     }
 
+static void Alignment_RYO_token_list_link_pto(GPtrArray *token_list){
+    register gint i, pto_start = -1;
+    register Alignment_RYO_ComplexToken *rct;
+    for(i = 0; i < token_list->len; i++){
+        rct = token_list->pdata[i];
+        switch(rct->token){
+            case Alignment_RYO_TOKEN_PTO_OPEN:
+                if(pto_start != -1)
+                    g_error("Cannot nest PTO brackets");
+                pto_start = i;
+                break;
+            case Alignment_RYO_TOKEN_PTO_CLOSE:
+                if(pto_start == -1)
+                    g_error("No opening PTO bracket in --ryo string");
+                rct->pto_open = pto_start;
+                pto_start = -1;
+                break;
+            case Alignment_RYO_TOKEN_PTO_SEQ:
+            case Alignment_RYO_TOKEN_PTO_ADVANCE:
+            case Alignment_RYO_TOKEN_PTO_BEGIN:
+            case Alignment_RYO_TOKEN_PTO_END:
+            case Alignment_RYO_TOKEN_PTO_NAME:
+            case Alignment_RYO_TOKEN_PTO_SCORE:
+            case Alignment_RYO_TOKEN_PTO_LABEL:
+                if(pto_start == -1)
+                    g_error("Per-transition output outside"
+                            " PTO brackets in --ryo string");
+                break;
+            default:
+                break;
+            }
+        }
+    if(pto_start != -1)
+        g_error("No closing PTO bracket in --ryo string");
+    return;
+    }
+/* Checks the PTO brackets once when the format is compiled,
+ * and links each closing bracket to its opening bracket,
+ * so nothing needs to be checked while printing each alignment.
+ */
+
 /**/
 
 typedef struct {
@@ -2397,31 +2367,57 @@ static void Alignment_Coding_destroy(Alignment_Coding *ac){
     return;
     }
 
+static Alignment_Coding *Alignment_RYO_get_coding(Alignment *alignment,
+                         Sequence *query, Sequence *target,
+                         gpointer user_data, gboolean on_query,
+                         Alignment_Coding **qy_ac, Alignment_Coding **tg_ac){
+    register Alignment_Coding **ac = on_query?qy_ac:tg_ac;
+    if(!*ac)
+        *ac = Alignment_Coding_create(alignment, query, target,
+                                      user_data, on_query);
+    return *ac;
+    }
+/* The coding region is found once per alignment and strand,
+ * then shared by all the %c tokens in the format.
+ */
+
 /**/
 
+static void Alignment_RYO_add_rank_pos(GArray *rank_pos_list, FILE *fp){
+    glong pos;
+    if(!rank_pos_list)
+        return;
+    pos = ftell(fp);
+    if(pos == -1)
+        g_error("Could not find rank position in output");
+    g_array_append_val(rank_pos_list, pos);
+    return;
+    }
+
 static void Alignment_RYO_token_list_print(GPtrArray *token_list,
             Alignment *alignment, Sequence *query, Sequence *target,
-            Translate *translate, gint rank,
+            Translate *translate, gint rank, GArray *rank_pos_list,
             gpointer user_data, gpointer self_data, FILE *fp){
-    register gint i, j, pto_start = -1;
+    register gint i, j;
     register Alignment_RYO_ComplexToken *rct;
     register Sequence *seq, *subseq;
     register Alignment_Position *ap = NULL;
-    register Alignment_Coding *qy_ac = NULL, *tg_ac = NULL, *ac;
+    register Alignment_Coding *ac;
+    Alignment_Coding *qy_ac = NULL, *tg_ac = NULL;
     for(i = 0; i < token_list->len; i++){
         rct = token_list->pdata[i];
         seq = rct->on_query?query:target;
         switch(rct->token){
             case Alignment_RYO_TOKEN_STRING:
-                fprintf(fp, "%s", rct->str->str);
+                fwrite(rct->str->str, sizeof(gchar), rct->str->len, fp);
                 break;
             /**/
             case Alignment_RYO_TOKEN_ID:
-                fprintf(fp, "%s", seq->id);
+                fputs(seq->id, fp);
                 break;
             case Alignment_RYO_TOKEN_DEF:
                 if(seq->def)
-                    fprintf(fp, "%s", seq->def);
+                    fputs(seq->def, fp);
                 break;
             case Alignment_RYO_TOKEN_LEN:
                 fprintf(fp, "%d", seq->len);
@@ -2467,35 +2463,27 @@ static void Alignment_RYO_token_list_print(GPtrArray *token_list,
                 break;
             /**/
             case Alignment_RYO_TOKEN_CODING_BEGIN:
-                ac = rct->on_query?qy_ac:tg_ac;
-                if(!ac)
-                    ac = Alignment_Coding_create(alignment,
-                            query, target, user_data, rct->on_query);
+                ac = Alignment_RYO_get_coding(alignment, query, target,
+                        user_data, rct->on_query, &qy_ac, &tg_ac);
                 fprintf(fp, "%d", Alignment_convert_coordinate(alignment,
                               query, target,
                               ac->begin, ac->begin, rct->on_query));
                 break;
             case Alignment_RYO_TOKEN_CODING_END:
-                ac = rct->on_query?qy_ac:tg_ac;
-                if(!ac)
-                    ac = Alignment_Coding_create(alignment,
-                            query, target, user_data, rct->on_query);
+                ac = Alignment_RYO_get_coding(alignment, query, target,
+                        user_data, rct->on_query, &qy_ac, &tg_ac);
                 fprintf(fp, "%d", Alignment_convert_coordinate(alignment,
                               query, target,
                               ac->end, ac->end, rct->on_query));
                 break;
             case Alignment_RYO_TOKEN_CODING_LEN:
-                ac = rct->on_query?qy_ac:tg_ac;
-                if(!ac)
-                    ac = Alignment_Coding_create(alignment,
-                            query, target, user_data, rct->on_query);
+                ac = Alignment_RYO_get_coding(alignment, query, target,
+                        user_data, rct->on_query, &qy_ac, &tg_ac);
                 fprintf(fp, "%d", ac->seq->len);
                 break;
             case Alignment_RYO_TOKEN_CODING_SEQ:
-                ac = rct->on_query?qy_ac:tg_ac;
-                if(!ac)
-                    ac = Alignment_Coding_create(alignment,
-                            query, target, user_data, rct->on_query);
+                ac = Alignment_RYO_get_coding(alignment, query, target,
+                        user_data, rct->on_query, &qy_ac, &tg_ac);
                 Sequence_print_fasta_block(ac->seq, fp);
                 break;
             /**/
@@ -2507,7 +2495,7 @@ static void Alignment_RYO_token_list_print(GPtrArray *token_list,
                 break;
             case Alignment_RYO_TOKEN_RANK:
                 if(rank == -1)
-                    fprintf(fp, "%%_EXONERATE_BESTN_RANK_%%");
+                    Alignment_RYO_add_rank_pos(rank_pos_list, fp);
                 else
                     fprintf(fp, "%d", rank);
                 break;
@@ -2574,25 +2562,20 @@ static void Alignment_RYO_token_list_print(GPtrArray *token_list,
                 break;
             /**/
             case Alignment_RYO_TOKEN_PTO_OPEN:
-                if(pto_start != -1)
-                    g_error("Cannot nest PTO brackets");
-                pto_start = i;
                 ap = Alignment_Position_create(alignment, user_data);
                 break;
             case Alignment_RYO_TOKEN_PTO_CLOSE:
-                if(pto_start == -1)
-                    g_error("No opening PTO bracket in --ryo string");
+                g_assert(ap);
                 if(Alignment_Position_next(ap)){
-                    i = pto_start;
+                    i = rct->pto_open;
                 } else {
-                    pto_start = -1;
                     Alignment_Position_destroy(ap);
                     ap = NULL;
                     }
                 break;
             /**/
             case Alignment_RYO_TOKEN_PTO_SEQ:
-                g_assert(pto_start != -1);
+                g_assert(ap);
                 if(rct->on_query){
                     if(ap->ao->transition->advance_query){
                         for(j = 0; j < ap->ao->transition->advance_query; j++)
@@ -2647,8 +2630,7 @@ static void Alignment_RYO_token_list_print(GPtrArray *token_list,
                 break;
             }
         }
-    if(pto_start != -1)
-        g_error("No closing PTO bracket in --ryo string");
+    g_assert(!ap);
     if(qy_ac)
         Alignment_Coding_destroy(qy_ac);
     if(tg_ac)
@@ -2656,15 +2638,37 @@ static void Alignment_RYO_token_list_print(GPtrArray *token_list,
     return;
     }
 
+Alignment_RYO *Alignment_RYO_create(gchar *format){
+    register Alignment_RYO *ryo = g_new(Alignment_RYO, 1);
+    ryo->token_list = Alignment_RYO_tokenise(format);
+    Alignment_RYO_token_list_link_pto(ryo->token_list);
+    return ryo;
+    }
+
+void Alignment_RYO_destroy(Alignment_RYO *ryo){
+    Alignment_RYO_token_list_destroy(ryo->token_list);
+    g_free(ryo);
+    return;
+    }
+
+void Alignment_RYO_display(Alignment_RYO *ryo, Alignment *alignment,
+        Sequence *query, Sequence *target,
+        Translate *translate, gint rank, GArray *rank_pos_list,
+        gpointer user_data, gpointer self_data, FILE *fp){
+    Alignment_RYO_token_list_print(ryo->token_list, alignment,
+                                   query, target, translate, rank,
+                                   rank_pos_list, user_data, self_data, fp);
+    return;
+    }
+
 void Alignment_display_ryo(Alignment *alignment,
         Sequence *query, Sequence *target, gchar *format,
         Translate *translate, gint rank,
         gpointer user_data, gpointer self_data, FILE *fp){
-    register GPtrArray *token_list = Alignment_RYO_tokenise(format);
-    Alignment_RYO_token_list_print(token_list, alignment,
-                                   query, target, translate, rank,
-                                   user_data, self_data, fp);
-    Alignment_RYO_token_list_destroy(token_list);
+    register Alignment_RYO *ryo = Alignment_RYO_create(format);
+    Alignment_RYO_display(ryo, alignment, query, target, translate,
+                          rank, NULL, user_data, self_data, fp);
+    Alignment_RYO_destroy(ryo);
     return;
     }
 
@@ -2705,6 +2709,18 @@ void Alignment_display_vulgar(Alignment *alignment,
     return;
     }
 
+void Alignment_display_binary(Alignment *alignment,
+                              Sequence *query, Sequence *target, FILE *fp){
+    register AlignmentRecord *ar = Alignment_get_record(alignment,
+                                                        query, target);
+    AlignmentRecord_write(ar, fp);
+    AlignmentRecord_destroy(ar);
+    return;
+    }
+/* binary: one AlignmentRecord per alignment,
+ * which can be converted back to sugar, cigar or vulgar
+ */
+
 /**/
 
 static void Alignment_display_gff_header(Alignment *alignment,
@@ -74,6 +74,9 @@ void Alignment_display_cigar(Alignment *alignment,
 void Alignment_display_vulgar(Alignment *alignment,
                               Sequence *query, Sequence *target, FILE *fp);
 
+void Alignment_display_binary(Alignment *alignment,
+                              Sequence *query, Sequence *target, FILE *fp);
+
 void Alignment_display_gff(Alignment *alignment,
                            Sequence *query, Sequence *target,
                            Translate *translate,
@@ -81,6 +84,26 @@ void Alignment_display_gff(Alignment *alignment,
                            gboolean report_on_genomic,
                            gint result_id, gpointer user_data, FILE *fp);
 
+typedef struct {
+    GPtrArray *token_list;
+} Alignment_RYO;
+/* A --ryo format string tokenised and checked once,
+ * for printing any number of alignments.
+ */
+
+Alignment_RYO *Alignment_RYO_create(gchar *format);
+          void  Alignment_RYO_destroy(Alignment_RYO *ryo);
+          void  Alignment_RYO_display(Alignment_RYO *ryo,
+                    Alignment *alignment,
+                    Sequence *query, Sequence *target,
+                    Translate *translate, gint rank,
+                    GArray *rank_pos_list,
+                    gpointer user_data, gpointer self_data, FILE *fp);
+/* When the rank is -1, %r prints nothing,
+ * and its offset in fp is appended to rank_pos_list (of glong),
+ * so the rank can be filled in once it is known.
+ */
+
 void Alignment_display_ryo(Alignment *alignment,
         Sequence *query, Sequence *target, gchar *format,
         Translate *translate, gint rank,
@@ -13,30 +13,151 @@
 *                                                                *
 \****************************************************************/
 
+#include <string.h>   /* For strcmp() */
+#include <unistd.h>   /* For fork() */
+#include <sys/wait.h> /* For waitpid() */
 #include <glib.h>
 
 #include "alignment.h"
 #include "match.h"
 
+static gchar *test_read_output(FILE *fp){
+    register glong len = ftell(fp);
+    register gchar *output = g_new(gchar, len+1);
+    g_assert(len >= 0);
+    rewind(fp);
+    g_assert(fread(output, sizeof(gchar), len, fp) == len);
+    output[len] = '\0';
+    fclose(fp);
+    return output;
+    }
+
+static gchar *test_ryo_display(Alignment_RYO *ryo, Alignment *alignment,
+                               Sequence *query, Sequence *target,
+                               gint rank, GArray *rank_pos_list){
+    register FILE *fp = tmpfile();
+    g_assert(fp);
+    Alignment_RYO_display(ryo, alignment, query, target, NULL, rank,
+                          rank_pos_list, NULL, NULL, fp);
+    return test_read_output(fp);
+    }
+
+static gchar *test_display_ryo(Alignment *alignment,
+                               Sequence *query, Sequence *target,
+                               gchar *format, gint rank){
+    register FILE *fp = tmpfile();
+    g_assert(fp);
+    Alignment_display_ryo(alignment, query, target, format, NULL, rank,
+                          NULL, NULL, fp);
+    return test_read_output(fp);
+    }
+
+static void test_ryo(Alignment *alignment,
+                     Sequence *query, Sequence *target,
+                     gchar *format, gint rank, gchar *expect){
+    register Alignment_RYO *ryo = Alignment_RYO_create(format);
+    register gchar *first, *second, *once;
+    first = test_ryo_display(ryo, alignment, query, target, rank, NULL);
+    second = test_ryo_display(ryo, alignment, query, target, rank, NULL);
+    once = test_display_ryo(alignment, query, target, format, rank);
+    g_assert(!strcmp(first, expect));
+    g_assert(!strcmp(second, expect)); /* Compiled format is reusable */
+    g_assert(!strcmp(once, expect));
+    g_free(first);
+    g_free(second);
+    g_free(once);
+    Alignment_RYO_destroy(ryo);
+    return;
+    }
+/* A compiled format must print the same each time it is used,
+ * and the same as the format compiled for a single alignment.
+ */
+
+static void test_ryo_rank_pos(Alignment *alignment,
+                              Sequence *query, Sequence *target){
+    register Alignment_RYO *ryo
+        = Alignment_RYO_create("%r: %qi %r\n");
+    register GArray *rank_pos_list = g_array_new(FALSE, FALSE,
+                                                 sizeof(glong));
+    register gchar *output = test_ryo_display(ryo, alignment,
+                                              query, target,
+                                              -1, rank_pos_list);
+    g_assert(!strcmp(output, ": query \n"));
+    g_assert(rank_pos_list->len == 2);
+    g_assert(g_array_index(rank_pos_list, glong, 0) == 0);
+    g_assert(g_array_index(rank_pos_list, glong, 1) == 8);
+    g_free(output);
+    g_array_free(rank_pos_list, TRUE);
+    Alignment_RYO_destroy(ryo);
+    return;
+    }
+/* With no rank, %r prints nothing and records where the rank goes */
+
+static gboolean test_ryo_is_rejected(gchar *format){
+    register pid_t pid = fork();
+    int status;
+    g_assert(pid != -1);
+    if(!pid){
+        g_assert(freopen("/dev/null", "w", stderr));
+        Alignment_RYO_destroy(Alignment_RYO_create(format));
+        _exit(0);
+        }
+    g_assert(waitpid(pid, &status, 0) == pid);
+    return !(WIFEXITED(status) && (!WEXITSTATUS(status)));
+    }
+/* Formats are rejected with g_error(), so are compiled in a child */
+
 gint Argument_main(Argument *arg){
-    register Region *region = Region_create_blank();
+    register Region *region = Region_create(0, 0, 5, 6);
     register C4_Model *model = C4_Model_create("test");
+    register Alphabet *alphabet = Alphabet_create(Alphabet_Type_DNA,
+                                                  FALSE);
+    register Sequence *query = Sequence_create("query", NULL, "ACGTA", 0,
+                                   Sequence_Strand_FORWARD, alphabet),
+                      *target = Sequence_create("target", NULL, "ACCGTA", 0,
+                                   Sequence_Strand_FORWARD, alphabet);
     register Alignment *alignment;
-    register Match *match;
+    register C4_State *state;
+    register C4_Transition *enter, *match, *insert, *leave;
     Match_ArgumentSet_create(arg);
     Argument_process(arg, "alignment.test", NULL, NULL);
-    match = Match_find(Match_Type_DNA2DNA);
-    C4_Model_add_transition(model, "start to end",
-                            NULL, NULL, 1, 1, NULL, C4_Label_MATCH,
-                            match);
+    state = C4_Model_add_state(model, "state");
+    enter = C4_Model_add_transition(model, "enter", NULL, state, 0, 0,
+                                    NULL, C4_Label_NONE, NULL);
+    match = C4_Model_add_transition(model, "match", state, state, 1, 1,
+                                    NULL, C4_Label_MATCH,
+                                    Match_find(Match_Type_DNA2DNA));
+    insert = C4_Model_add_transition(model, "insert", state, state, 0, 1,
+                                     NULL, C4_Label_GAP, NULL);
+    leave = C4_Model_add_transition(model, "leave", state, NULL, 0, 0,
+                                    NULL, C4_Label_NONE, NULL);
     C4_Model_close(model);
-    alignment = Alignment_create(model, region, 0);
+    alignment = Alignment_create(model, region, 9);
+    Alignment_add(alignment, enter, 1);
+    Alignment_add(alignment, match, 2);
+    Alignment_add(alignment, insert, 1);
+    Alignment_add(alignment, match, 3);
+    Alignment_add(alignment, leave, 1);
     g_message("alignment test");
+    test_ryo(alignment, query, target,
+             "%qi %ti %s [%ql %tl]{ %Pn:%Pqs%Pts@%Pqb,%Ptb}\n", 1,
+             "query target 9 [5 6]"
+             " enter:--@0,0 match:AA@0,0 match:CC@1,1 insert:-C@2,2"
+             " match:GG@2,3 match:TT@3,4 match:AA@4,5 leave:--@5,6\n");
+    test_ryo(alignment, query, target, "%S\t%V\t%r\n", 2,
+             "query 0 5 + target 0 6 + 9\tM 2 2 G 0 1 M 3 3\t2\n");
+    test_ryo_rank_pos(alignment, query, target);
+    g_assert(!test_ryo_is_rejected("%qi {%Pqs} %ti\n"));
+    g_assert(test_ryo_is_rejected("%qi %Pqs\n"));
+    g_assert(test_ryo_is_rejected("%qi {%Pqs\n"));
+    g_assert(test_ryo_is_rejected("%qi %Pqs}\n"));
     Alignment_destroy(alignment);
     C4_Model_destroy(model);
     Region_destroy(region);
+    Sequence_destroy(query);
+    Sequence_destroy(target);
+    Alphabet_destroy(alphabet);
     return 0;
     }
-/* Proper testing is done with the model tests
+/* More thorough testing is done with the model tests
  */
-
@@ -0,0 +1,443 @@
+/****************************************************************\
+*                                                                *
+*  C4 dynamic programming library - binary alignment records     *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#include <string.h> /* For strlen(), memcpy() */
+
+#include "alignmentrecord.h"
+#include "c4.h"
+
+#define AlignmentRecord_MAGIC "EXB1"
+
+AlignmentRecord *AlignmentRecord_create(void){
+    register AlignmentRecord *ar = g_new0(AlignmentRecord, 1);
+    ar->run_list = g_array_new(FALSE, FALSE, sizeof(AlignmentRecord_Run));
+    return ar;
+    }
+
+void AlignmentRecord_destroy(AlignmentRecord *ar){
+    g_free(ar->query_id);
+    g_free(ar->target_id);
+    g_array_free(ar->run_list, TRUE);
+    g_free(ar->buffer);
+    g_free(ar);
+    return;
+    }
+
+void AlignmentRecord_set(AlignmentRecord *ar,
+                         gchar *query_id, gint query_start, gint query_end,
+                         gchar query_strand,
+                         gchar *target_id, gint target_start, gint target_end,
+                         gchar target_strand, gint score){
+    g_free(ar->query_id);
+    g_free(ar->target_id);
+    ar->query_id = g_strdup(query_id);
+    ar->query_start = query_start;
+    ar->query_end = query_end;
+    ar->query_strand = query_strand;
+    ar->target_id = g_strdup(target_id);
+    ar->target_start = target_start;
+    ar->target_end = target_end;
+    ar->target_strand = target_strand;
+    ar->score = score;
+    g_array_set_size(ar->run_list, 0);
+    return;
+    }
+
+void AlignmentRecord_add_run(AlignmentRecord *ar, gint label,
+                             gint advance_query, gint advance_target,
+                             gint length){
+    register AlignmentRecord_Run *last;
+    AlignmentRecord_Run run;
+    if(ar->run_list->len){
+        last = &g_array_index(ar->run_list, AlignmentRecord_Run,
+                              ar->run_list->len-1);
+        if((last->label == label)
+        && (last->advance_query == advance_query)
+        && (last->advance_target == advance_target)){
+            last->length += length;
+            return;
+            }
+        }
+    run.label = label;
+    run.advance_query = advance_query;
+    run.advance_target = advance_target;
+    run.length = length;
+    g_array_append_val(ar->run_list, run);
+    return;
+    }
+/* Merging runs with the same transition type does not change
+ * the sugar, cigar or vulgar output
+ */
+
+/**/
+
+static guchar *AlignmentRecord_put_8(guchar *p, guint value){
+    p[0] = value & 0xff;
+    return p+1;
+    }
+
+static guchar *AlignmentRecord_put_16(guchar *p, guint value){
+    p[0] = (value >> 8) & 0xff;
+    p[1] = value & 0xff;
+    return p+2;
+    }
+
+static guchar *AlignmentRecord_put_32(guchar *p, guint32 value){
+    p[0] = (value >> 24) & 0xff;
+    p[1] = (value >> 16) & 0xff;
+    p[2] = (value >> 8) & 0xff;
+    p[3] = value & 0xff;
+    return p+4;
+    }
+
+static guint AlignmentRecord_get_8(guchar **p){
+    register guint value = (*p)[0];
+    (*p) += 1;
+    return value;
+    }
+
+static guint AlignmentRecord_get_16(guchar **p){
+    register guint value = ((*p)[0] << 8) | (*p)[1];
+    (*p) += 2;
+    return value;
+    }
+
+static guint32 AlignmentRecord_get_32(guchar **p){
+    register guint32 value = ((guint32)(*p)[0] << 24)
+                           | ((guint32)(*p)[1] << 16)
+                           | ((guint32)(*p)[2] << 8)
+                           |  (guint32)(*p)[3];
+    (*p) += 4;
+    return value;
+    }
+
+static void AlignmentRecord_reserve(AlignmentRecord *ar, gint length){
+    if(ar->buffer_alloc < length){
+        ar->buffer_alloc = MAX(length, ar->buffer_alloc << 1);
+        ar->buffer = g_realloc(ar->buffer, ar->buffer_alloc);
+        }
+    return;
+    }
+
+/**/
+
+void AlignmentRecord_write_header(FILE *fp){
+    if(fwrite(AlignmentRecord_MAGIC, sizeof(gchar), 4, fp) != 4)
+        g_error("Could not write binary alignment header");
+    return;
+    }
+
+gboolean AlignmentRecord_read_header(FILE *fp){
+    gchar magic[4];
+    if(fread(magic, sizeof(gchar), 4, fp) != 4)
+        return FALSE;
+    return memcmp(magic, AlignmentRecord_MAGIC, 4)?FALSE:TRUE;
+    }
+
+void AlignmentRecord_write(AlignmentRecord *ar, FILE *fp){
+    register gint i;
+    register gint query_id_len = strlen(ar->query_id),
+                  target_id_len = strlen(ar->target_id);
+    register gint length = (4 * 5) + 2
+                         + 2 + query_id_len + 2 + target_id_len
+                         + 4 + (ar->run_list->len * 7);
+    register guchar *p;
+    register AlignmentRecord_Run *run;
+    g_assert(ar->run_list->len);
+    if((query_id_len >> 16) || (target_id_len >> 16))
+        g_error("Sequence id too long for binary alignment output");
+    AlignmentRecord_reserve(ar, length + 4);
+    p = ar->buffer;
+    p = AlignmentRecord_put_32(p, length);
+    p = AlignmentRecord_put_32(p, ar->score);
+    p = AlignmentRecord_put_32(p, ar->query_start);
+    p = AlignmentRecord_put_32(p, ar->query_end);
+    p = AlignmentRecord_put_32(p, ar->target_start);
+    p = AlignmentRecord_put_32(p, ar->target_end);
+    p = AlignmentRecord_put_8(p, ar->query_strand);
+    p = AlignmentRecord_put_8(p, ar->target_strand);
+    p = AlignmentRecord_put_16(p, query_id_len);
+    memcpy(p, ar->query_id, query_id_len);
+    p += query_id_len;
+    p = AlignmentRecord_put_16(p, target_id_len);
+    memcpy(p, ar->target_id, target_id_len);
+    p += target_id_len;
+    p = AlignmentRecord_put_32(p, ar->run_list->len);
+    for(i = 0; i < ar->run_list->len; i++){
+        run = &g_array_index(ar->run_list, AlignmentRecord_Run, i);
+        p = AlignmentRecord_put_8(p, run->label);
+        p = AlignmentRecord_put_8(p, run->advance_query);
+        p = AlignmentRecord_put_8(p, run->advance_target);
+        p = AlignmentRecord_put_32(p, run->length);
+        }
+    g_assert((p - ar->buffer) == (length + 4));
+    if(fwrite(ar->buffer, sizeof(guchar), length + 4, fp) != (length + 4))
+        g_error("Could not write binary alignment record");
+    return;
+    }
+
+gboolean AlignmentRecord_read(AlignmentRecord *ar, FILE *fp){
+    register guint32 length;
+    register gint i, id_len, run_total;
+    register guchar *end;
+    guchar *p, prefix[4];
+    AlignmentRecord_Run run;
+    if(fread(prefix, sizeof(guchar), 4, fp) != 4)
+        return FALSE;
+    p = prefix;
+    length = AlignmentRecord_get_32(&p);
+    if(length < ((4 * 5) + 2 + 2 + 2 + 4))
+        g_error("Bad binary alignment record length [%u]", length);
+    AlignmentRecord_reserve(ar, length);
+    if(fread(ar->buffer, sizeof(guchar), length, fp) != length)
+        g_error("Truncated binary alignment record");
+    p = ar->buffer;
+    end = ar->buffer + length;
+    ar->score = (gint32)AlignmentRecord_get_32(&p);
+    ar->query_start = (gint32)AlignmentRecord_get_32(&p);
+    ar->query_end = (gint32)AlignmentRecord_get_32(&p);
+    ar->target_start = (gint32)AlignmentRecord_get_32(&p);
+    ar->target_end = (gint32)AlignmentRecord_get_32(&p);
+    ar->query_strand = AlignmentRecord_get_8(&p);
+    ar->target_strand = AlignmentRecord_get_8(&p);
+    id_len = AlignmentRecord_get_16(&p);
+    if((p + id_len + 2) > end)
+        g_error("Bad query id in binary alignment record");
+    g_free(ar->query_id);
+    ar->query_id = g_strndup((gchar*)p, id_len);
+    p += id_len;
+    id_len = AlignmentRecord_get_16(&p);
+    if((p + id_len + 4) > end)
+        g_error("Bad target id in binary alignment record");
+    g_free(ar->target_id);
+    ar->target_id = g_strndup((gchar*)p, id_len);
+    p += id_len;
+    run_total = AlignmentRecord_get_32(&p);
+    if(run_total < 1)
+        g_error("Empty run list in binary alignment record");
+    if((end - p) != ((gint64)run_total * 7))
+        g_error("Bad run list in binary alignment record");
+    g_array_set_size(ar->run_list, 0);
+    for(i = 0; i < run_total; i++){
+        run.label = AlignmentRecord_get_8(&p);
+        run.advance_query = AlignmentRecord_get_8(&p);
+        run.advance_target = AlignmentRecord_get_8(&p);
+        run.length = AlignmentRecord_get_32(&p);
+        g_array_append_val(ar->run_list, run);
+        }
+    return TRUE;
+    }
+
+/**/
+
+void AlignmentRecord_print_sugar(gchar *query_id,
+                     gint query_start, gint query_end, gchar query_strand,
+                     gchar *target_id,
+                     gint target_start, gint target_end, gchar target_strand,
+                     gint score, FILE *fp){
+    fprintf(fp, "%s %d %d %c %s %d %d %c %d",
+             query_id, query_start, query_end, query_strand,
+             target_id, target_start, target_end, target_strand, score);
+    return;
+    }
+
+static gchar AlignmentRecord_get_cigar_type(AlignmentRecord_Run *run,
+                                            gint *move){
+    if(!run->advance_query){
+        (*move) = run->advance_target * run->length;
+        return 'D';
+        }
+    if(!run->advance_target){
+        (*move) = run->advance_query * run->length;
+        return 'I';
+        }
+    (*move) = MAX(run->advance_query, run->advance_target) * run->length;
+    return 'M';
+    }
+
+void AlignmentRecord_print_cigar(gint run_total,
+                                 AlignmentRecord_GetRunFunc get_run_func,
+                                 gpointer run_data, FILE *fp){
+    register gint i;
+    register gchar *gap = "";
+    register gchar type, next_type;
+    AlignmentRecord_Run run;
+    gint move, next_move;
+    if(!run_total)
+        return;
+    get_run_func(run_data, 0, &run);
+    type = AlignmentRecord_get_cigar_type(&run, &move);
+    for(i = 1; i < run_total; i++){
+        get_run_func(run_data, i, &run);
+        next_type = AlignmentRecord_get_cigar_type(&run, &next_move);
+        if(type == next_type){
+            move += next_move;
+        } else {
+            if(move)
+                fprintf(fp, "%s%c %d", gap, type, move);
+            move = next_move;
+            type = next_type;
+            gap = " ";
+            }
+        }
+    if(move)
+        fprintf(fp, "%s%c %d", gap, type, move);
+    return;
+    }
+
+void AlignmentRecord_print_vulgar(gint run_total,
+                                  AlignmentRecord_GetRunFunc get_run_func,
+                                  gpointer run_data, FILE *fp){
+    register gint i;
+    register gchar *gap = "";
+    register C4_Label curr_label;
+    register gint curr_advance_query, curr_advance_target;
+    register gboolean curr_is_codon = FALSE;
+    AlignmentRecord_Run run;
+    if(!run_total)
+        return;
+    get_run_func(run_data, 0, &run);
+    curr_label = run.label;
+    curr_advance_query = (run.advance_query * run.length);
+    curr_advance_target = (run.advance_target * run.length);
+    for(i = 1; i < run_total; i++){
+        get_run_func(run_data, i, &run);
+        if((run.label == curr_label)
+         && (curr_advance_query || (!run.advance_query))
+         && (curr_advance_target || (!run.advance_target))
+         && (curr_is_codon == ((run.advance_query == 3)
+                               && (run.advance_target == 3)))){
+            curr_advance_query += (run.advance_query * run.length);
+            curr_advance_target += (run.advance_target * run.length);
+        } else {
+            switch(curr_label){
+                case C4_Label_NONE:
+                    break;
+                case C4_Label_MATCH:
+                    g_assert(curr_advance_query && curr_advance_target);
+                    fprintf(fp, "%s%c %d %d", gap, curr_is_codon?'C':'M',
+                                              curr_advance_query,
+                                              curr_advance_target);
+                    gap = " ";
+                    break;
+                case C4_Label_GAP:
+                    g_assert(curr_advance_query || curr_advance_target);
+                    g_assert(!  (curr_advance_query
+                              && curr_advance_target));
+                    fprintf(fp, "%sG %d %d", gap, curr_advance_query,
+                                                  curr_advance_target);
+                    gap = " ";
+                    break;
+                case C4_Label_NER:
+                    fprintf(fp, "%sN %d %d", gap, curr_advance_query,
+                                                  curr_advance_target);
+                    gap = " ";
+                    break;
+                case C4_Label_5SS:
+                    fprintf(fp, "%s5 %d %d", gap, curr_advance_query,
+                                                  curr_advance_target);
+                    gap = " ";
+                    break;
+                case C4_Label_3SS:
+                    fprintf(fp, "%s3 %d %d", gap, curr_advance_query,
+                                                  curr_advance_target);
+                    gap = " ";
+                    break;
+                case C4_Label_INTRON:
+                    fprintf(fp, "%sI %d %d", gap, curr_advance_query,
+                                                  curr_advance_target);
+                    gap = " ";
+                    break;
+                case C4_Label_SPLIT_CODON:
+                    fprintf(fp, "%sS %d %d", gap, curr_advance_query,
+                                                  curr_advance_target);
+                    gap = " ";
+                    break;
+                case C4_Label_FRAMESHIFT:
+                    fprintf(fp, "%sF %d %d", gap, curr_advance_query,
+                                                   curr_advance_target);
+                    gap = " ";
+                    break;
+                default:
+                    g_error("Unknown C4_Label [%d]", curr_label);
+                    break;
+                }
+            curr_label = run.label;
+            curr_is_codon = ((run.advance_query == 3)
+                          && (run.advance_target == 3));
+            curr_advance_query = (run.advance_query * run.length);
+            curr_advance_target = (run.advance_target * run.length);
+            }
+        }
+    return;
+    }
+
+/**/
+
+static void AlignmentRecord_get_run(gpointer run_data, gint pos,
+                                    AlignmentRecord_Run *run){
+    register GArray *run_list = run_data;
+    (*run) = g_array_index(run_list, AlignmentRecord_Run, pos);
+    return;
+    }
+
+void AlignmentRecord_print_sugar_block(AlignmentRecord *ar, FILE *fp){
+    AlignmentRecord_print_sugar(ar->query_id, ar->query_start,
+                                ar->query_end, ar->query_strand,
+                                ar->target_id, ar->target_start,
+                                ar->target_end, ar->target_strand,
+                                ar->score, fp);
+    return;
+    }
+
+void AlignmentRecord_print_cigar_block(AlignmentRecord *ar, FILE *fp){
+    AlignmentRecord_print_cigar(ar->run_list->len, AlignmentRecord_get_run,
+                                ar->run_list, fp);
+    return;
+    }
+
+void AlignmentRecord_print_vulgar_block(AlignmentRecord *ar, FILE *fp){
+    AlignmentRecord_print_vulgar(ar->run_list->len, AlignmentRecord_get_run,
+                                 ar->run_list, fp);
+    return;
+    }
+
+/**/
+
+void AlignmentRecord_display_sugar(AlignmentRecord *ar, FILE *fp){
+    fprintf(fp, "sugar: ");
+    AlignmentRecord_print_sugar_block(ar, fp);
+    fprintf(fp, "\n");
+    return;
+    }
+
+void AlignmentRecord_display_cigar(AlignmentRecord *ar, FILE *fp){
+    fprintf(fp, "cigar: ");
+    AlignmentRecord_print_sugar_block(ar, fp);
+    fprintf(fp, " ");
+    AlignmentRecord_print_cigar_block(ar, fp);
+    fprintf(fp, "\n");
+    return;
+    }
+
+void AlignmentRecord_display_vulgar(AlignmentRecord *ar, FILE *fp){
+    fprintf(fp, "vulgar: ");
+    AlignmentRecord_print_sugar_block(ar, fp);
+    fprintf(fp, " ");
+    AlignmentRecord_print_vulgar_block(ar, fp);
+    fprintf(fp, "\n");
+    return;
+    }
+
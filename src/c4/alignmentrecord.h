@@ -0,0 +1,112 @@
+/****************************************************************\
+*                                                                *
+*  C4 dynamic programming library - binary alignment records     *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#ifndef INCLUDED_ALIGNMENTRECORD_H
+#define INCLUDED_ALIGNMENTRECORD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdio.h>
+#include <glib.h>
+
+typedef struct {
+    gint label; /* C4_Label */
+    gint advance_query;
+    gint advance_target;
+    gint length;
+} AlignmentRecord_Run;
+
+typedef struct {
+     gchar *query_id;
+      gint  query_start;
+      gint  query_end;
+     gchar  query_strand;
+     gchar *target_id;
+      gint  target_start;
+      gint  target_end;
+     gchar  target_strand;
+      gint  score;
+    GArray *run_list; /* Contains AlignmentRecord_Run */
+    guchar *buffer;
+      gint  buffer_alloc;
+} AlignmentRecord;
+/* The run list holds the alignment operations,
+ * with adjacent operations of the same type merged.
+ */
+
+AlignmentRecord *AlignmentRecord_create(void);
+           void  AlignmentRecord_destroy(AlignmentRecord *ar);
+           void  AlignmentRecord_set(AlignmentRecord *ar,
+                     gchar *query_id, gint query_start, gint query_end,
+                     gchar query_strand,
+                     gchar *target_id, gint target_start, gint target_end,
+                     gchar target_strand, gint score);
+           void  AlignmentRecord_add_run(AlignmentRecord *ar, gint label,
+                     gint advance_query, gint advance_target,
+                     gint length);
+
+    void AlignmentRecord_write_header(FILE *fp);
+gboolean AlignmentRecord_read_header(FILE *fp);
+    void AlignmentRecord_write(AlignmentRecord *ar, FILE *fp);
+gboolean AlignmentRecord_read(AlignmentRecord *ar, FILE *fp);
+/* A binary stream is a header followed by one record per alignment:
+ *
+ * "EXB1"
+ * <record length> <score>
+ * <query start> <query end> <target start> <target end>
+ * <query strand> <target strand>
+ * <query id length> <query id> <target id length> <target id>
+ * <run total> { <label> <advance query> <advance target> <length> }
+ *
+ * Integers are big-endian: 32 bits, except for the strands
+ * and the run label and advances (8 bits) and the id lengths (16 bits).
+ * AlignmentRecord_read() returns FALSE at the end of the stream.
+ */
+
+typedef void (*AlignmentRecord_GetRunFunc)(gpointer run_data, gint pos,
+                                           AlignmentRecord_Run *run);
+
+void AlignmentRecord_print_sugar(gchar *query_id,
+                     gint query_start, gint query_end, gchar query_strand,
+                     gchar *target_id,
+                     gint target_start, gint target_end, gchar target_strand,
+                     gint score, FILE *fp);
+void AlignmentRecord_print_cigar(gint run_total,
+                                 AlignmentRecord_GetRunFunc get_run_func,
+                                 gpointer run_data, FILE *fp);
+void AlignmentRecord_print_vulgar(gint run_total,
+                                  AlignmentRecord_GetRunFunc get_run_func,
+                                  gpointer run_data, FILE *fp);
+/* The sugar, cigar and vulgar writers for both records and Alignments:
+ * get_run_func fills in each run, so an Alignment can be printed
+ * from its operation list without building a record.
+ */
+
+void AlignmentRecord_print_sugar_block(AlignmentRecord *ar, FILE *fp);
+void AlignmentRecord_print_cigar_block(AlignmentRecord *ar, FILE *fp);
+void AlignmentRecord_print_vulgar_block(AlignmentRecord *ar, FILE *fp);
+
+void AlignmentRecord_display_sugar(AlignmentRecord *ar, FILE *fp);
+void AlignmentRecord_display_cigar(AlignmentRecord *ar, FILE *fp);
+void AlignmentRecord_display_vulgar(AlignmentRecord *ar, FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* INCLUDED_ALIGNMENTRECORD_H */
+
@@ -0,0 +1,86 @@
+/****************************************************************\
+*                                                                *
+*  C4 dynamic programming library - binary alignment records     *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#include <string.h> /* For strcmp() */
+
+#include "alignmentrecord.h"
+#include "c4.h"
+
+static void test_compare_record(AlignmentRecord *a, AlignmentRecord *b){
+    register gint i;
+    register AlignmentRecord_Run *run_a, *run_b;
+    g_assert(!strcmp(a->query_id, b->query_id));
+    g_assert(!strcmp(a->target_id, b->target_id));
+    g_assert(a->query_start == b->query_start);
+    g_assert(a->query_end == b->query_end);
+    g_assert(a->query_strand == b->query_strand);
+    g_assert(a->target_start == b->target_start);
+    g_assert(a->target_end == b->target_end);
+    g_assert(a->target_strand == b->target_strand);
+    g_assert(a->score == b->score);
+    g_assert(a->run_list->len == b->run_list->len);
+    for(i = 0; i < a->run_list->len; i++){
+        run_a = &g_array_index(a->run_list, AlignmentRecord_Run, i);
+        run_b = &g_array_index(b->run_list, AlignmentRecord_Run, i);
+        g_assert(run_a->label == run_b->label);
+        g_assert(run_a->advance_query == run_b->advance_query);
+        g_assert(run_a->advance_target == run_b->advance_target);
+        g_assert(run_a->length == run_b->length);
+        }
+    return;
+    }
+
+int main(void){
+    register AlignmentRecord *ar = AlignmentRecord_create(),
+                             *copy = AlignmentRecord_create();
+    register FILE *fp = tmpfile();
+    AlignmentRecord_set(ar, "query", 0, 120, '+',
+                            "target", 1000, 6040, '-', 512);
+    AlignmentRecord_add_run(ar, C4_Label_MATCH, 1, 1, 30);
+    AlignmentRecord_add_run(ar, C4_Label_MATCH, 1, 1, 20);
+    AlignmentRecord_add_run(ar, C4_Label_5SS, 0, 2, 1);
+    AlignmentRecord_add_run(ar, C4_Label_INTRON, 0, 1, 4916);
+    AlignmentRecord_add_run(ar, C4_Label_3SS, 0, 2, 1);
+    AlignmentRecord_add_run(ar, C4_Label_MATCH, 1, 1, 68);
+    AlignmentRecord_add_run(ar, C4_Label_GAP, 1, 0, 2);
+    AlignmentRecord_add_run(ar, C4_Label_NONE, 0, 0, 1);
+    g_assert(ar->run_list->len == 7); /* First two runs are merged */
+    AlignmentRecord_display_vulgar(ar, stdout);
+    AlignmentRecord_display_cigar(ar, stdout);
+    /**/
+    g_assert(fp);
+    AlignmentRecord_write_header(fp);
+    AlignmentRecord_write(ar, fp);
+    AlignmentRecord_write(ar, fp);
+    rewind(fp);
+    g_assert(AlignmentRecord_read_header(fp));
+    g_assert(AlignmentRecord_read(copy, fp));
+    test_compare_record(ar, copy);
+    g_assert(AlignmentRecord_read(copy, fp));
+    test_compare_record(ar, copy);
+    g_assert(!AlignmentRecord_read(copy, fp));
+    AlignmentRecord_display_vulgar(copy, stdout);
+    /* Printing an empty run list writes nothing */
+    rewind(fp);
+    g_array_set_size(copy->run_list, 0);
+    AlignmentRecord_print_cigar_block(copy, fp);
+    AlignmentRecord_print_vulgar_block(copy, fp);
+    g_assert(!ftell(fp));
+    fclose(fp);
+    AlignmentRecord_destroy(ar);
+    AlignmentRecord_destroy(copy);
+    return 0;
+    }
+
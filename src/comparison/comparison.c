@@ -144,6 +144,15 @@ Comparison *Comparison_create(Comparison_Param *param,
                                              param->codon_hsp_param)
                              : NULL;
     ThreadRef_unlock(comparison->param->thread_ref);
+    if(param->dna_hsp_param)
+        Match_set_codon_profiles(param->dna_hsp_param->match,
+                                 query, target);
+    if(param->protein_hsp_param)
+        Match_set_codon_profiles(param->protein_hsp_param->match,
+                                 query, target);
+    if(param->codon_hsp_param)
+        Match_set_codon_profiles(param->codon_hsp_param->match,
+                                 query, target);
     return comparison;
     }
 
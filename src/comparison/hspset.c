@@ -15,10 +15,10 @@
 
 #include <string.h> /* For strlen()  */
 #include <ctype.h>  /* For tolower() */
-#include <stdlib.h> /* For qsort()   */
 
 #include "exonerate_util.h"
 #include "hspset.h"
+#include "radixsort.h"
 
 HSPset_ArgumentSet *HSPset_ArgumentSet_create(Argument *arg){
     register ArgumentSet *as;
@@ -34,6 +34,9 @@ HSPset_ArgumentSet *HSPset_ArgumentSet_create(Argument *arg){
         ArgumentSet_add_option(as, '\0', "seedrepeat", NULL,
                 "Seeds per diagonal required for HSP seeding", "1",
                 Argument_parse_int, &has.seed_repeat);
+        ArgumentSet_add_option(as, '\0', "twohitwindow", NULL,
+                "Diagonal window for two-hit HSP seeding (0 for off)", "0",
+                Argument_parse_int, &has.two_hit_window);
         /**/
         ArgumentSet_add_option(as, 0, "dnawordlen", "bp",
             "Wordlength for DNA words", "12",
@@ -116,6 +119,17 @@ void HSP_Param_set_wordlen(HSP_Param *hsp_param, gint wordlen){
     return;
     }
 
+void HSP_Param_set_seedlen(HSP_Param *hsp_param, gint seedlen){
+    if((seedlen <= 0) || (seedlen > hsp_param->seedlen))
+        g_error("Seed length [%d] must be between 1 and [%d]",
+                seedlen, hsp_param->seedlen);
+    hsp_param->seedlen = seedlen;
+    return;
+    }
+/* Used with spaced seeds, where only part of the word
+ * is known to be a contiguous match.
+ */
+
 /**/
 
 void HSP_Param_set_dna_hsp_threshold(HSP_Param *hsp_param,
@@ -235,12 +249,21 @@ void HSP_Param_set_seed_repeat(HSP_Param *hsp_param,
     return;
     }
 
+void HSP_Param_set_two_hit_window(HSP_Param *hsp_param,
+                                  gint two_hit_window){
+    if(two_hit_window < 0)
+        g_error("Two-hit window cannot be negative");
+    hsp_param->two_hit_window = two_hit_window;
+    return;
+    }
+
 HSP_Param *HSP_Param_create(Match *match, gboolean use_horizon){
     register HSP_Param *hsp_param = g_new(HSP_Param, 1);
     hsp_param->thread_ref = ThreadRef_create();
     hsp_param->has = HSPset_ArgumentSet_create(NULL);
     hsp_param->match = match;
     hsp_param->seed_repeat = hsp_param->has->seed_repeat;
+    HSP_Param_set_two_hit_window(hsp_param, hsp_param->has->two_hit_window);
     switch(match->type){
         case Match_Type_DNA2DNA:
             hsp_param->dropoff = hsp_param->has->dna_hsp_dropoff;
@@ -269,10 +292,6 @@ HSP_Param *HSP_Param_create(Match *match, gboolean use_horizon){
             break;
         }
     hsp_param->use_horizon = use_horizon;
-#ifdef USE_PTHREADS
-    pthread_mutex_init(&hsp_param->hsp_recycle_lock, NULL);
-#endif /* USE_PTHREADS */
-    hsp_param->hsp_recycle = RecycleBin_create("HSP", sizeof(HSP), 64);
     hsp_param->wordhood = NULL;
     HSP_Param_refresh_wordhood(hsp_param);
     return hsp_param;
@@ -284,14 +303,6 @@ void HSP_Param_destroy(HSP_Param *hsp_param){
         return;
     if(hsp_param->wordhood)
         WordHood_destroy(hsp_param->wordhood);
-#ifdef USE_PTHREADS
-    pthread_mutex_lock(&hsp_param->hsp_recycle_lock);
-#endif /* USE_PTHREADS */
-    RecycleBin_destroy(hsp_param->hsp_recycle);
-#ifdef USE_PTHREADS
-    pthread_mutex_unlock(&hsp_param->hsp_recycle_lock);
-    pthread_mutex_destroy(&hsp_param->hsp_recycle_lock);
-#endif /* USE_PTHREADS */
     g_free(hsp_param);
     return;
     }
@@ -320,7 +331,9 @@ HSPset *HSPset_create(Sequence *query, Sequence *target,
     /**/
     if(hsp_param->use_horizon){
         hsp_set->horizon = (gint****)Matrix4d_create(
-                                   1 + ((hsp_param->seed_repeat > 1)?2:0),
+                                   1 + (((hsp_param->seed_repeat > 1)
+                                       || hsp_param->two_hit_window)?2:0)
+                                     + (hsp_param->two_hit_window?1:0),
                                    query->len,
                                    hsp_param->match->query->advance,
                                    hsp_param->match->target->advance,
@@ -329,6 +342,9 @@ HSPset *HSPset_create(Sequence *query, Sequence *target,
         hsp_set->horizon = NULL;
         }
     hsp_set->hsp_list = g_ptr_array_new();
+    hsp_set->hsp_block_list = g_ptr_array_new();
+    hsp_set->hsp_block_pos = 0;
+    hsp_set->hsp_recycle = NULL;
     hsp_set->is_finalised = FALSE;
     hsp_set->param->has = HSPset_ArgumentSet_create(NULL);
     if(hsp_set->param->has->filter_threshold){
@@ -341,7 +357,7 @@ HSPset *HSPset_create(Sequence *query, Sequence *target,
     hsp_set->is_empty = TRUE;
     return hsp_set;
     }
-/* horizon[score(,repeat_count,diag)]
+/* horizon[score(,repeat_count,diag(,last_hit))]
  *        [query_len]
  *        [query_advance]
  *        [target_advance]
@@ -357,7 +373,6 @@ HSPset *HSPset_share(HSPset *hsp_set){
 
 void HSPset_destroy(HSPset *hsp_set){
     register gint i;
-    register HSP *hsp;
     g_assert(hsp_set);
     if(--hsp_set->ref_count)
         return;
@@ -368,10 +383,10 @@ void HSPset_destroy(HSPset *hsp_set){
         PQueueSet_destroy(hsp_set->pqueue_set);
     Sequence_destroy(hsp_set->query);
     Sequence_destroy(hsp_set->target);
-    for(i = 0; i < hsp_set->hsp_list->len; i++){
-        hsp = hsp_set->hsp_list->pdata[i];
-        HSP_destroy(hsp);
-        }
+    /* HSPs are freed with their blocks */
+    for(i = 0; i < hsp_set->hsp_block_list->len; i++)
+        g_free(hsp_set->hsp_block_list->pdata[i]);
+    g_ptr_array_free(hsp_set->hsp_block_list, TRUE);
     g_ptr_array_free(hsp_set->hsp_list, TRUE);
     if(hsp_set->horizon)
         g_free(hsp_set->horizon);
@@ -397,6 +412,8 @@ void HSPset_swap(HSPset *hsp_set, HSP_Param *hsp_param){
         query_start = hsp->query_start;
         hsp->query_start = hsp->target_start;
         hsp->target_start = query_start;
+        hsp->query_advance = hsp_param->match->query->advance;
+        hsp->target_advance = hsp_param->match->target->advance;
         }
     return;
     }
@@ -745,10 +762,161 @@ static void HSP_init(HSP *nh){
     return;
     }
 
+#define HSP_EXTEND_BLOCK_SIZE 64
+
+static Submat *HSP_get_extend_submat(HSPset *hsp_set){
+    register Match *match = hsp_set->param->match;
+    switch(match->type){
+        case Match_Type_DNA2DNA:
+            if(hsp_set->query->annotation) /* May be scored as CDS */
+                return NULL;
+            return match->mas->dna_submat;
+        case Match_Type_PROTEIN2PROTEIN:
+            return match->mas->protein_submat;
+        default:
+            break;
+        }
+    return NULL;
+    }
+/* Returns the Submat used to score the HSPset positions directly,
+ * or NULL if the generic score_func path must be used.
+ */
+
+static gint HSP_extend_fill_block(HSPset *hsp_set, Submat *submat,
+                                  gint query_pos, gint target_pos,
+                                  gint length, gboolean reverse,
+                                  gboolean forbid_masked,
+                                  Match_Score *score_block){
+    register gint i, j;
+    register gchar swap;
+    register guchar *index = submat->index;
+    gchar query_buf[HSP_EXTEND_BLOCK_SIZE],
+          target_buf[HSP_EXTEND_BLOCK_SIZE];
+    g_assert(length <= HSP_EXTEND_BLOCK_SIZE);
+    if(reverse){
+        Sequence_strncpy(hsp_set->query, query_pos-length+1, length,
+                         query_buf);
+        Sequence_strncpy(hsp_set->target, target_pos-length+1, length,
+                         target_buf);
+        for(i = 0, j = length-1; i < j; i++, j--){
+            swap = query_buf[i];
+            query_buf[i] = query_buf[j];
+            query_buf[j] = swap;
+            swap = target_buf[i];
+            target_buf[i] = target_buf[j];
+            target_buf[j] = swap;
+            }
+    } else {
+        Sequence_strncpy(hsp_set->query, query_pos, length, query_buf);
+        Sequence_strncpy(hsp_set->target, target_pos, length,
+                         target_buf);
+        }
+    if(forbid_masked){
+        for(i = 0; i < length; i++)
+            if(Alphabet_is_masked(hsp_set->query->alphabet,
+                                  (guchar)query_buf[i])
+            || Alphabet_is_masked(hsp_set->target->alphabet,
+                                  (guchar)target_buf[i]))
+                break;
+        length = i;
+        }
+    for(i = 0; i < length; i++)
+        score_block[i] = submat->matrix[index[(guchar)query_buf[i]]]
+                                       [index[(guchar)target_buf[i]]];
+    return length;
+    }
+/* Fills score_block with the scores for up to length positions
+ * moving away from (query_pos,target_pos), and returns the number
+ * filled, which is shorter than length if a masked position is found.
+ * The scoring loop runs over flat buffers without function calls,
+ * so can be vectorised by the compiler.
+ */
+
+static gint HSP_extend_fast_direction(HSP *nh, Submat *submat,
+                                      gint query_pos, gint target_pos,
+                                      gint available, gboolean reverse,
+                                      gboolean forbid_masked,
+                                      Match_Score *maxscore){
+    register gint i, length, filled, extend = 0, maxext = 0;
+    register Match_Score score = *maxscore;
+    register Match_Score dropoff = nh->hsp_set->param->dropoff;
+    Match_Score score_block[HSP_EXTEND_BLOCK_SIZE];
+    while(available > 0){
+        length = MIN(available, HSP_EXTEND_BLOCK_SIZE);
+        filled = HSP_extend_fill_block(nh->hsp_set, submat,
+                                       query_pos, target_pos, length,
+                                       reverse, forbid_masked,
+                                       score_block);
+        for(i = 0; i < filled; i++){
+            extend++;
+            score += score_block[i];
+            if((*maxscore) <= score){
+                (*maxscore) = score;
+                maxext = extend;
+            } else {
+                if(score < 0) /* See note below HSP_extend() */
+                    return maxext;
+                if(((*maxscore)-score) >= dropoff)
+                    return maxext;
+                }
+            }
+        if(filled < length) /* Stopped by masking */
+            break;
+        available -= length;
+        if(reverse){
+            query_pos -= length;
+            target_pos -= length;
+        } else {
+            query_pos += length;
+            target_pos += length;
+            }
+        }
+    return maxext;
+    }
+
+static void HSP_extend_fast(HSP *nh, Submat *submat,
+                            gboolean forbid_masked){
+    register gint maxext;
+    Match_Score maxscore;
+    g_assert(HSP_check(nh));
+    g_assert(HSP_query_advance(nh) == 1);
+    g_assert(HSP_target_advance(nh) == 1);
+    /* extend left */
+    maxscore = nh->score;
+    maxext = HSP_extend_fast_direction(nh, submat,
+                 nh->query_start-1, nh->target_start-1,
+                 MIN(nh->query_start, nh->target_start),
+                 TRUE, forbid_masked, &maxscore);
+    nh->query_start -= maxext;
+    nh->target_start -= maxext;
+    nh->length += maxext;
+    /* extend right */
+    maxext = HSP_extend_fast_direction(nh, submat,
+                 HSP_query_end(nh), HSP_target_end(nh),
+                 MIN(nh->hsp_set->query->len - HSP_query_end(nh),
+                     nh->hsp_set->target->len - HSP_target_end(nh)),
+                 FALSE, forbid_masked, &maxscore);
+    nh->score = maxscore;
+    nh->length += maxext;
+    g_assert(HSP_check(nh));
+    return;
+    }
+/* Equivalent to HSP_extend() for matches where both strands
+ * advance by 1 and the score is a plain Submat lookup.
+ * The sequences are decoded in blocks into local buffers,
+ * rather than calling get_symbol, mask_func and score_func
+ * for every position.
+ */
+
 static void HSP_extend(HSP *nh, gboolean forbid_masked){
     register Match_Score score, maxscore;
     register gint query_pos, target_pos;
     register gint extend, maxext;
+    register Submat *submat = HSP_get_extend_submat(nh->hsp_set);
+    if(submat){
+        HSP_extend_fast(nh, submat, forbid_masked);
+        return;
+        }
     g_assert(HSP_check(nh));
     /* extend left */
     maxscore = score = nh->score;
@@ -817,35 +985,60 @@ static void HSP_extend(HSP *nh, gboolean forbid_masked){
  * as this can result in overlapping HSPs in some circumstances.
  */
 
+#define HSPset_HSP_BLOCK_MIN_SIZE 16
+#define HSPset_HSP_BLOCK_MAX_SIZE 4096
+
+static gint HSPset_hsp_block_size(gint block_id){
+    register gint size = HSPset_HSP_BLOCK_MIN_SIZE << block_id;
+    if((block_id >= 8) || (size > HSPset_HSP_BLOCK_MAX_SIZE))
+        return HSPset_HSP_BLOCK_MAX_SIZE;
+    return size;
+    }
+/* Blocks double in size up to HSPset_HSP_BLOCK_MAX_SIZE,
+ * so small HSPsets stay small.
+ */
+
 static HSP *HSP_create(HSP *nh){
+    register HSPset *hsp_set = nh->hsp_set;
     register HSP *hsp;
-#ifdef USE_PTHREADS
-    pthread_mutex_lock(&nh->hsp_set->param->hsp_recycle_lock);
-#endif /* USE_PTHREADS */
-    hsp = RecycleBin_alloc(nh->hsp_set->param->hsp_recycle);
-#ifdef USE_PTHREADS
-    pthread_mutex_unlock(&nh->hsp_set->param->hsp_recycle_lock);
-#endif /* USE_PTHREADS */
-    hsp->hsp_set = nh->hsp_set;
+    if(hsp_set->hsp_recycle){
+        hsp = hsp_set->hsp_recycle;
+        hsp_set->hsp_recycle = *((HSP**)hsp);
+    } else {
+        if((!hsp_set->hsp_block_list->len)
+        || (hsp_set->hsp_block_pos
+            == HSPset_hsp_block_size(hsp_set->hsp_block_list->len-1))){
+            g_ptr_array_add(hsp_set->hsp_block_list,
+                g_new(HSP, HSPset_hsp_block_size(
+                                hsp_set->hsp_block_list->len)));
+            hsp_set->hsp_block_pos = 0;
+            }
+        hsp = ((HSP*)hsp_set->hsp_block_list->pdata
+                   [hsp_set->hsp_block_list->len-1])
+            + hsp_set->hsp_block_pos++;
+        }
+    hsp->hsp_set = hsp_set;
     hsp->query_start = nh->query_start;
     hsp->target_start = nh->target_start;
     hsp->length = nh->length;
     hsp->score = nh->score;
     hsp->cobs = nh->cobs; /* Value can be set by HSPset_finalise(); */
+    hsp->query_advance = nh->query_advance;
+    hsp->target_advance = nh->target_advance;
     return hsp;
     }
+/* HSPs are stored in contiguous blocks owned by the HSPset,
+ * so no locking is needed, and they are all freed with the HSPset.
+ */
 
 void HSP_destroy(HSP *hsp){
     register HSPset *hsp_set = hsp->hsp_set;
-#ifdef USE_PTHREADS
-    pthread_mutex_lock(&hsp_set->param->hsp_recycle_lock);
-#endif /* USE_PTHREADS */
-    RecycleBin_recycle(hsp_set->param->hsp_recycle, hsp);
-#ifdef USE_PTHREADS
-    pthread_mutex_unlock(&hsp_set->param->hsp_recycle_lock);
-#endif /* USE_PTHREADS */
+    *((HSP**)hsp) = hsp_set->hsp_recycle;
+    hsp_set->hsp_recycle = hsp;
     return;
     }
+/* The HSP is reused as a free list node (as in the RecycleBin).
+ */
 
 static void HSP_trim_ends(HSP *hsp){
     register gint i;
@@ -930,6 +1123,27 @@ static void HSP_store(HSP *nascent_hsp){
  *                      filter_threshold, then convert to a PQueue
  */
 
+static gboolean HSPset_seed_is_second_hit(HSPset *hsp_set, gint *last_hit,
+                                          gint pos, gint advance){
+    register gint distance;
+    if(*last_hit){
+        distance = pos - (*last_hit - 1);
+        if(distance < (hsp_set->param->seedlen * advance))
+            return FALSE; /* Overlaps the previous hit */
+        if(distance <= (hsp_set->param->two_hit_window * advance)){
+            *last_hit = pos + 1;
+            return TRUE;
+            }
+        }
+    *last_hit = pos + 1;
+    return FALSE;
+    }
+/* Two-hit seeding (as used by BLAST):
+ * last_hit holds the position of the previous hit on this diagonal + 1,
+ * (so that zero means no hit), and pos must be non-decreasing
+ * along each diagonal.
+ */
+
 void HSPset_seed_hsp(HSPset *hsp_set,
                      guint query_start, guint target_start){
     register gint diag_pos
@@ -947,13 +1161,16 @@ void HSPset_seed_hsp(HSPset *hsp_set,
     g_assert(section_pos >= 0);
     g_assert(section_pos < hsp_set->query->len);
     /* Clear if diag has changed */
-    if(hsp_set->param->seed_repeat > 1){
+    if((hsp_set->param->seed_repeat > 1) || hsp_set->param->two_hit_window){
         if(hsp_set->horizon[2][section_pos][query_frame][target_frame]
                != (diag_pos + hsp_set->query->len)){
             hsp_set->horizon[0][section_pos][query_frame][target_frame] = 0;
             hsp_set->horizon[1][section_pos][query_frame][target_frame] = 0;
             hsp_set->horizon[2][section_pos][query_frame][target_frame]
                 = diag_pos + hsp_set->query->len;
+            if(hsp_set->param->two_hit_window)
+                hsp_set->horizon[3][section_pos][query_frame][target_frame]
+                    = 0;
             }
         }
     /* Check whether we have seen this HSP already */
@@ -962,6 +1179,11 @@ void HSPset_seed_hsp(HSPset *hsp_set,
                                       [query_frame]
                                       [target_frame])
         return;
+    if(hsp_set->param->two_hit_window
+    && (!HSPset_seed_is_second_hit(hsp_set,
+            &hsp_set->horizon[3][section_pos][query_frame][target_frame],
+            target_start, hsp_set->param->match->target->advance)))
+        return;
     if(hsp_set->param->seed_repeat > 1){
         if(++hsp_set->horizon[1][section_pos][query_frame][target_frame]
                 < hsp_set->param->seed_repeat)
@@ -974,6 +1196,8 @@ void HSPset_seed_hsp(HSPset *hsp_set,
     nascent_hsp.target_start = target_start;
     nascent_hsp.length       = hsp_set->param->seedlen;
     nascent_hsp.cobs         = 0;
+    nascent_hsp.query_advance  = hsp_set->param->match->query->advance;
+    nascent_hsp.target_advance = hsp_set->param->match->target->advance;
     g_assert(HSP_check(&nascent_hsp));
     HSP_trim_ends(&nascent_hsp);
     /* Score is irrelevant before HSP_init() */
@@ -1005,6 +1229,8 @@ void HSPset_add_known_hsp(HSPset *hsp_set,
     nascent_hsp.target_start = target_start;
     nascent_hsp.length       = length;
     nascent_hsp.cobs         = 0;
+    nascent_hsp.query_advance  = hsp_set->param->match->query->advance;
+    nascent_hsp.target_advance = hsp_set->param->match->target->advance;
     /* Score is irrelevant before HSP_init() */
     HSP_init(&nascent_hsp);
     HSP_store(&nascent_hsp);
@@ -1033,6 +1259,8 @@ static void HSPset_seed_hsp_sorted(HSPset *hsp_set,
         horizon[1][query_frame][target_frame] = section_pos;
         horizon[0][query_frame][target_frame] = 0;
         horizon[2][query_frame][target_frame] = 0;
+        if(hsp_set->param->two_hit_window)
+            horizon[3][query_frame][target_frame] = 0;
         }
 /* FIXME: seedrepeat overflow here */
     if(++horizon[2][query_frame][target_frame] < hsp_set->param->seed_repeat)
@@ -1041,6 +1269,12 @@ static void HSPset_seed_hsp_sorted(HSPset *hsp_set,
     /* Check whether we have seen this HSP already */
     if(target_start < horizon[0][query_frame][target_frame])
         return;
+    if(hsp_set->param->two_hit_window
+    && (!HSPset_seed_is_second_hit(hsp_set,
+                                   &horizon[3][query_frame][target_frame],
+                                   target_start,
+                                   hsp_set->param->match->target->advance)))
+        return;
     /**/
     /* Nascent HSP building: */
     nascent_hsp.hsp_set      = hsp_set;
@@ -1048,6 +1282,8 @@ static void HSPset_seed_hsp_sorted(HSPset *hsp_set,
     nascent_hsp.target_start = target_start;
     nascent_hsp.length       = hsp_set->param->seedlen;
     nascent_hsp.cobs         = 0;
+    nascent_hsp.query_advance  = hsp_set->param->match->query->advance;
+    nascent_hsp.target_advance = hsp_set->param->match->target->advance;
     g_assert(HSP_check(&nascent_hsp));
     HSP_trim_ends(&nascent_hsp);
     /* Score is irrelevant before HSP_init() */
@@ -1069,41 +1305,35 @@ static void HSPset_seed_hsp_sorted(HSPset *hsp_set,
     horizon[0][query_frame][target_frame] = HSP_target_end(&nascent_hsp);
     return;
     }
-/* horizon[0] = diag
- * horizon[1] = target_end
+/* horizon[0] = target_end
+ * horizon[1] = diag
  * horizon[2] = repeat_count
+ * horizon[3] = last_hit (only used for two-hit seeding)
  */
 
-/* Need to use the global to pass q,t advance to qsort compare func */
-static HSPset *HSPset_seed_compare_hsp_set = NULL;
-
-static int HSPset_seed_compare(const void *a, const void *b){
-    register guint *seed_a = (guint*)a,
-                   *seed_b = (guint*)b;
-    register gint diag_a, diag_b;
-    register HSPset *hsp_set = HSPset_seed_compare_hsp_set;
-    g_assert(hsp_set);
-    diag_a = ((seed_a[1] * hsp_set->param->match->query->advance)
-           -  (seed_a[0] * hsp_set->param->match->target->advance)),
-    diag_b = ((seed_b[1] * hsp_set->param->match->query->advance)
-           -  (seed_b[0] * hsp_set->param->match->target->advance));
-    if(diag_a == diag_b)
-        return seed_a[0] - seed_b[0];
-    return diag_a - diag_b;
+static guint64 HSPset_seed_key(gconstpointer data, gpointer user_data){
+    register const guint *seed = data;
+    register HSPset *hsp_set = user_data;
+    register gint diag = (seed[1] * hsp_set->param->match->query->advance)
+                       - (seed[0] * hsp_set->param->match->target->advance);
+    return RadixSort_pair_key(diag + (hsp_set->query->len
+                                   * hsp_set->param->match->target->advance),
+                              seed[0]);
     }
+/* Orders seeds on diagonal then query position.
+ * The diagonal is offset by the query length to make it non-negative.
+ */
 
 void HSPset_seed_all_hsps(HSPset *hsp_set,
                           guint *seed_list, guint seed_list_len){
     register gint i;
     register gint ***horizon;
-    if(seed_list_len > 1){
-        HSPset_seed_compare_hsp_set = hsp_set;
-        qsort(seed_list, seed_list_len, sizeof(guint) << 1,
-              HSPset_seed_compare);
-        HSPset_seed_compare_hsp_set = NULL;
-        }
+    if(seed_list_len > 1)
+        RadixSort_sort(seed_list, seed_list_len, sizeof(guint) << 1,
+                       HSPset_seed_key, hsp_set);
     if(seed_list_len){
-        horizon = (gint***)Matrix3d_create(3,
+        horizon = (gint***)Matrix3d_create(
+                     3 + (hsp_set->param->two_hit_window?1:0),
                      hsp_set->param->match->query->advance,
                      hsp_set->param->match->target->advance,
                      sizeof(gint));
@@ -1151,14 +1381,13 @@ HSPset *HSPset_finalise(HSPset *hsp_set){
 
 /**/
 
-static int HSPset_sort_by_diag_then_query_start(const void *a,
-                                                const void *b){
-    register HSP **hsp_a = (HSP**)a, **hsp_b = (HSP**)b;
-    register gint diag_a = HSP_diagonal(*hsp_a),
-                  diag_b = HSP_diagonal(*hsp_b);
-    if(diag_a == diag_b)
-        return (*hsp_a)->query_start - (*hsp_b)->query_start;
-    return diag_a - diag_b;
+static guint64 HSPset_diag_then_query_start_key(gconstpointer data,
+                                                gpointer user_data){
+    register const HSP *hsp = data;
+    return RadixSort_pair_key(HSP_diagonal(hsp)
+                            + (hsp->hsp_set->query->len
+                               * HSP_target_advance(hsp)),
+                              hsp->query_start);
     }
 
 static Match_Score HSP_score_overlap(HSP *left, HSP *right){
@@ -1197,8 +1426,9 @@ void HSPset_filter_ungapped(HSPset *hsp_set){
     && (hsp_set->param->match->query->advance == 3)
     && (hsp_set->param->match->target->advance == 3)){
         /* FIXME: should not sort when using all-at-once HSPset */
-        qsort(hsp_set->hsp_list->pdata, hsp_set->hsp_list->len,
-              sizeof(gpointer), HSPset_sort_by_diag_then_query_start);
+        RadixSort_sort_pointers(hsp_set->hsp_list->pdata,
+                                hsp_set->hsp_list->len,
+                                HSPset_diag_then_query_start_key, NULL);
         prev_hsp = hsp_set->hsp_list->pdata[0];
         del_prev = FALSE;
         del_curr = FALSE;
@@ -1326,7 +1556,9 @@ void HSPset_seed_all_qy_sorted(HSPset *hsp_set, HSPset_SList_Node *seed_list){
         = g_new0(HSPset_SList_Node*, page_total);
     register gint *page_used = g_new(gint, page_total);
     register gint ****horizon = (gint****)Matrix4d_create(
-                           2 + ((hsp_set->param->seed_repeat > 1)?1:0),
+                           2 + (((hsp_set->param->seed_repeat > 1)
+                               || hsp_set->param->two_hit_window)?1:0)
+                             + (hsp_set->param->two_hit_window?1:0),
                            HSPset_SList_PAGE_SIZE,
                            hsp_set->param->match->query->advance,
                            hsp_set->param->match->target->advance,
@@ -1390,9 +1622,16 @@ void HSPset_seed_all_qy_sorted(HSPset *hsp_set, HSPset_SList_Node *seed_list){
                horizon[1][page_pos][query_frame][target_frame] = page;
                if(hsp_set->param->seed_repeat > 1)
                    horizon[2][page_pos][query_frame][target_frame] = 0;
+               if(hsp_set->param->two_hit_window)
+                   horizon[3][page_pos][query_frame][target_frame] = 0;
                }
             if(seed->query_pos < horizon[0][page_pos][query_frame][target_frame])
                 continue;
+            if(hsp_set->param->two_hit_window
+            && (!HSPset_seed_is_second_hit(hsp_set,
+                     &horizon[3][page_pos][query_frame][target_frame],
+                     seed->query_pos, hsp_set->param->match->query->advance)))
+                continue;
             if(hsp_set->param->seed_repeat > 1){
                 if(++horizon[2][page_pos][query_frame][target_frame]
                         < hsp_set->param->seed_repeat){
@@ -1406,6 +1645,8 @@ void HSPset_seed_all_qy_sorted(HSPset *hsp_set, HSPset_SList_Node *seed_list){
             nascent_hsp.target_start = seed->target_pos;
             nascent_hsp.length       = hsp_set->param->seedlen;
             nascent_hsp.cobs         = 0;
+            nascent_hsp.query_advance  = hsp_set->param->match->query->advance;
+            nascent_hsp.target_advance = hsp_set->param->match->target->advance;
             g_assert(HSP_check(&nascent_hsp));
             HSP_trim_ends(&nascent_hsp);
             /* Score is irrelevant before HSP_init() */
@@ -1435,7 +1676,7 @@ void HSPset_seed_all_qy_sorted(HSPset *hsp_set, HSPset_SList_Node *seed_list){
     /* HSPset_SeedData_destroy(seed_data); */
     return;
     }
-/* horizon[horizon][mailbox][seed_repeat]
+/* horizon[horizon][mailbox][seed_repeat][last_hit]
  *        [page_size][qadv][tadv]
  */
 
@@ -38,6 +38,7 @@ typedef struct {
         gint filter_threshold;
     gboolean use_wordhood_dropoff;
         gint seed_repeat;
+        gint two_hit_window;
     /**/
         gint dna_wordlen;
         gint protein_wordlen;
@@ -70,17 +71,20 @@ typedef struct {
         guint  length;   /* Length is number of match state visits */
   Match_Score  score;
         guint  cobs;     /* cobs == Centre Offset By Score         */
+       guchar  query_advance;  /* Copied from the HSP_Param match  */
+       guchar  target_advance;
 struct HSPset *hsp_set;  /* Never included in hsp_set->ref_count   */
 } HSP;
-/* FIXME: remove hsp_set from HSP to save space ? */
+/* The advances fit in the padding before hsp_set,
+ * so are hoisted into the HSP without increasing its size.
+ * hsp_set is still needed for the score and mask callbacks.
+ */
 
 void HSP_destroy(HSP *hsp);
 
-#define HSP_query_advance(hsp) \
-    ((hsp)->hsp_set->param->match->query->advance)
+#define HSP_query_advance(hsp) ((hsp)->query_advance)
 
-#define HSP_target_advance(hsp) \
-    ((hsp)->hsp_set->param->match->target->advance)
+#define HSP_target_advance(hsp) ((hsp)->target_advance)
 
 #define HSP_query_end(hsp) \
     ((hsp)->query_start    \
@@ -149,10 +153,7 @@ HSPset_ArgumentSet  *has;
           WordHood  *wordhood;
           gboolean   use_horizon;
               gint   seed_repeat;
-        RecycleBin  *hsp_recycle;
-#ifdef USE_PTHREADS
-   pthread_mutex_t   hsp_recycle_lock;
-#endif /* USE_PTHREADS */
+              gint   two_hit_window;
 } HSP_Param;
 
 HSP_Param *HSP_Param_create(Match *match, gboolean use_horizon);
@@ -161,6 +162,7 @@ HSP_Param *HSP_Param_share(HSP_Param *hsp_param);
 HSP_Param *HSP_Param_swap(HSP_Param *hsp_param);
 
      void  HSP_Param_set_wordlen(HSP_Param *hsp_param, gint wordlen);
+     void  HSP_Param_set_seedlen(HSP_Param *hsp_param, gint seedlen);
      /**/
      void  HSP_Param_set_dna_hsp_threshold(HSP_Param *hsp_param,
                                            gint dna_hsp_threshold);
@@ -187,6 +189,12 @@ HSP_Param *HSP_Param_swap(HSP_Param *hsp_param);
                                        gint hsp_threshold);
      void  HSP_Param_set_seed_repeat(HSP_Param *hsp_param,
                                      gint seed_repeat);
+     void  HSP_Param_set_two_hit_window(HSP_Param *hsp_param,
+                                        gint two_hit_window);
+/* With a non-zero two_hit_window, a seed is only extended when
+ * an earlier non-overlapping seed on the same diagonal
+ * lies within two_hit_window positions.
+ */
 
 typedef struct HSPset {
               gint    ref_count;
@@ -195,6 +203,9 @@ typedef struct HSPset {
          HSP_Param    *param;
               gint ****horizon;
          GPtrArray    *hsp_list;
+         GPtrArray    *hsp_block_list;
+              gint     hsp_block_pos;
+               HSP    *hsp_recycle;
           /**/
           gboolean     is_finalised;
             PQueue   **filter;
@@ -33,10 +33,16 @@ static void test_hsp_set(Match_Type match_type,
     register HSP_Param *hsp_param = HSP_Param_create(match, TRUE);
     register HSPset *hsp_set = HSPset_create(query, target, hsp_param);
     register gint i;
+    register HSP *hsp;
     for(i = 0; i < seed_total; i++)
         HSPset_seed_hsp(hsp_set, seed[i].query_start,
                                  seed[i].target_start);
     HSPset_finalise(hsp_set);
+    for(i = 0; i < hsp_set->hsp_list->len; i++){
+        hsp = hsp_set->hsp_list->pdata[i];
+        g_assert(HSP_query_advance(hsp) == match->query->advance);
+        g_assert(HSP_target_advance(hsp) == match->target->advance);
+        }
     HSPset_print(hsp_set);
     HSPset_destroy(hsp_set);
     HSP_Param_destroy(hsp_param);
@@ -45,6 +51,88 @@ static void test_hsp_set(Match_Type match_type,
     return;
     }
 
+static void test_flanked_block_create(gint flank, gint block,
+                                      Sequence **query, Sequence **target){
+    register gint i, len = flank + block + flank;
+    register guint seed = 1;
+    register gchar *qy_seq = g_new(gchar, len+1),
+                   *tg_seq = g_new(gchar, len+1);
+    for(i = 0; i < len; i++){
+        seed = (seed * 1103515245) + 12345;
+        qy_seq[i] = tg_seq[i] = "ACGT"[(seed >> 16) & 3];
+        if((i < flank) || (i >= (flank+block))){
+            qy_seq[i] = 'A';
+            tg_seq[i] = 'T';
+            }
+        }
+    qy_seq[len] = tg_seq[len] = '\0';
+    (*query) = Sequence_create("qy", NULL, qy_seq, 0,
+                               Sequence_Strand_UNKNOWN, NULL);
+    (*target) = Sequence_create("tg", NULL, tg_seq, 0,
+                                Sequence_Strand_UNKNOWN, NULL);
+    g_free(qy_seq);
+    g_free(tg_seq);
+    return;
+    }
+/* Identical random blocks flanked by mismatching sequence */
+
+static void test_long_extension(void){
+    register gint i, flank = 40, block = 150;
+    Sequence *query, *target;
+    register Match *match = Match_find(Match_Type_DNA2DNA);
+    register HSP_Param *hsp_param = HSP_Param_create(match, TRUE);
+    register HSPset *hsp_set;
+    register HSP *hsp;
+    register Match_Score score;
+    test_flanked_block_create(flank, block, &query, &target);
+    hsp_set = HSPset_create(query, target, hsp_param);
+    HSPset_seed_hsp(hsp_set, flank+(block/2), flank+(block/2));
+    HSPset_finalise(hsp_set);
+    g_assert(hsp_set->hsp_list->len == 1);
+    hsp = hsp_set->hsp_list->pdata[0];
+    /* Extension must cross several blocks and stop at the flanks */
+    g_assert(hsp->query_start == flank);
+    g_assert(hsp->target_start == flank);
+    g_assert(hsp->length == block);
+    score = 0;
+    for(i = 0; i < hsp->length; i++)
+        score += HSP_get_score(hsp, hsp->query_start+i,
+                                    hsp->target_start+i);
+    g_assert(score == hsp->score);
+    HSPset_destroy(hsp_set);
+    HSP_Param_destroy(hsp_param);
+    Sequence_destroy(query);
+    Sequence_destroy(target);
+    return;
+    }
+
+static void test_two_hit(void){
+    register gint flank = 40, block = 150;
+    Sequence *query, *target;
+    register Match *match = Match_find(Match_Type_DNA2DNA);
+    register HSP_Param *hsp_param = HSP_Param_create(match, TRUE);
+    register HSPset *hsp_set;
+    test_flanked_block_create(flank, block, &query, &target);
+    HSP_Param_set_two_hit_window(hsp_param, 40);
+    hsp_set = HSPset_create(query, target, hsp_param);
+    /* A single hit, then an overlapping hit are not extended */
+    HSPset_seed_hsp(hsp_set, 60, 60);
+    HSPset_seed_hsp(hsp_set, 65, 65);
+    g_assert(hsp_set->is_empty);
+    /* A hit on another diagonal does not pair with them */
+    HSPset_seed_hsp(hsp_set, 80, 81);
+    g_assert(hsp_set->is_empty);
+    /* A second non-overlapping hit within the window is */
+    HSPset_seed_hsp(hsp_set, 90, 90);
+    HSPset_finalise(hsp_set);
+    g_assert(hsp_set->hsp_list->len == 1);
+    HSPset_destroy(hsp_set);
+    HSP_Param_destroy(hsp_param);
+    Sequence_destroy(query);
+    Sequence_destroy(target);
+    return;
+    }
+
 gint Argument_main(Argument *arg){
     register gchar
     *ntnt_qy = "AAAAGTGAGAGAGAGAGAGAGGCGAAAAAAAAAACCCCCCCCCCACCCCGCGA",
@@ -67,6 +155,10 @@ gint Argument_main(Argument *arg){
     g_message("p2d:");
     test_hsp_set(Match_Type_PROTEIN2DNA,
                  aant_qy, aant_tg, (TestHSPseed*)ntaa_seed, 1);
+    g_message("long d2d:");
+    test_long_extension();
+    g_message("two-hit d2d:");
+    test_two_hit();
     return 0;
     }
 
@@ -187,10 +187,8 @@ static Match_Score Match_3_translate_self_func(Match_Strand *strand,
                                             Sequence *seq, guint pos){
     register gchar symbol;
     g_assert(Match_Strand_pos_is_valid(strand, pos, seq->len));
-    symbol = Translate_base(strand->match->mas->translate,
-                            Sequence_get_symbol(seq, pos),
-                            Sequence_get_symbol(seq, pos+1),
-                            Sequence_get_symbol(seq, pos+2));
+    symbol = Sequence_get_codon_symbol(seq, strand->match->mas->translate,
+                                       pos);
     return Submat_lookup(strand->match->mas->protein_submat,
                          symbol, symbol);
     }
@@ -349,18 +347,17 @@ static Match_Score Match_1_3_score_func(Match *match,
                               guint query_pos, guint target_pos){
     g_assert(Match_pos_pair_is_valid(match, query, target,
                                      query_pos, target_pos));
-    return Match_1_3_split_score_func(match, query, target,
-            query_pos, -1, -1,
-            target_pos, target_pos+1, target_pos+2);
+    return Submat_lookup(match->mas->protein_submat,
+                         Sequence_get_symbol(query, query_pos),
+                         Sequence_get_codon_symbol(target,
+                             match->mas->translate, target_pos));
     }
 
 static gchar *Match_1_3_score_macro(void){
     return "Submat_lookup(ud->mas->protein_submat,\n"
            "              Sequence_get_symbol(ud->query, %QP),\n"
-           "              Translate_base(ud->mas->translate,\n"
-           "                  Sequence_get_symbol(ud->target, %TP),\n"
-           "                  Sequence_get_symbol(ud->target, %TP+1),\n"
-           "                  Sequence_get_symbol(ud->target, %TP+2)))\n";
+           "              Sequence_get_codon_symbol(ud->target,\n"
+           "                  ud->mas->translate, %TP))\n";
     }
 
 typedef struct {
@@ -450,10 +447,8 @@ static Match_Score Match_3_1_score_func(Match *match,
 
 static gchar *Match_3_1_score_macro(void){
     return "Submat_lookup(ud->mas->protein_submat,\n"
-           "              Translate_base(ud->mas->translate,\n"
-           "                  Sequence_get_symbol(ud->query, %QP),\n"
-           "                  Sequence_get_symbol(ud->query, %QP+1),\n"
-           "                  Sequence_get_symbol(ud->query, %QP+2)),\n"
+           "              Sequence_get_codon_symbol(ud->query,\n"
+           "                  ud->mas->translate, %QP),\n"
            "              Sequence_get_symbol(ud->target, %TP))\n";
     }
 
@@ -534,9 +529,18 @@ static Match_Score Match_3_3_codon_score_func(Match *match,
                            guint query_pos, guint target_pos){
     g_assert(Match_pos_pair_is_valid(match, query, target,
                                      query_pos, target_pos));
-    return Match_3_3_split_score_func(match, query, target,
-            query_pos, query_pos+1, query_pos+2,
-            target_pos, target_pos+1, target_pos+2);
+    if(query->annotation)
+        if(query->alphabet->type == Alphabet_Type_DNA)
+            if((query_pos < query->annotation->cds_start)
+            || (query_pos >= (query->annotation->cds_start
+                             +query->annotation->cds_length))
+            || ((query_pos % 3) != (query->annotation->cds_start % 3)))
+                return MATCH_IMPOSSIBLY_LOW_SCORE;
+    return Submat_lookup(match->mas->protein_submat,
+                Sequence_get_codon_symbol(query, match->mas->translate,
+                                          query_pos),
+                Sequence_get_codon_symbol(target, match->mas->translate,
+                                          target_pos));
     }
 
 #if 0
@@ -572,14 +576,10 @@ static gchar *Match_3_3_score_macro(void){
            "    || (((%QP) %% 3) != (ud->query->annotation->cds_start %% 3))))\n"
            "?MATCH_IMPOSSIBLY_LOW_SCORE\n"
            ":Submat_lookup(ud->mas->protein_submat,\n"
-           "               Translate_base(ud->mas->translate, \n"
-           "                  Sequence_get_symbol(ud->query, %QP),\n"
-           "                  Sequence_get_symbol(ud->query, %QP+1),\n"
-           "                  Sequence_get_symbol(ud->query, %QP+2)),\n"
-           "               Translate_base(ud->mas->translate, \n"
-           "                  Sequence_get_symbol(ud->target, %TP),\n"
-           "                  Sequence_get_symbol(ud->target, %TP+1),\n"
-           "                  Sequence_get_symbol(ud->target, %TP+2)))\n";
+           "               Sequence_get_codon_symbol(ud->query,\n"
+           "                  ud->mas->translate, %QP),\n"
+           "               Sequence_get_codon_symbol(ud->target,\n"
+           "                  ud->mas->translate, %TP))\n";
     }
 /* FIXME: optimisations:
  *        remove seq type check
@@ -897,5 +897,15 @@ Match_Score Match_max_score(Match *match){
     return 0;
     }
 
+void Match_set_codon_profiles(Match *match,
+                              Sequence *query, Sequence *target){
+    g_assert(match);
+    if(match->query->advance == 3)
+        Sequence_set_codon_profile(query, match->mas->translate);
+    if(match->target->advance == 3)
+        Sequence_set_codon_profile(target, match->mas->translate);
+    return;
+    }
+
 /**/
 
@@ -123,6 +123,12 @@ Match *Match_swap(Match *match);
 
 Match_Score Match_max_score(Match *match);
 
+void Match_set_codon_profiles(Match *match,
+                              Sequence *query, Sequence *target);
+/* Precompute the codon translations used by the score functions
+ * for any strand of the match which advances by a codon.
+ */
+
 
 /**/
 
@@ -47,6 +47,9 @@ Seeder_ArgumentSet *Seeder_ArgumentSet_create(Argument *arg){
         ArgumentSet_add_option(as, 0, "wordambiguity", NULL,
             "Number of ambiguous words to expand", "1",
             Argument_parse_int, &sas.word_ambiguity);
+        ArgumentSet_add_option(as, 0, "seedpattern", "patterns",
+            "Spaced seed patterns (eg. 1101100111,1110100111)", "none",
+            Argument_parse_string, &sas.seed_pattern);
         Argument_absorb_ArgumentSet(arg, as);
         }
     return &sas;
@@ -188,10 +191,13 @@ typedef struct {
              Seeder *seeder;
     Seeder_WordInfo *curr_word_info;
      Seeder_Context *context;
+               gint  pattern_id;
 } Seeder_TraverseData;
 
 static Seeder_WordInfo *Seeder_add_WordInfo(Seeder *seeder, gchar *word,
-                                            Seeder_Context *context){
+                                            Seeder_Context *context,
+                                            gint pattern_id){
+    register Seeder_WordInfo **leaf_table;
     register Seeder_WordInfo *word_info;
     register VFSM_Int state = 0, leaf;
     if(seeder->seeder_fsm){ /* Add to FSM */
@@ -200,17 +206,30 @@ static Seeder_WordInfo *Seeder_add_WordInfo(Seeder *seeder, gchar *word,
                             context->loader->hsp_param->wordlen, word_info);
     } else { /* Add to VFSM */
         g_assert(seeder->seeder_vfsm);
+        leaf_table = seeder->seeder_vfsm->pattern_leaf[pattern_id];
         state = VFSM_word2state(seeder->seeder_vfsm->vfsm, word);
         leaf = VFSM_state2leaf(seeder->seeder_vfsm->vfsm, state);
-        word_info = seeder->seeder_vfsm->leaf[leaf];
+        word_info = leaf_table[leaf];
         if(!word_info){
             word_info = Seeder_WordInfo_create(seeder);
-            seeder->seeder_vfsm->leaf[leaf] = word_info;
+            leaf_table[leaf] = word_info;
             }
         }
     return word_info;
     }
 
+static gboolean Seeder_WordHood_add_Neighbour(
+                Seeder_TraverseData *traverse_data,
+                Seeder_WordInfo *word_info){
+    g_assert(word_info);
+    if(word_info == traverse_data->curr_word_info)
+        return FALSE; /* This is not a neighbour */
+    /* Make curr seed word a neighbour of this word */
+    Seeder_WordInfo_add_Neighbour(traverse_data->seeder, word_info,
+                                  traverse_data->curr_word_info);
+    return FALSE;
+    }
+
 static gboolean Seeder_word_is_valid(Match *match,
                                      Sequence *seq, gint pos,
                                      gint len){
@@ -239,6 +258,7 @@ static gboolean Seeder_word_is_valid(Match *match,
 
 static Seeder_VFSM *Seeder_VFSM_create(Seeder *seeder){
     register Seeder_VFSM *seeder_vfsm = g_new(Seeder_VFSM, TRUE);
+    register gint i;
     seeder_vfsm->vfsm = VFSM_create(
       (gchar*)seeder->any_hsp_param->match->comparison_alphabet->member,
               seeder->any_hsp_param->wordlen);
@@ -246,13 +266,28 @@ static Seeder_VFSM *Seeder_VFSM_create(Seeder *seeder){
         g_error("Could not create VFSM for alphabet [%s] depth [%d]",
           seeder->any_hsp_param->match->comparison_alphabet->member,
           seeder->any_hsp_param->wordlen);
-    seeder_vfsm->leaf = g_new0(Seeder_WordInfo*, seeder_vfsm->vfsm->lrw);
+    seeder_vfsm->pattern_total = seeder->seed_pattern_list
+                               ? seeder->seed_pattern_list->len
+                               : 1;
+    seeder_vfsm->pattern_leaf = g_new(Seeder_WordInfo**,
+                                      seeder_vfsm->pattern_total);
+    for(i = 0; i < seeder_vfsm->pattern_total; i++)
+        seeder_vfsm->pattern_leaf[i] = g_new0(Seeder_WordInfo*,
+                                              seeder_vfsm->vfsm->lrw);
+    seeder_vfsm->leaf = seeder_vfsm->pattern_leaf[0];
     return seeder_vfsm;
     }
+/* Each seed pattern has its own leaf table,
+ * as the same word found with different patterns
+ * corresponds to different positions.
+ */
 
 static void Seeder_VFSM_destroy(Seeder_VFSM *seeder_vfsm){
+    register gint i;
     VFSM_destroy(seeder_vfsm->vfsm);
-    g_free(seeder_vfsm->leaf);
+    for(i = 0; i < seeder_vfsm->pattern_total; i++)
+        g_free(seeder_vfsm->pattern_leaf[i]);
+    g_free(seeder_vfsm->pattern_leaf);
     g_free(seeder_vfsm);
     return;
     }
@@ -260,7 +295,8 @@ static void Seeder_VFSM_destroy(Seeder_VFSM *seeder_vfsm){
 static gsize Seeder_VFSM_memory_usage(Seeder_VFSM *seeder_vfsm){
     return sizeof(Seeder_VFSM)
          + sizeof(VFSM)
-         + (sizeof(Seeder_WordInfo*) * seeder_vfsm->vfsm->lrw);
+         + (sizeof(Seeder_WordInfo*) * seeder_vfsm->vfsm->lrw
+                                     * seeder_vfsm->pattern_total);
     }
 
 /**/
@@ -297,12 +333,77 @@ static Seeder_Loader *Seeder_Loader_create(HSP_Param *hsp_param,
     return loader;
     }
 
+static void Seeder_Loader_set_seed_patterns(Seeder_Loader *loader,
+                                            GPtrArray *seed_pattern_list){
+    register gint i, seedlen = loader->hsp_param->seedlen;
+    register SeedPattern *seed_pattern;
+    register Match *match = loader->hsp_param->match;
+    if((match->query->advance != 1) || (match->target->advance != 1))
+        g_error("Seed patterns not implemented for [%s] comparisons",
+                Match_Type_get_name(match->type));
+    for(i = 0; i < seed_pattern_list->len; i++){
+        seed_pattern = seed_pattern_list->pdata[i];
+        if(seed_pattern->weight != loader->hsp_param->wordlen)
+            g_error("Seed pattern [%s] has weight [%d] not wordlen [%d]",
+                    seed_pattern->pattern, seed_pattern->weight,
+                    loader->hsp_param->wordlen);
+        if(seedlen > seed_pattern->run_length)
+            seedlen = seed_pattern->run_length;
+        }
+    HSP_Param_set_seedlen(loader->hsp_param, seedlen);
+    return;
+    }
+/* HSPs are seeded from the longest run of matching positions
+ * in each pattern, so the seed length is limited to the shortest
+ * such run, to avoid seeding across the ignored positions.
+ */
+
 static void Seeder_Loader_destroy(Seeder_Loader *loader){
     HSP_Param_destroy(loader->hsp_param);
     g_free(loader);
     return;
     }
 
+/* Shared pools for the Seeder RecycleBins,
+ * so memory is reused across Seeders without locking each node.
+ * Only SEEDER_POOL_SPARE_LIMIT spare chunks are kept per pool,
+ * so one large query does not pin its peak usage for the whole run.
+ */
+
+#define SEEDER_POOL_SPARE_LIMIT 1024
+
+typedef enum {
+    Seeder_Pool_WORDINFO,
+    Seeder_Pool_WORDINFO_NO_ST,
+    Seeder_Pool_SEED,
+    Seeder_Pool_NEIGHBOUR,
+    Seeder_Pool_TOTAL
+} Seeder_Pool_Type;
+
+static RecycleBin *seeder_pool[Seeder_Pool_TOTAL];
+#ifdef USE_PTHREADS
+static pthread_mutex_t seeder_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* USE_PTHREADS */
+
+static RecycleBin *Seeder_create_local_RecycleBin(Seeder_Pool_Type type,
+                                                  gchar *name,
+                                                  gsize node_size){
+    register RecycleBin *recycle_bin;
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&seeder_pool_lock);
+#endif /* USE_PTHREADS */
+    if(!seeder_pool[type]){
+        seeder_pool[type] = RecycleBin_create(name, node_size, 64);
+        RecycleBin_set_spare_limit(seeder_pool[type],
+                                   SEEDER_POOL_SPARE_LIMIT);
+        }
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&seeder_pool_lock);
+#endif /* USE_PTHREADS */
+    recycle_bin = RecycleBin_create_local(seeder_pool[type]);
+    return recycle_bin;
+    }
+
 Seeder *Seeder_create(gint verbosity,
                       Comparison_Param *comparison_param,
                       Match_Score saturate_threshold,
@@ -328,15 +429,18 @@ Seeder *Seeder_create(gint verbosity,
     seeder->comparison_param = Comparison_Param_share(comparison_param);
     seeder->query_info_list = g_ptr_array_new();
     if(saturate_threshold)
-        seeder->recycle_wordinfo = RecycleBin_create(
-                "Seeder_WordInfo", sizeof(Seeder_WordInfo), 64);
+        seeder->recycle_wordinfo = Seeder_create_local_RecycleBin(
+                Seeder_Pool_WORDINFO,
+                "Seeder_WordInfo", sizeof(Seeder_WordInfo));
     else
-        seeder->recycle_wordinfo = RecycleBin_create(
-                "Seeder_WordInfo", sizeof(Seeder_WordInfo_no_ST), 64);
-    seeder->recycle_seed = RecycleBin_create(
-            "Seeder_Seed", sizeof(Seeder_Seed), 64);
-    seeder->recycle_neighbour = RecycleBin_create(
-            "Seeder_Neighbour", sizeof(Seeder_Neighbour), 64);
+        seeder->recycle_wordinfo = Seeder_create_local_RecycleBin(
+                Seeder_Pool_WORDINFO_NO_ST,
+                "Seeder_WordInfo", sizeof(Seeder_WordInfo_no_ST));
+    seeder->recycle_seed = Seeder_create_local_RecycleBin(
+            Seeder_Pool_SEED, "Seeder_Seed", sizeof(Seeder_Seed));
+    seeder->recycle_neighbour = Seeder_create_local_RecycleBin(
+            Seeder_Pool_NEIGHBOUR,
+            "Seeder_Neighbour", sizeof(Seeder_Neighbour));
     seeder->recycle_context = RecycleBin_create(
             "Seeder_Context", sizeof(Seeder_Context), 64);
     /**/
@@ -367,7 +471,26 @@ Seeder *Seeder_create(gint verbosity,
     && (comparison_param->dna_hsp_param
      || comparison_param->codon_hsp_param))
         g_error("Mixed DNA and protein seeding not implemented");
-    if(Seeder_decide_fsm_type(seeder->sas->force_fsm)){ /* Use FSM */
+    seeder->seed_pattern_list
+        = SeedPattern_create_list(seeder->sas->seed_pattern);
+    if(seeder->seed_pattern_list){
+        if(seeder->dna_loader)
+            Seeder_Loader_set_seed_patterns(seeder->dna_loader,
+                                            seeder->seed_pattern_list);
+        if(seeder->protein_loader)
+            Seeder_Loader_set_seed_patterns(seeder->protein_loader,
+                                            seeder->seed_pattern_list);
+        if(seeder->codon_loader)
+            Seeder_Loader_set_seed_patterns(seeder->codon_loader,
+                                            seeder->seed_pattern_list);
+        if(seeder->sas->word_ambiguity > 1)
+            g_error("Word ambiguity not implemented with seed patterns");
+        if(strcasecmp(seeder->sas->force_fsm, "none")
+        && strcasecmp(seeder->sas->force_fsm, "compact"))
+            g_error("Seed patterns require the compact FSM");
+        seeder->seeder_fsm = NULL;
+        seeder->seeder_vfsm = Seeder_VFSM_create(seeder);
+    } else if(Seeder_decide_fsm_type(seeder->sas->force_fsm)){ /* FSM */
         seeder->seeder_fsm = Seeder_FSM_create(seeder);
         seeder->seeder_vfsm = NULL;
     } else { /* Use VFSM */
@@ -406,6 +529,8 @@ void Seeder_destroy(Seeder *seeder){
     if(seeder->codon_loader)
        Seeder_Loader_destroy(seeder->codon_loader);
     HSP_Param_destroy(seeder->any_hsp_param);
+    if(seeder->seed_pattern_list)
+        SeedPattern_destroy_list(seeder->seed_pattern_list);
     g_ptr_array_free(seeder->active_queryinfo_list, TRUE);
     g_free(seeder);
     return;
@@ -461,18 +586,41 @@ static gint Seeder_get_expect(Seeder *seeder, Seeder_Loader *loader,
 static gboolean Seeder_WordHood_traverse(gchar *word,
                  gint score, gpointer user_data){
     register Seeder_TraverseData *traverse_data = user_data;
-    register Seeder *seeder = traverse_data->seeder;
     register Seeder_WordInfo *word_info;
-    g_assert(seeder);
+    g_assert(traverse_data->seeder);
     word_info = Seeder_add_WordInfo(traverse_data->seeder, word,
-                                    traverse_data->context);
-    g_assert(word_info);
-    if(word_info == traverse_data->curr_word_info)
-        return FALSE; /* This is not a neighbour */
-    /* Make curr seed word a neighbour of this word */
-    Seeder_WordInfo_add_Neighbour(seeder, word_info,
-                                  traverse_data->curr_word_info);
-    return FALSE;
+                                    traverse_data->context,
+                                    traverse_data->pattern_id);
+    return Seeder_WordHood_add_Neighbour(traverse_data, word_info);
+    }
+
+static gboolean Seeder_WordHood_traverse_VFSM(VFSM_Int leaf,
+                 gint score, gpointer user_data){
+    register Seeder_TraverseData *traverse_data = user_data;
+    register Seeder *seeder = traverse_data->seeder;
+    register Seeder_WordInfo **leaf_table
+        = seeder->seeder_vfsm->pattern_leaf[traverse_data->pattern_id];
+    register Seeder_WordInfo *word_info = leaf_table[leaf];
+    if(!word_info){
+        word_info = Seeder_WordInfo_create(seeder);
+        leaf_table[leaf] = word_info;
+        }
+    return Seeder_WordHood_add_Neighbour(traverse_data, word_info);
+    }
+
+static void Seeder_WordHood_expand(Seeder *seeder, HSP_Param *hsp_param,
+                                   gchar *word, gint len,
+                                   Seeder_TraverseData *traverse_data){
+    if(seeder->seeder_vfsm && (hsp_param->wordhood->wha->advance == 1))
+        WordHood_traverse_VFSM(hsp_param->wordhood,
+                               seeder->seeder_vfsm->vfsm,
+                               Seeder_WordHood_traverse_VFSM,
+                               word, len, traverse_data);
+    else
+        WordHood_traverse(hsp_param->wordhood,
+                          Seeder_WordHood_traverse,
+                          word, len, traverse_data);
+    return;
     }
 
 static void Seeder_insert_query(Seeder *seeder, Seeder_Context *context,
@@ -493,6 +641,7 @@ static void Seeder_insert_query(Seeder *seeder, Seeder_Context *context,
         }
     traverse_data.seeder = seeder;
     traverse_data.context = context;
+    traverse_data.pattern_id = 0;
     g_assert(context);
     g_assert(query);
     g_assert(query->len >= 0);
@@ -527,7 +676,7 @@ static void Seeder_insert_query(Seeder *seeder, Seeder_Context *context,
             continue;
         if(seeder->seeder_fsm){
             word_info = Seeder_WordInfo_create(seeder);
-            word_info = Seeder_add_WordInfo(seeder, seq+pos, context);
+            word_info = Seeder_add_WordInfo(seeder, seq+pos, context, 0);
         } else {
             leaf = VFSM_state2leaf(vfsm, state);
             word_info = seeder->seeder_vfsm->leaf[leaf];
@@ -547,16 +696,80 @@ static void Seeder_insert_query(Seeder *seeder, Seeder_Context *context,
         && (!word_info->seed_list->next)){ /* 1st seed */
             traverse_data.curr_word_info = word_info;
             if(context->loader->hsp_param->wordhood)
-                WordHood_traverse(context->loader->hsp_param->wordhood,
-                              Seeder_WordHood_traverse, seq+pos,
-                              context->loader->hsp_param->wordlen, &traverse_data);
+                Seeder_WordHood_expand(seeder, context->loader->hsp_param,
+                              seq+pos, context->loader->hsp_param->wordlen,
+                              &traverse_data);
+            }
+        }
+    Sequence_destroy(seq_masked);
+    g_free(seq);
+    return;
+    }
+
+static void Seeder_insert_query_spaced(Seeder *seeder,
+                                       Seeder_Context *context,
+                                       Sequence *query){
+    register Match_Score query_expect = 0;
+    register gint i, pos, wj_ctr;
+    register Seeder_WordInfo *word_info, **leaf_table;
+    register Match *match = context->loader->hsp_param->match;
+    register VFSM *vfsm = seeder->seeder_vfsm->vfsm;
+    register VFSM_Int leaf;
+    register SeedPattern *seed_pattern;
+    register Sequence *seq_masked = Sequence_mask(query);
+    register gchar *seq = Sequence_get_str(seq_masked);
+    register gchar *word = g_new(gchar, vfsm->depth+1);
+    Seeder_TraverseData traverse_data;
+    if(seeder->saturate_threshold){
+        seeder->total_query_length += query->len;
+        query_expect = Seeder_get_expect(seeder, context->loader,
+                                         seeder->total_query_length);
+        }
+    traverse_data.seeder = seeder;
+    traverse_data.context = context;
+    for(i = 0; i < seeder->seed_pattern_list->len; i++){
+        seed_pattern = seeder->seed_pattern_list->pdata[i];
+        leaf_table = seeder->seeder_vfsm->pattern_leaf[i];
+        traverse_data.pattern_id = i;
+        wj_ctr = 0;
+        for(pos = 0; (pos + seed_pattern->span) <= query->len; pos++){
+            leaf = SeedPattern_get_leaf(seed_pattern, vfsm, seq+pos);
+            if(leaf == vfsm->lrw)
+                continue;
+            if(wj_ctr--)
+                continue;
+            wj_ctr = seeder->sas->word_jump - 1;
+            if(!Seeder_word_is_valid(match, seq_masked, pos,
+                                     seed_pattern->span))
+                continue;
+            word_info = leaf_table[leaf];
+            if(!word_info){
+                word_info = Seeder_WordInfo_create(seeder);
+                leaf_table[leaf] = word_info;
+                }
+            Seeder_WordInfo_add_Seed(seeder, word_info, context,
+                                 query_expect,
+                                 pos + seed_pattern->run_start);
+            if(word_info->seed_list /* not blocked */
+            && (!word_info->seed_list->next)){ /* 1st seed */
+                traverse_data.curr_word_info = word_info;
+                if(context->loader->hsp_param->wordhood){
+                    SeedPattern_get_word(seed_pattern, seq+pos, word);
+                    Seeder_WordHood_expand(seeder,
+                        context->loader->hsp_param, word,
+                        seed_pattern->weight, &traverse_data);
+                    }
+                }
             }
         }
     Sequence_destroy(seq_masked);
     g_free(seq);
+    g_free(word);
     return;
     }
-/* FIXME: optimisation : efficient VFSM wordhood traversal ? */
+/* Seeds are recorded at the start of the longest run of
+ * matching positions in the pattern (see Seeder_Loader_set_seed_patterns)
+ */
 
 static Seeder_Context *Seeder_Context_create(Seeder *seeder,
                        Seeder_QueryInfo *query_info,
@@ -579,7 +792,10 @@ static void Seeder_load_query(Seeder *seeder,
     g_assert(match);
     g_assert(query_info->query->alphabet->type
              == match->query->alphabet->type);
-    if(match->query->is_translated){
+    if(seeder->seed_pattern_list){
+        g_assert(!match->query->is_translated);
+        Seeder_insert_query_spaced(seeder, context, query_info->query);
+    } else if(match->query->is_translated){
         g_assert(match->mas->translate);
         for(i = 0; i < 3; i++){
             aa_seq = Sequence_translate(query_info->query,
@@ -771,9 +987,39 @@ static void Seeder_VFSM_traverse_ambig(Seeder *seeder, gchar *seq,
     return;
     }
 
+static void Seeder_VFSM_traverse_spaced(Seeder *seeder, gchar *seq,
+                                        Seeder_TargetInfo *target_info){
+    register gint i, pos, len = strlen(seq);
+    register VFSM *vfsm = seeder->seeder_vfsm->vfsm;
+    register VFSM_Int leaf;
+    register Seeder_WordInfo *word_info, **leaf_table;
+    register SeedPattern *seed_pattern;
+    for(i = 0; i < seeder->seed_pattern_list->len; i++){
+        seed_pattern = seeder->seed_pattern_list->pdata[i];
+        leaf_table = seeder->seeder_vfsm->pattern_leaf[i];
+        for(pos = 0; (pos + seed_pattern->span) <= len; pos++){
+            leaf = SeedPattern_get_leaf(seed_pattern, vfsm, seq+pos);
+            if(leaf == vfsm->lrw)
+                continue;
+            word_info = leaf_table[leaf];
+            if(word_info)
+                Seeder_FSM_traverse_func(pos + seed_pattern->run_start
+                                       + vfsm->depth - 1,
+                                         word_info, target_info);
+            }
+        }
+    return;
+    }
+/* The position passed to Seeder_FSM_traverse_func()
+ * is offset by the word length, as this is subtracted
+ * as the tpos_modifier for contiguous words.
+ */
+
 static void Seeder_VFSM_traverse(Seeder *seeder, gchar *seq,
                                  Seeder_TargetInfo *target_info){
-    if(seeder->sas->word_ambiguity > 1)
+    if(seeder->seed_pattern_list)
+        Seeder_VFSM_traverse_spaced(seeder, seq, target_info);
+    else if(seeder->sas->word_ambiguity > 1)
         Seeder_VFSM_traverse_ambig(seeder, seq, target_info);
     else
         Seeder_VFSM_traverse_single(seeder, seq, target_info);
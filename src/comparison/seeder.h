@@ -27,12 +27,14 @@ extern "C" {
 #include "fsm.h"
 #include "vfsm.h"
 #include "comparison.h"
+#include "seedpattern.h"
 
 typedef struct {
        gsize  fsm_memory_limit;
        gchar *force_fsm;
         gint  word_jump;
         gint  word_ambiguity;
+       gchar *seed_pattern;
 } Seeder_ArgumentSet;
 
 Seeder_ArgumentSet *Seeder_ArgumentSet_create(Argument *arg);
@@ -146,9 +148,12 @@ typedef struct {
 } Seeder_FSM;
 
 typedef struct {
-               VFSM  *vfsm;
-    Seeder_WordInfo **leaf;
+               VFSM   *vfsm;
+    Seeder_WordInfo  **leaf;
+    Seeder_WordInfo ***pattern_leaf; /* For each seed pattern */
+               gint    pattern_total;
 } Seeder_VFSM;
+/* leaf is pattern_leaf[0], which is used for contiguous words */
 
 /**/
 
@@ -178,6 +183,7 @@ typedef struct {
          Seeder_Loader *codon_loader;
              GPtrArray *active_queryinfo_list;
              HSP_Param *any_hsp_param;
+             GPtrArray *seed_pattern_list; /* NULL when contiguous */
 } Seeder;
 
 Seeder *Seeder_create(gint verbosity,
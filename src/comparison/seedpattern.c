@@ -0,0 +1,144 @@
+/****************************************************************\
+*                                                                *
+*  Library for spaced seed patterns                              *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#include <ctype.h>   /* For toupper()    */
+#include <string.h>  /* For strlen()     */
+#include <strings.h> /* For strcasecmp() */
+
+#include "seedpattern.h"
+
+SeedPattern *SeedPattern_create(gchar *pattern){
+    register SeedPattern *seed_pattern;
+    register gint i, run = 0;
+    g_assert(pattern);
+    seed_pattern = g_new0(SeedPattern, 1);
+    seed_pattern->pattern = g_strdup(pattern);
+    seed_pattern->span = strlen(pattern);
+    if((seed_pattern->span < 1)
+    || (seed_pattern->span > SEEDPATTERN_MAX_SPAN))
+        g_error("Seed pattern [%s] must have 1 to %d positions",
+                pattern, SEEDPATTERN_MAX_SPAN);
+    if((pattern[0] != '1') || (pattern[seed_pattern->span-1] != '1'))
+        g_error("Seed pattern [%s] must start and end with '1'",
+                pattern);
+    seed_pattern->offset = g_new(gint, seed_pattern->span);
+    for(i = 0; i < seed_pattern->span; i++){
+        switch(pattern[i]){
+            case '1':
+                seed_pattern->offset[seed_pattern->weight++] = i;
+                if(++run > seed_pattern->run_length){
+                    seed_pattern->run_length = run;
+                    seed_pattern->run_start = i - run + 1;
+                    }
+                break;
+            case '0':
+                run = 0;
+                break;
+            default:
+                g_error("Bad symbol [%c] in seed pattern [%s]",
+                        pattern[i], pattern);
+                break;
+            }
+        }
+    return seed_pattern;
+    }
+
+void SeedPattern_destroy(SeedPattern *seed_pattern){
+    g_free(seed_pattern->pattern);
+    g_free(seed_pattern->offset);
+    g_free(seed_pattern);
+    return;
+    }
+
+GPtrArray *SeedPattern_create_list(gchar *pattern_list){
+    register GPtrArray *seed_pattern_list;
+    register gchar **pattern;
+    register gint i;
+    if((!pattern_list) || (!strcasecmp(pattern_list, "none")))
+        return NULL;
+    seed_pattern_list = g_ptr_array_new();
+    pattern = g_strsplit(pattern_list, ",", 0);
+    for(i = 0; pattern[i]; i++)
+        g_ptr_array_add(seed_pattern_list,
+                        SeedPattern_create(g_strstrip(pattern[i])));
+    g_strfreev(pattern);
+    if(!seed_pattern_list->len)
+        g_error("No seed patterns found in [%s]", pattern_list);
+    return seed_pattern_list;
+    }
+
+void SeedPattern_destroy_list(GPtrArray *seed_pattern_list){
+    register gint i;
+    for(i = 0; i < seed_pattern_list->len; i++)
+        SeedPattern_destroy(seed_pattern_list->pdata[i]);
+    g_ptr_array_free(seed_pattern_list, TRUE);
+    return;
+    }
+
+/**/
+
+guint64 SeedPattern_get_mask(SeedPattern *seed_pattern){
+    register guint64 mask = 0;
+    register gint i;
+    for(i = 0; i < seed_pattern->weight; i++)
+        mask |= ((guint64)1 << seed_pattern->offset[i]);
+    return mask;
+    }
+
+SeedPattern *SeedPattern_create_from_mask(guint64 mask){
+    register SeedPattern *seed_pattern;
+    register gint i, span = 0;
+    gchar pattern[SEEDPATTERN_MAX_SPAN+1];
+    g_assert(mask);
+    for(i = 0; i < SEEDPATTERN_MAX_SPAN; i++)
+        if(mask & ((guint64)1 << i))
+            span = i + 1;
+    for(i = 0; i < span; i++)
+        pattern[i] = (mask & ((guint64)1 << i))?'1':'0';
+    pattern[span] = '\0';
+    seed_pattern = SeedPattern_create(pattern);
+    return seed_pattern;
+    }
+
+/**/
+
+void SeedPattern_get_word(SeedPattern *seed_pattern, gchar *seq,
+                          gchar *word){
+    register gint i;
+    for(i = 0; i < seed_pattern->weight; i++)
+        word[i] = toupper(seq[seed_pattern->offset[i]]);
+    word[i] = '\0';
+    return;
+    }
+
+VFSM_Int SeedPattern_get_leaf(SeedPattern *seed_pattern, VFSM *vfsm,
+                              gchar *seq){
+    register gint i, ch;
+    register VFSM_Int state = 0;
+    g_assert(vfsm->depth == seed_pattern->weight);
+    for(i = 0; i < seed_pattern->weight; i++){
+        ch = toupper(seq[seed_pattern->offset[i]]);
+        if(!vfsm->index[ch])
+            return vfsm->lrw;
+        state = VFSM_change_state_M(vfsm, state, ch);
+        }
+    g_assert(VFSM_state_is_leaf(vfsm, state));
+    return VFSM_state2leaf(vfsm, state);
+    }
+/* The state is built from the root for each window,
+ * as the matching positions of neighbouring windows
+ * do not overlap in a way that allows the VFSM to be stepped.
+ */
+
@@ -0,0 +1,75 @@
+/****************************************************************\
+*                                                                *
+*  Library for spaced seed patterns                              *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#ifndef INCLUDED_SEEDPATTERN_H
+#define INCLUDED_SEEDPATTERN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <glib.h>
+
+#include "vfsm.h"
+
+#define SEEDPATTERN_MAX_SPAN 64
+
+typedef struct {
+    gchar *pattern;
+     gint  span;       /* Number of positions covered by the pattern  */
+     gint  weight;     /* Number of positions which must match        */
+     gint *offset;     /* Offset of each position which must match    */
+     gint  run_start;  /* Start of the longest run of matching positions */
+     gint  run_length; /* Length of the longest run                    */
+} SeedPattern;
+/* A pattern is a string such as "1101100111",
+ * where '1' marks a position used in the word and '0' is ignored.
+ * Contiguous words are the special case "111...".
+ */
+
+SeedPattern *SeedPattern_create(gchar *pattern);
+       void  SeedPattern_destroy(SeedPattern *seed_pattern);
+
+GPtrArray *SeedPattern_create_list(gchar *pattern_list);
+     void  SeedPattern_destroy_list(GPtrArray *seed_pattern_list);
+/* pattern_list is a comma separated list of patterns.
+ * Returns NULL if pattern_list is NULL or "none".
+ */
+
+guint64 SeedPattern_get_mask(SeedPattern *seed_pattern);
+SeedPattern *SeedPattern_create_from_mask(guint64 mask);
+/* The mask has bit i set when position i must match.
+ * This is used to store a pattern in an index header.
+ */
+
+void SeedPattern_get_word(SeedPattern *seed_pattern, gchar *seq,
+                          gchar *word);
+/* Copies the matching positions of the window starting at seq to word,
+ * which must have space for weight+1 symbols.
+ */
+
+VFSM_Int SeedPattern_get_leaf(SeedPattern *seed_pattern, VFSM *vfsm,
+                              gchar *seq);
+/* Returns the VFSM leaf for the window starting at seq,
+ * or vfsm->lrw if any matching position is not in the VFSM alphabet.
+ * The depth of the VFSM must be the same as the pattern weight.
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* INCLUDED_SEEDPATTERN_H */
+
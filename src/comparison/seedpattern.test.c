@@ -0,0 +1,56 @@
+/****************************************************************\
+*                                                                *
+*  Library for spaced seed patterns                              *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#include <string.h> /* For strcmp() */
+
+#include "seedpattern.h"
+#include "argument.h"
+
+gint Argument_main(Argument *arg){
+    register GPtrArray *seed_pattern_list
+        = SeedPattern_create_list("1101100111,111");
+    register SeedPattern *seed_pattern, *from_mask;
+    register VFSM *vfsm;
+    register VFSM_Int leaf, contiguous_leaf;
+    gchar word[SEEDPATTERN_MAX_SPAN+1];
+    g_assert(seed_pattern_list->len == 2);
+    seed_pattern = seed_pattern_list->pdata[0];
+    g_assert(seed_pattern->span == 10);
+    g_assert(seed_pattern->weight == 7);
+    g_assert(seed_pattern->run_start == 7);
+    g_assert(seed_pattern->run_length == 3);
+    /* Check the mask round trip */
+    from_mask = SeedPattern_create_from_mask(
+                    SeedPattern_get_mask(seed_pattern));
+    g_assert(!strcmp(from_mask->pattern, seed_pattern->pattern));
+    SeedPattern_destroy(from_mask);
+    /* Check word extraction ignores the unused positions */
+    SeedPattern_get_word(seed_pattern, "acNgtNNcgt", word);
+    g_message("spaced word [%s]", word);
+    g_assert(!strcmp(word, "ACGTCGT"));
+    /* Check the leaf matches that of the contiguous word */
+    vfsm = VFSM_create("ACGT", seed_pattern->weight);
+    leaf = SeedPattern_get_leaf(seed_pattern, vfsm, "ACNGTNNCGT");
+    contiguous_leaf = VFSM_state2leaf(vfsm,
+                                      VFSM_word2state(vfsm, "ACGTCGT"));
+    g_assert(leaf == contiguous_leaf);
+    g_assert(SeedPattern_get_leaf(seed_pattern, vfsm, "NCAGTAACGT")
+             == vfsm->lrw);
+    VFSM_destroy(vfsm);
+    SeedPattern_destroy_list(seed_pattern_list);
+    g_assert(!SeedPattern_create_list("none"));
+    return 0;
+    }
+
@@ -178,11 +178,17 @@ WordHood *WordHood_create(WordHood_Alphabet *wha,
     wh->curr_len = 0;
     wh->word_pos = 0;
     wh->curr_score = 0;
+    wh->vfsm_row_score = NULL;
+    wh->vfsm_member = NULL;
+    wh->vfsm_member_total = 0;
+    wh->vfsm_alloc = 0;
     return wh;
     }
 
 void WordHood_destroy(WordHood *wh){
     WordHood_Alphabet_destroy(wh->wha);
+    g_free(wh->vfsm_row_score);
+    g_free(wh->vfsm_member);
     g_free(wh->depth_threshold);
     g_free(wh->curr_word);
     g_free(wh);
@@ -318,16 +324,14 @@ static gint WordHood_score_word(WordHood *wh){
     return score;
     }
 
-void WordHood_traverse(WordHood *wh, WordHood_Traverse_Func whtf,
-                       gchar *word, gint len, gpointer user_data){
+static gboolean WordHood_prepare(WordHood *wh, gchar *word, gint len){
     register gint actual_threshold;
-    g_assert(wh);
-    g_assert(whtf);
-    g_assert(word);
     wh->orig_word = word;
     wh->curr_len = len;
-    if(!WordHood_word_is_valid(wh))
-        return;
+    if(!WordHood_word_is_valid(wh)){
+        wh->orig_word = NULL;
+        return FALSE;
+        }
     if(wh->use_dropoff){
         /* FIXME: supply word_score to obviate this */
         actual_threshold = WordHood_score_word(wh) - wh->threshold;
@@ -335,10 +339,95 @@ void WordHood_traverse(WordHood *wh, WordHood_Traverse_Func whtf,
         actual_threshold = wh->threshold;
         }
     WordHood_set_word(wh, word, len, actual_threshold);
+    return TRUE;
+    }
+
+void WordHood_traverse(WordHood *wh, WordHood_Traverse_Func whtf,
+                       gchar *word, gint len, gpointer user_data){
+    g_assert(wh);
+    g_assert(whtf);
+    g_assert(word);
+    if(!WordHood_prepare(wh, word, len))
+        return;
     WordHood_traverse_word(wh, whtf, user_data);
     wh->orig_word = NULL;
     return;
     }
+
+/**/
+
+static void WordHood_VFSM_set_word(WordHood *wh, VFSM *vfsm){
+    register gint i, j;
+    register gint *row_score;
+    gchar symbol;
+    if(wh->vfsm_alloc < (wh->curr_len * vfsm->alphabet_size)){
+        wh->vfsm_alloc = wh->curr_len * vfsm->alphabet_size;
+        wh->vfsm_row_score = g_renew(gint, wh->vfsm_row_score,
+                                     wh->vfsm_alloc);
+        wh->vfsm_member = g_renew(gint, wh->vfsm_member,
+                                  vfsm->alphabet_size);
+        }
+    wh->vfsm_member_total = 0;
+    for(i = 0; i < vfsm->alphabet_size; i++)
+        if(wh->wha->output_index[(guchar)vfsm->alphabet[i]] != -1)
+            wh->vfsm_member[wh->vfsm_member_total++] = i;
+    for(i = 0; i < wh->curr_len; i++){
+        row_score = wh->vfsm_row_score + (i * vfsm->alphabet_size);
+        for(j = 0; j < wh->vfsm_member_total; j++){
+            symbol = vfsm->alphabet[wh->vfsm_member[j]];
+            row_score[j] = wh->wha->score_func(wh->wha,
+                                               wh->orig_word+i, &symbol);
+            }
+        }
+    return;
+    }
+/* Scores for each member at each position are looked up once per word,
+ * rather than once per visit to each node of the wordhood trie.
+ */
+
+static gboolean WordHood_VFSM_descend(WordHood *wh, VFSM *vfsm,
+                                      WordHood_VFSM_Traverse_Func whvtf,
+                                      gint depth, VFSM_Int leaf,
+                                      gint score, gpointer user_data){
+    register gint i, next_score;
+    register gint *row_score = wh->vfsm_row_score
+                             + (depth * vfsm->alphabet_size);
+    register VFSM_Int next_leaf;
+    for(i = 0; i < wh->vfsm_member_total; i++){
+        next_score = score + row_score[i];
+        if(next_score < wh->depth_threshold[depth])
+            continue;
+        next_leaf = (leaf * vfsm->alphabet_size) + wh->vfsm_member[i];
+        if(depth == (wh->curr_len-1)){
+            if(whvtf(next_leaf, next_score, user_data))
+                return TRUE;
+        } else if(WordHood_VFSM_descend(wh, vfsm, whvtf, depth+1,
+                                        next_leaf, next_score, user_data)){
+            return TRUE;
+            }
+        }
+    return FALSE;
+    }
+
+void WordHood_traverse_VFSM(WordHood *wh, VFSM *vfsm,
+                            WordHood_VFSM_Traverse_Func whvtf,
+                            gchar *word, gint len, gpointer user_data){
+    g_assert(wh);
+    g_assert(vfsm);
+    g_assert(whvtf);
+    g_assert(word);
+    g_assert(wh->wha->advance == 1);
+    g_assert(len == vfsm->depth);
+    if(!WordHood_prepare(wh, word, len))
+        return;
+    WordHood_VFSM_set_word(wh, vfsm);
+    WordHood_VFSM_descend(wh, vfsm, whvtf, 0, 0, 0, user_data);
+    wh->orig_word = NULL;
+    return;
+    }
+/* Leaf ids are built digit by digit as the trie is descended,
+ * so no words are copied, compared or mapped back to VFSM states.
+ */
 /* FIXME: dropoff wordhood:
  *        change to only exclude negatively scoring words
  *        from the wordhood, rather than any ones containing
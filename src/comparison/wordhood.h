@@ -26,6 +26,7 @@ extern "C" {
 
 #include "submat.h"
 #include "codonsubmat.h"
+#include "vfsm.h"
 
 #ifndef ALPHABETSIZE
 #define ALPHABETSIZE (1<<(CHAR_BIT))
@@ -79,6 +80,10 @@ typedef struct {
                       gint  curr_score;
                       gint  curr_len;
                       gint  alloc_len;
+                      gint *vfsm_row_score;
+                      gint *vfsm_member;
+                      gint  vfsm_member_total;
+                      gint  vfsm_alloc;
 } WordHood;
 
 WordHood *WordHood_create(WordHood_Alphabet *wha,
@@ -100,6 +105,19 @@ void WordHood_info(WordHood *wh);
 void WordHood_traverse(WordHood *wh, WordHood_Traverse_Func whtf,
                        gchar *word, gint len, gpointer user_data);
 
+typedef gboolean (*WordHood_VFSM_Traverse_Func)(VFSM_Int leaf,
+                  gint score, gpointer user_data);
+/* Return TRUE to stop the traversal */
+
+void WordHood_traverse_VFSM(WordHood *wh, VFSM *vfsm,
+                            WordHood_VFSM_Traverse_Func whvtf,
+                            gchar *word, gint len, gpointer user_data);
+/* Generates the same wordhood as WordHood_traverse(),
+ * but walks the VFSM directly and reports the leaf of each word.
+ * Requires a single symbol alphabet and len == vfsm->depth.
+ * Words are reported in the order of the VFSM alphabet.
+ */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
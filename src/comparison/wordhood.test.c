@@ -24,9 +24,56 @@ static gboolean wordhood_test_func(gchar *word, gint score,
     return FALSE;
     }
 
+typedef struct {
+    VFSM *vfsm;
+    GArray *leaf_list;
+} WordHood_Test_Data;
+
+static gboolean wordhood_test_collect_func(gchar *word, gint score,
+                                           gpointer user_data){
+    register WordHood_Test_Data *data = user_data;
+    VFSM_Int leaf = VFSM_state2leaf(data->vfsm,
+                                    VFSM_word2state(data->vfsm, word));
+    g_array_append_val(data->leaf_list, leaf);
+    return FALSE;
+    }
+
+static gboolean wordhood_test_collect_vfsm_func(VFSM_Int leaf, gint score,
+                                                gpointer user_data){
+    register WordHood_Test_Data *data = user_data;
+    g_array_append_val(data->leaf_list, leaf);
+    return FALSE;
+    }
+
+static void wordhood_test_vfsm(WordHood *wh, gchar *alphabet,
+                               gchar *word, gint len){
+    register gint i;
+    WordHood_Test_Data string_data, vfsm_data;
+    string_data.vfsm = vfsm_data.vfsm = VFSM_create(alphabet, len);
+    string_data.leaf_list = g_array_new(FALSE, FALSE, sizeof(VFSM_Int));
+    vfsm_data.leaf_list = g_array_new(FALSE, FALSE, sizeof(VFSM_Int));
+    WordHood_traverse(wh, wordhood_test_collect_func,
+                      word, len, &string_data);
+    WordHood_traverse_VFSM(wh, vfsm_data.vfsm,
+                           wordhood_test_collect_vfsm_func,
+                           word, len, &vfsm_data);
+    g_message("VFSM wordhood of [%s] has [%d] words",
+              word, vfsm_data.leaf_list->len);
+    g_assert(string_data.leaf_list->len == vfsm_data.leaf_list->len);
+    for(i = 0; i < vfsm_data.leaf_list->len; i++)
+        g_assert(g_array_index(string_data.leaf_list, VFSM_Int, i)
+              == g_array_index(vfsm_data.leaf_list, VFSM_Int, i));
+    g_array_free(string_data.leaf_list, TRUE);
+    g_array_free(vfsm_data.leaf_list, TRUE);
+    VFSM_destroy(vfsm_data.vfsm);
+    return;
+    }
+
 int Argument_main(Argument *arg){
     register gchar *seq = "AAACCCGGGTTT";
-    register Submat *s = Submat_create("nucleic");
+    register Submat *s = Submat_create("nucleic"),
+                    *p = Submat_create("blosum62");
+    register gchar *protein_alphabet = "ARNDCQEGHILKMFPSTWYV";
     register CodonSubmat *cs = CodonSubmat_create();
     register WordHood_Alphabet *wha;
     register WordHood *wh;
@@ -39,6 +86,18 @@ int Argument_main(Argument *arg){
     wh = WordHood_create(wha, 9, TRUE);
     WordHood_info(wh);
     WordHood_traverse(wh, wordhood_test_func, seq, strlen(seq), &count);
+    wordhood_test_vfsm(wh, "ACGT", seq, strlen(seq));
+    WordHood_destroy(wh);
+    WordHood_Alphabet_destroy(wha);
+    /**/
+    g_message("using blosum62 submat");
+    wha = WordHood_Alphabet_create_from_Submat(protein_alphabet,
+                                               protein_alphabet, p, FALSE);
+    wh = WordHood_create(wha, 11, FALSE);
+    wordhood_test_vfsm(wh, protein_alphabet, "WCH", 3);
+    WordHood_destroy(wh);
+    wh = WordHood_create(wha, 4, TRUE);
+    wordhood_test_vfsm(wh, protein_alphabet, "MKVLA", 5);
     WordHood_destroy(wh);
     WordHood_Alphabet_destroy(wha);
     /**/
@@ -54,6 +113,7 @@ int Argument_main(Argument *arg){
     WordHood_Alphabet_destroy(wha);
     /**/
     Submat_destroy(s);
+    Submat_destroy(p);
     CodonSubmat_destroy(cs);
     return 0;
     }
@@ -16,6 +16,7 @@
 #include <stdio.h> /* For BUFSIZ */
 #include <errno.h>
 #include <string.h> /* For strerror() */
+#include <strings.h> /* For strcasecmp() */
 #include <ctype.h>  /* For isspace(),isprint() */
 
 #include <sys/types.h> /* For stat() */
@@ -39,6 +40,12 @@ FastaDB_ArgumentSet *FastaDB_ArgumentSet_create(Argument *arg){
         ArgumentSet_add_option(as, '\0', "fastasuffix", "suffix",
            "Fasta file suffix filter (in subdirectories)", ".fa",
            Argument_parse_string, &fas.suffix_filter);
+        ArgumentSet_add_option(as, '\0', "chunkbalance", "[bytes|length]",
+           "Balance database chunks on file size or sequence length",
+           "length", Argument_parse_string, &fas.chunk_balance);
+        ArgumentSet_add_option(as, '\0', "chunkseqcost", "residues",
+           "Extra cost of each sequence when balancing on length", "0",
+           Argument_parse_int, &fas.chunk_seq_cost);
         Argument_absorb_ArgumentSet(arg, as);
         }
     return &fas;
@@ -142,26 +149,100 @@ FastaDB *FastaDB_open_list(GPtrArray *path_list, Alphabet *alphabet){
     return fdb;
     }
 
+static void FastaDB_find_balanced_limits(FastaDB *fdb,
+            gint chunk_id, gint chunk_total, gint seq_cost,
+            CompoundFile_Pos *start, CompoundFile_Pos *stop){
+    register GArray *pos_list = g_array_new(FALSE, FALSE,
+                                            sizeof(CompoundFile_Pos));
+    register GArray *cost_list = g_array_new(FALSE, FALSE,
+                                             sizeof(guint64));
+    register gint ch, prev = '\n', i;
+    register gboolean in_header = FALSE;
+    register guint64 target;
+    CompoundFile_Pos pos;
+    guint64 cost = 0;
+    gint boundary[2];
+    /* Find the start and cumulative cost of each sequence */
+    CompoundFile_rewind(fdb->cf);
+    while((ch = CompoundFile_getc(fdb->cf)) != EOF){
+        if(ch == '\n'){
+            in_header = FALSE;
+        } else if((ch == '>') && (prev == '\n')){
+            pos = CompoundFile_ftell(fdb->cf)-1;
+            g_array_append_val(pos_list, pos);
+            g_array_append_val(cost_list, cost);
+            cost += seq_cost;
+            in_header = TRUE;
+        } else if((!in_header) && (!isspace(ch))){
+            cost++;
+            }
+        prev = ch;
+        }
+    /* The end of the database is the last possible boundary */
+    pos = CompoundFile_get_length(fdb->cf) - 1;
+    g_array_append_val(pos_list, pos);
+    g_array_append_val(cost_list, cost);
+    /* Put each boundary at the sequence start nearest its share */
+    for(i = 0; i < 2; i++){
+        target = (cost * (chunk_id - 1 + i)) / chunk_total;
+        boundary[i] = 0;
+        while(g_array_index(cost_list, guint64, boundary[i]) < target)
+            boundary[i]++;
+        if((boundary[i] > 0)
+        && ((g_array_index(cost_list, guint64, boundary[i]) - target)
+          > (target - g_array_index(cost_list, guint64, boundary[i]-1))))
+            boundary[i]--;
+        }
+    if(chunk_id == chunk_total)
+        boundary[1] = pos_list->len - 1;
+    (*start) = g_array_index(pos_list, CompoundFile_Pos, boundary[0]);
+    (*stop) = g_array_index(pos_list, CompoundFile_Pos, boundary[1]);
+    g_array_free(pos_list, TRUE);
+    g_array_free(cost_list, TRUE);
+    return;
+    }
+/* Chunks are split between sequences so that the residues
+ * (and the seq_cost added for each sequence) in each chunk
+ * are as close as possible to an equal share of the total.
+ * Every chunk job scans the whole database,
+ * so all of them find the same boundaries.
+ */
+
 FastaDB *FastaDB_open_list_with_limit(GPtrArray *path_list,
              Alphabet *alphabet, gint chunk_id, gint chunk_total){
     register FastaDB *fdb = FastaDB_open_list(path_list, alphabet);
-    register CompoundFile_Pos start, stop, total_length, chunk_size;
+    register FastaDB_ArgumentSet *fas
+           = FastaDB_ArgumentSet_create(NULL);
+    register CompoundFile_Pos total_length, chunk_size;
     register CompoundFile_Location *start_cfl, *stop_cfl;
+    CompoundFile_Pos start, stop;
     if(chunk_total){
         g_assert(chunk_id);
         if(chunk_total < 1)
             g_error("Chunk total [%d] is too small", chunk_total);
         if((chunk_id < 1) || (chunk_id > chunk_total))
             g_error("Chunk id should be between 1 and %d", chunk_total);
-        total_length = CompoundFile_get_length(fdb->cf);
-        chunk_size = total_length / chunk_total;
-        start = (chunk_id-1) * chunk_size;
-        start = FastaDB_find_next_start(fdb, start);
-        if(chunk_id == chunk_total){
-            stop = total_length - 1;
+        if((!fas->chunk_balance)
+        || (!strcasecmp(fas->chunk_balance, "bytes"))){
+            total_length = CompoundFile_get_length(fdb->cf);
+            chunk_size = total_length / chunk_total;
+            start = (chunk_id-1) * chunk_size;
+            start = FastaDB_find_next_start(fdb, start);
+            if(chunk_id == chunk_total){
+                stop = total_length - 1;
+            } else {
+                stop = chunk_id * chunk_size;
+                stop = FastaDB_find_next_start(fdb, stop);
+                }
+        } else if(!strcasecmp(fas->chunk_balance, "length")){
+            if(fas->chunk_seq_cost < 0)
+                g_error("Chunk sequence cost [%d] cannot be negative",
+                        fas->chunk_seq_cost);
+            FastaDB_find_balanced_limits(fdb, chunk_id, chunk_total,
+                                         fas->chunk_seq_cost,
+                                         &start, &stop);
         } else {
-            stop = chunk_id * chunk_size;
-            stop = FastaDB_find_next_start(fdb, stop);
+            g_error("Unknown chunk balance [%s]", fas->chunk_balance);
             }
         start_cfl = CompoundFile_Location_from_pos(fdb->cf, start);
         stop_cfl = CompoundFile_Location_from_pos(fdb->cf, stop);
@@ -30,6 +30,8 @@ extern "C" {
 
 typedef struct {
     gchar *suffix_filter;
+    gchar *chunk_balance;
+     gint  chunk_seq_cost;
 } FastaDB_ArgumentSet;
 
 FastaDB_ArgumentSet *FastaDB_ArgumentSet_create(Argument *arg);
@@ -71,6 +73,9 @@ typedef gboolean (*FastaDB_TraverseFunc)(FastaDB_Seq *fdbs,
                                Alphabet *alphabet);
     FastaDB *FastaDB_open_list_with_limit(GPtrArray *path_list,
              Alphabet *alphabet, gint chunk_id, gint chunk_total);
+    /* Chunks are balanced on file size, or on sequence length
+     * plus chunk_seq_cost for each sequence (see --chunkbalance).
+     */
     FastaDB *FastaDB_open(gchar *path, Alphabet *alphabet);
     FastaDB *FastaDB_share(FastaDB *fdb);
     FastaDB *FastaDB_dup(FastaDB *fdb); /* For use in a separate thread */
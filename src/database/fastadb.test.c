@@ -13,13 +13,179 @@
 *                                                                *
 \****************************************************************/
 
+#include <string.h> /* For strcmp() */
+#include <unistd.h> /* For getpid(), unlink() */
+
 #include "fastadb.h"
 
+static void test_write_fasta(gchar *path, gint *len_list, gint total){
+    register FILE *fp = fopen(path, "w");
+    register gint i, j;
+    guint32 seed = 11;
+    g_assert(fp);
+    for(i = 0; i < total; i++){
+        fprintf(fp, ">seq%d\n", i);
+        for(j = 0; j < len_list[i]; j++){
+            seed = seed*1103515245+12345;
+            fputc("ACGT"[(seed>>16)&3], fp);
+            if(!((j+1) % 60))
+                fputc('\n', fp);
+            }
+        if(j % 60)
+            fputc('\n', fp);
+        }
+    fclose(fp);
+    return;
+    }
+
+static void test_chunk_limits(gchar *path, gint chunk_total,
+                              gint *len_list, gint total,
+                              gint *chunk_list){
+    register GPtrArray *path_list = g_ptr_array_new();
+    register Alphabet *alphabet = Alphabet_create(Alphabet_Type_DNA,
+                                                  FALSE);
+    register FastaDB *fdb;
+    register FastaDB_Seq *fdbs;
+    register CompoundFile_Pos prev_stop = 0, length = 0;
+    register gint i, seq_id = 0;
+    gchar id[32];
+    g_ptr_array_add(path_list, path);
+    for(i = 1; i <= chunk_total; i++){
+        fdb = FastaDB_open_list_with_limit(path_list, alphabet,
+                                           i, chunk_total);
+        g_assert(fdb->cf->start_limit && fdb->cf->stop_limit);
+        /* Each chunk starts where the previous one stopped */
+        g_assert(fdb->cf->start_limit->pos == prev_stop);
+        g_assert(fdb->cf->stop_limit->pos >= prev_stop);
+        prev_stop = fdb->cf->stop_limit->pos;
+        length = ((CompoundFile_Element*)
+                  fdb->cf->element_list->pdata[0])->length;
+        /* Sequences are read once each, in file order */
+        while((fdbs = FastaDB_next(fdb, FastaDB_Mask_ID
+                                      |FastaDB_Mask_SEQ))){
+            g_assert(seq_id < total);
+            sprintf(id, "seq%d", seq_id);
+            g_assert(!strcmp(fdbs->seq->id, id));
+            g_assert(fdbs->seq->len == len_list[seq_id]);
+            chunk_list[seq_id++] = i;
+            FastaDB_Seq_destroy(fdbs);
+            }
+        FastaDB_close(fdb);
+        }
+    g_assert(prev_stop == length - 1);
+    g_assert(seq_id == total);
+    Alphabet_destroy(alphabet);
+    g_ptr_array_free(path_list, TRUE);
+    return;
+    }
+/* Sets chunk_list[i] to the chunk holding sequence i,
+ * checking that the chunks cover the file without gaps or overlaps.
+ */
+
+static void test_chunk_cover(gchar *path){
+    register gint i, total = 40, chunk_total;
+    register gint *len_list = g_new(gint, total),
+                  *chunk_list = g_new(gint, total);
+    guint32 seed = 5;
+    for(i = 0; i < total; i++){
+        seed = seed*1103515245+12345;
+        len_list[i] = 1 + ((seed>>16) % 500);
+        }
+    test_write_fasta(path, len_list, total);
+    for(chunk_total = 1; chunk_total <= 50; chunk_total++){
+        test_chunk_limits(path, chunk_total, len_list, total, chunk_list);
+        for(i = 1; i < total; i++)
+            g_assert(chunk_list[i-1] <= chunk_list[i]);
+        }
+    g_free(len_list);
+    g_free(chunk_list);
+    return;
+    }
+/* Includes more chunks than sequences, so some chunks are empty */
+
+static void test_chunk_long_seq(gchar *path){
+    register gint i, total = 21, long_id = 10, chunk_total = 4;
+    register gint *len_list = g_new(gint, total),
+                  *chunk_list = g_new(gint, total),
+                  *chunk_length = g_new0(gint, chunk_total+1);
+    register gboolean empty_chunk = FALSE;
+    for(i = 0; i < total; i++)
+        len_list[i] = 10;
+    len_list[long_id] = 10000;
+    test_write_fasta(path, len_list, total);
+    test_chunk_limits(path, chunk_total, len_list, total, chunk_list);
+    for(i = 0; i < total; i++)
+        chunk_length[chunk_list[i]] += len_list[i];
+    /* The long sequence has a chunk to itself */
+    g_assert(chunk_length[chunk_list[long_id]] == len_list[long_id]);
+    for(i = 1; i <= chunk_total; i++){
+        if(i == chunk_list[long_id])
+            continue;
+        if(!chunk_length[i])
+            empty_chunk = TRUE;
+        g_assert(chunk_length[i] < (len_list[long_id] / chunk_total));
+        }
+    g_assert(empty_chunk);
+    g_free(len_list);
+    g_free(chunk_list);
+    g_free(chunk_length);
+    return;
+    }
+/* Boundaries fall between sequences, so the chunks either side
+ * of a long sequence are left small or empty.
+ */
+
+static void test_chunk_seq_cost(gchar *path){
+    register FastaDB_ArgumentSet *fas = FastaDB_ArgumentSet_create(NULL);
+    register gint i, total = 20, chunk_total = 2, first_count;
+    register gint *len_list = g_new(gint, total),
+                  *chunk_list = g_new(gint, total);
+    /* One long sequence, then many short ones */
+    len_list[0] = 1000;
+    for(i = 1; i < total; i++)
+        len_list[i] = 10;
+    test_write_fasta(path, len_list, total);
+    fas->chunk_seq_cost = 0;
+    test_chunk_limits(path, chunk_total, len_list, total, chunk_list);
+    for(first_count = 0; first_count < total; first_count++)
+        if(chunk_list[first_count] != 1)
+            break;
+    g_assert(first_count == 1);
+    /* Per-sequence cost moves short sequences into the first chunk */
+    fas->chunk_seq_cost = 100;
+    test_chunk_limits(path, chunk_total, len_list, total, chunk_list);
+    for(first_count = 0; first_count < total; first_count++)
+        if(chunk_list[first_count] != 1)
+            break;
+    g_assert(first_count > 1);
+    g_assert(first_count < total);
+    fas->chunk_seq_cost = 0;
+    g_free(len_list);
+    g_free(chunk_list);
+    return;
+    }
+
+static void test_chunk_balance(void){
+    register FastaDB_ArgumentSet *fas = FastaDB_ArgumentSet_create(NULL);
+    register gchar *path = g_strdup_printf("%s/fastadb.test.%d.fa",
+                                           g_get_tmp_dir(), (gint)getpid());
+    fas->chunk_balance = "length"; /* The --chunkbalance default */
+    fas->chunk_seq_cost = 0;
+    test_chunk_cover(path);
+    test_chunk_long_seq(path);
+    test_chunk_seq_cost(path);
+    fas->chunk_balance = NULL;
+    unlink(path);
+    g_free(path);
+    return;
+    }
+
 gint Argument_main(Argument *arg){
     register FastaDB *fdb;
     register FastaDB_Seq *fdbs;
     register gchar *path;
     register Alphabet *alphabet;
+    test_chunk_balance();
     if(arg->argc == 2){
         path = arg->argv[1];
         alphabet = Alphabet_create(Alphabet_Type_UNKNOWN, FALSE);
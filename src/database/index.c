@@ -16,7 +16,6 @@
 #include <stdio.h>
 #include <math.h>    /* For pow() */
 #include <string.h>  /* For strlen() */
-#include <stdlib.h>  /* For qsort() */
 
 #include "index.h"
 #include "submat.h"
@@ -24,9 +23,13 @@
 #include "pqueue.h"
 #include "rangetree.h"
 #include "noitree.h"
+#include "radixsort.h"
 
 #define INDEX_HEADER_MAGIC (('e' << 16)|('s' << 8)|('i'))
-#define INDEX_HEADER_VERSION 3
+#define INDEX_HEADER_VERSION 5
+/* Version 3 and 4 indices (without a seed_mask or minimizer_window)
+ * are still readable.
+ */
 
 static off_t Index_ftell(FILE *fp){
     return ftello(fp);
@@ -81,7 +84,9 @@ static Index_Header *Index_Header_create(gint dataset_path_len,
                                          gint word_length,
                                          gint word_jump,
                                          gint word_ambiguity,
-                                         gint saturate_threshold){
+                                         gint saturate_threshold,
+                                         guint64 seed_mask,
+                                         gint minimizer_window){
     register Index_Header *index_header = g_new0(Index_Header, 1);
     index_header->magic = INDEX_HEADER_MAGIC;
     index_header->version = INDEX_HEADER_VERSION;
@@ -92,6 +97,8 @@ static Index_Header *Index_Header_create(gint dataset_path_len,
     index_header->word_jump = word_jump;
     index_header->word_ambiguity = word_ambiguity;
     index_header->saturate_threshold = saturate_threshold;
+    index_header->seed_mask = seed_mask;
+    index_header->minimizer_window = minimizer_window;
     return index_header;
     }
 
@@ -111,7 +118,9 @@ static void Index_Header_info(Index_Header *index_header){
               "    word_length [%lld]\n"
               "    word_jump [%lld]\n"
               "    word_ambiguity [%lld]\n"
-              "    saturate_threshold [%lld]\n",
+              "    saturate_threshold [%lld]\n"
+              "    seed_mask [%lld]\n"
+              "    minimizer_window [%lld]\n",
            index_header->magic,
            index_header->version,
            index_header->type,
@@ -119,7 +128,9 @@ static void Index_Header_info(Index_Header *index_header){
            index_header->word_length,
            index_header->word_jump,
            index_header->word_ambiguity,
-           index_header->saturate_threshold);
+           index_header->saturate_threshold,
+           index_header->seed_mask,
+           index_header->minimizer_window);
     return;
     }
 #endif /* 0 */
@@ -135,6 +146,8 @@ static void Index_Header_write(Index_Header *index_header, FILE *fp){
     BitArray_write_int(index_header->word_jump, fp);
     BitArray_write_int(index_header->word_ambiguity, fp);
     BitArray_write_int(index_header->saturate_threshold, fp);
+    BitArray_write_int(index_header->seed_mask, fp);
+    BitArray_write_int(index_header->minimizer_window, fp);
     /**/
     return;
     }
@@ -145,7 +158,8 @@ static Index_Header *Index_Header_read(FILE *fp){
     if(index_header->magic != INDEX_HEADER_MAGIC)
         g_error("Bad magic number in index file");
     index_header->version = BitArray_read_int(fp);
-    if(index_header->version != INDEX_HEADER_VERSION)
+    if((index_header->version < 3)
+    || (index_header->version > INDEX_HEADER_VERSION))
         g_error("Incompatible index file version");
     index_header->type = BitArray_read_int(fp);
     index_header->dataset_path_len = BitArray_read_int(fp);
@@ -154,6 +168,14 @@ static Index_Header *Index_Header_read(FILE *fp){
     index_header->word_jump  = BitArray_read_int(fp);
     index_header->word_ambiguity = BitArray_read_int(fp);
     index_header->saturate_threshold = BitArray_read_int(fp);
+    if(index_header->version < 4)
+        index_header->seed_mask = 0;
+    else
+        index_header->seed_mask = BitArray_read_int(fp);
+    if(index_header->version < 5)
+        index_header->minimizer_window = 0;
+    else
+        index_header->minimizer_window = BitArray_read_int(fp);
     /* Index_Header_info(index_header); */
     return index_header;
     }
@@ -188,6 +210,81 @@ static void Index_Width_destroy(Index_Width *index_width){
 
 /**/
 
+Index_Minimizer *Index_Minimizer_create(gint window, VFSM_Int invalid_leaf){
+    register Index_Minimizer *minimizer = g_new(Index_Minimizer, 1);
+    g_assert(window > 0);
+    minimizer->window = window;
+    minimizer->invalid_leaf = invalid_leaf;
+    minimizer->ring = g_new(Index_MinimizerWord, window);
+    minimizer->count = 0;
+    minimizer->min_count = 0;
+    minimizer->last_pos = G_MININT;
+    return minimizer;
+    }
+
+void Index_Minimizer_destroy(Index_Minimizer *minimizer){
+    g_free(minimizer->ring);
+    g_free(minimizer);
+    return;
+    }
+
+guint64 Index_Minimizer_hash(guint64 key){
+    key ^= key >> 33;
+    key *= (guint64)G_GINT64_CONSTANT(0xff51afd7ed558ccd);
+    key ^= key >> 33;
+    key *= (guint64)G_GINT64_CONSTANT(0xc4ceb9fe1a85ec53);
+    key ^= key >> 33;
+    return key;
+    }
+/* An invertible mix of the leaf, so words are not ranked
+ * lexicographically (which would favour low complexity words).
+ */
+
+Index_MinimizerWord *Index_Minimizer_push(Index_Minimizer *minimizer,
+                                          gint pos, VFSM_Int leaf){
+    register gint i, start;
+    register Index_MinimizerWord *word
+        = &minimizer->ring[minimizer->count % minimizer->window],
+                                 *min_word;
+    word->hash = (leaf == minimizer->invalid_leaf)
+               ? G_MAXUINT64 : Index_Minimizer_hash(leaf);
+    word->leaf = leaf;
+    word->pos = pos;
+    start = minimizer->count - minimizer->window + 1;
+    if((minimizer->count == 0) || (minimizer->min_count < start)){
+        /* Minimizer has left the window: rescan */
+        if(start < 0)
+            start = 0;
+        minimizer->min_count = start;
+        for(i = start+1; i <= minimizer->count; i++)
+            if(minimizer->ring[i % minimizer->window].hash
+             < minimizer->ring[minimizer->min_count
+                             % minimizer->window].hash)
+                minimizer->min_count = i;
+    } else if(word->hash < minimizer->ring[minimizer->min_count
+                                          % minimizer->window].hash){
+        minimizer->min_count = minimizer->count;
+        }
+    minimizer->count++;
+    if(minimizer->count < minimizer->window)
+        return NULL;
+    min_word = &minimizer->ring[minimizer->min_count % minimizer->window];
+    if((min_word->leaf == minimizer->invalid_leaf)
+    || (min_word->pos == minimizer->last_pos))
+        return NULL;
+    minimizer->last_pos = min_word->pos;
+    return min_word;
+    }
+/* Words must be pushed for every position (including invalid words)
+ * so that windows are defined by sequence content alone.
+ * The leftmost minimum is selected on ties,
+ * and each minimizer is only returned once.
+ * Any exact match of at least (window + word_length - 1)
+ * therefore shares a minimizer between query and target.
+ */
+
+/**/
+
 typedef void (*Index_WordVisit_Func)(Index *index, Index_Strand *strand,
                                      gint seq_id,
                                      gint seq_pos, gint leaf_id,
@@ -283,11 +380,94 @@ static void Index_visit_seq_words_ambig(Index *index, Index_Strand *index_strand
 /* FIXME: needs to work with softmasked sequences */
 /* FIXME: optimisation: remove strlen() call */
 
+static void Index_visit_seq_words_spaced(Index *index,
+                                  Index_Strand *index_strand,
+                                  gint seq_id, Sequence *seq,
+                                  Index_WordVisit_Func iwvf, gint frame,
+                                  gpointer user_data){
+    register gint i, pos, len = seq->len;
+    register gchar *str = Sequence_get_str(seq);
+    register SeedPattern *seed_pattern = index->seed_pattern;
+    register VFSM_Int leaf;
+    register Index_Minimizer *minimizer = NULL;
+    register Index_MinimizerWord *word;
+    if(index->header->minimizer_window)
+        minimizer = Index_Minimizer_create(index->header->minimizer_window,
+                                           index->vfsm->lrw);
+    for(i = 0; (i + seed_pattern->span) <= len;
+        i += index->header->word_jump){
+        leaf = SeedPattern_get_leaf(seed_pattern, index->vfsm, str+i);
+        pos = i + seed_pattern->run_start;
+        if(minimizer){
+            word = Index_Minimizer_push(minimizer, pos, leaf);
+            if(!word)
+                continue;
+            pos = word->pos;
+            leaf = word->leaf;
+        } else if(leaf == index->vfsm->lrw){
+            continue;
+            }
+        if(frame)
+            pos = (pos * 3) + frame - 1;
+        iwvf(index, index_strand, seq_id, pos, leaf, user_data);
+        }
+    if(minimizer)
+        Index_Minimizer_destroy(minimizer);
+    g_free(str);
+    return;
+    }
+/* Addresses are recorded at the start of the longest run
+ * of matching positions, which is where the HSPs are seeded.
+ */
+
+static void Index_visit_seq_words_minimizer(Index *index,
+                                  Index_Strand *index_strand,
+                                  gint seq_id, Sequence *seq,
+                                  Index_WordVisit_Func iwvf, gint frame,
+                                  gpointer user_data){
+    register gint i, pos;
+    register gchar *str = Sequence_get_str(seq);
+    register VFSM_Int state = 0, leaf;
+    register Index_Minimizer *minimizer
+        = Index_Minimizer_create(index->header->minimizer_window,
+                                 index->vfsm->lrw);
+    register Index_MinimizerWord *word;
+    for(i = 0; str[i]; i++){
+        if(!index->vfsm->index[(guchar)str[i]]){
+            state = 0;
+            leaf = index->vfsm->lrw;
+        } else {
+            state = VFSM_change_state_M(index->vfsm, state, (guchar)str[i]);
+            leaf = VFSM_state_is_leaf(index->vfsm, state)
+                 ? VFSM_state2leaf(index->vfsm, state)
+                 : index->vfsm->lrw;
+            }
+        word = Index_Minimizer_push(minimizer,
+                                    i-(index->vfsm->depth-1), leaf);
+        if(!word)
+            continue;
+        pos = word->pos;
+        if(frame)
+            pos = (pos * 3) + frame - 1;
+        iwvf(index, index_strand, seq_id, pos, word->leaf, user_data);
+        }
+    Index_Minimizer_destroy(minimizer);
+    g_free(str);
+    return;
+    }
+/* FIXME: needs to work with softmasked sequences */
+
 static void Index_visit_seq_words(Index *index, Index_Strand *index_strand,
                                   gint seq_id, Sequence *seq,
                                   Index_WordVisit_Func iwvf, gint frame,
                                   gpointer user_data){
-    if(index->header->word_ambiguity > 1)
+    if(index->seed_pattern)
+        Index_visit_seq_words_spaced(index, index_strand, seq_id, seq,
+                              iwvf, frame, user_data);
+    else if(index->header->minimizer_window)
+        Index_visit_seq_words_minimizer(index, index_strand, seq_id, seq,
+                              iwvf, frame, user_data);
+    else if(index->header->word_ambiguity > 1)
         Index_visit_seq_words_ambig(index, index_strand, seq_id, seq,
                               iwvf, frame, user_data);
     else
@@ -474,23 +654,31 @@ static void Index_AddressList_write(Index_AddressList *address_list,
     }
 /* FIXME: optimisation: clear and reuse BitArray */
 
-static int Index_Address_compare(const void *a, const void *b){
-    register Index_Address *addr_a = (Index_Address*)a,
-                           *addr_b = (Index_Address*)b;
-    if(addr_a->sequence_id == addr_b->sequence_id)
-        return addr_a->position - addr_b->position;
-    return addr_a->sequence_id - addr_b->sequence_id;
+static guint64 Index_Address_key(gconstpointer data, gpointer user_data){
+    register const Index_Address *address = data;
+    return RadixSort_pair_key(address->sequence_id, address->position);
     }
 
 static void Index_AddressList_sort(Index_AddressList *address_list){
-    qsort(address_list->address_list, address_list->found,
-          sizeof(Index_Address), Index_Address_compare);
+    RadixSort_sort(address_list->address_list, address_list->found,
+                   sizeof(Index_Address), Index_Address_key, NULL);
     return;
     }
 /* FIXME: optimisation: avoid this sort, by traversing all frames together,
  *                      or using more efficient 3-way merge
  */
 
+static guint64 Index_AddressList_sort_memory_usage(Index *index,
+                                                   Index_Strand *index_strand){
+    if(!(index->header->type & 1)) /* only sorted when is_translated */
+        return 0;
+    return RadixSort_memory_usage(index_strand->header.max_index_length,
+                                  sizeof(Index_Address));
+    }
+/* Address lists are sorted one at a time,
+ * so the workspace for the largest must be reserved.
+ */
+
 /**/
 
 static GArray *Index_find_pass_boundaries(Index *index,
@@ -601,7 +789,9 @@ static void Index_report_word_list(Index *index, Index_Strand *index_strand,
     register guint64 available_memory = ((guint64)memory_limit << 20); /* Mb */
     register guint64 used_memory = Index_memory_usage(index)
                                  + Index_Strand_memory_usage(index_strand,
-                                                             index->vfsm);
+                                                             index->vfsm)
+                                 + Index_AddressList_sort_memory_usage(
+                                       index, index_strand);
     register GArray *pass_boundary_list;
     register gint i, curr, prev = 0;
     register Index_AddressData *address_data;
@@ -746,11 +936,31 @@ static void Index_Strand_destroy(Index_Strand *index_strand){
 
 Index *Index_create(Dataset *dataset, gboolean is_translated, gint word_length,
                     gint word_jump, gint word_ambiguity, gint saturate_threshold,
-                    gchar *index_path, gchar *dataset_path, gint memory_limit){
+                    gchar *index_path, gchar *dataset_path, gint memory_limit,
+                    gchar *seed_pattern, gint minimizer_window){
     register Index *index = g_new0(Index, 1);
     register gchar *member;
     register Alphabet *alphabet;
     index->ref_count = 1;
+    if(seed_pattern){
+        index->seed_pattern = SeedPattern_create(seed_pattern);
+        if(index->seed_pattern->weight != word_length)
+            g_error("Seed pattern [%s] weight (%d) must match"
+                    " the word length (%d)",
+                    seed_pattern, index->seed_pattern->weight, word_length);
+        if(word_ambiguity > 1)
+            g_error("Word ambiguity not implemented for seed patterns");
+        if(is_translated)
+            g_error("Seed patterns not implemented for translated indices");
+        }
+    if(minimizer_window < 0)
+        g_error("Minimizer window cannot be negative");
+    if(minimizer_window){
+        if(word_jump != 1)
+            g_error("Word jump must be 1 with a minimizer window");
+        if(word_ambiguity > 1)
+            g_error("Word ambiguity not implemented with minimizers");
+        }
     /* Open index path for reading */
     index->fp = fopen(index_path, "r");
     if(index->fp){
@@ -766,7 +976,11 @@ Index *Index_create(Dataset *dataset, gboolean is_translated, gint word_length,
     index->header = Index_Header_create(strlen(dataset_path),
                                         is_translated, word_length,
                                         word_jump, word_ambiguity,
-                                        saturate_threshold);
+                                        saturate_threshold,
+                                        index->seed_pattern
+                                        ? SeedPattern_get_mask(
+                                              index->seed_pattern)
+                                        : 0, minimizer_window);
     if(is_translated){
         alphabet = Alphabet_create(Alphabet_Type_PROTEIN, FALSE);
         member = (gchar*)alphabet->member;
@@ -852,6 +1066,8 @@ void Index_destroy(Index *index){
     Index_Header_destroy(index->header);
     VFSM_destroy(index->vfsm);
     Index_Width_destroy(index->width);
+    if(index->seed_pattern)
+        SeedPattern_destroy(index->seed_pattern);
     if(index->forward)
         Index_Strand_destroy(index->forward);
     if(index->revcomp)
@@ -871,13 +1087,17 @@ void Index_info(Index *index){
             "            word length: %d\n"
             "              word jump: %d\n"
             "         word ambiguity: %d\n"
-            "     saturate threshold: %d\n\n",
+            "     saturate threshold: %d\n"
+            "           seed pattern: %s\n"
+            "       minimizer window: %d\n\n",
             (gint)index->header->version,
             (index->header->type & 1) ? "translated" : "normal",
             (gint)index->header->word_length,
             (gint)index->header->word_jump,
             (gint)index->header->word_ambiguity,
-            (gint)index->header->saturate_threshold);
+            (gint)index->header->saturate_threshold,
+            index->seed_pattern ? index->seed_pattern->pattern : "none",
+            (gint)index->header->minimizer_window);
     return;
     }
 
@@ -936,6 +1156,11 @@ Index *Index_open(gchar *index_path){
     if(!index->fp)
         g_error("Could not open index [%s]", index_path);
     index->header = Index_Header_read(index->fp);
+    if(index->header->seed_mask)
+        index->seed_pattern = SeedPattern_create_from_mask(
+                                  index->header->seed_mask);
+    else
+        index->seed_pattern = NULL;
     index->dataset_path = g_new(gchar, index->header->dataset_path_len+1);
     index->dataset_path[index->header->dataset_path_len] = '\0';
     fread(index->dataset_path, sizeof(gchar),
@@ -969,13 +1194,104 @@ VFSM_Int leaf;
     gint query_pos;
 } Index_WordSeed;
 
-static void Index_get_query_word_list(Index *index, Index_Strand *index_strand,
+static void Index_get_query_word_list_spaced(Index *index,
+                                      Index_Strand *index_strand,
+                                      Sequence *query, GArray *word_seed_list,
+                                      gint frame, HSP_Param *hsp_param){
+    register gint i, len = query->len;
+    register gchar *str = Sequence_get_str(query);
+    register SeedPattern *seed_pattern = index->seed_pattern;
+    register Index_Minimizer *minimizer = NULL;
+    register Index_MinimizerWord *word;
+    Index_WordSeed seed;
+    if(index->header->minimizer_window)
+        minimizer = Index_Minimizer_create(index->header->minimizer_window,
+                                           index->vfsm->lrw);
+    for(i = 0; (i + seed_pattern->span) <= len; i++){
+        seed.leaf = SeedPattern_get_leaf(seed_pattern, index->vfsm, str+i);
+        seed.query_pos = i + seed_pattern->run_start;
+        if(minimizer){
+            word = Index_Minimizer_push(minimizer, seed.query_pos, seed.leaf);
+            if(!word)
+                continue;
+            seed.leaf = word->leaf;
+            seed.query_pos = word->pos;
+        } else if(seed.leaf == index->vfsm->lrw){
+            continue;
+            }
+        if((index_strand->word_table[seed.leaf] >= 0) || hsp_param->wordhood){
+            if(frame)
+                seed.query_pos = (seed.query_pos * 3) + frame - 1;
+            g_array_append_val(word_seed_list, seed);
+            }
+        }
+    if(minimizer)
+        Index_Minimizer_destroy(minimizer);
+    g_free(str);
+    return;
+    }
+/* Query positions are offset by run_start to match the index addresses */
+
+static void Index_get_query_word_list_minimizer(Index *index,
+                                      Index_Strand *index_strand,
                                       Sequence *query, GArray *word_seed_list,
                                       gint frame, HSP_Param *hsp_param){
     register gint i;
     register gchar *str = Sequence_get_str(query);
+    register VFSM_Int state = 0, leaf;
+    register Index_Minimizer *minimizer
+        = Index_Minimizer_create(index->header->minimizer_window,
+                                 index->vfsm->lrw);
+    register Index_MinimizerWord *word;
+    Index_WordSeed seed;
+    for(i = 0; str[i]; i++){
+        if(!index->vfsm->index[(guchar)str[i]]){
+            state = 0;
+            leaf = index->vfsm->lrw;
+        } else {
+            state = VFSM_change_state_M(index->vfsm, state, (guchar)str[i]);
+            leaf = VFSM_state_is_leaf(index->vfsm, state)
+                 ? VFSM_state2leaf(index->vfsm, state)
+                 : index->vfsm->lrw;
+            }
+        word = Index_Minimizer_push(minimizer,
+                                    i-(index->header->word_length-1), leaf);
+        if(!word)
+            continue;
+        seed.leaf = word->leaf;
+        if((index_strand->word_table[seed.leaf] >= 0) || hsp_param->wordhood){
+            seed.query_pos = word->pos;
+            if(frame)
+                seed.query_pos = (seed.query_pos * 3) + frame - 1;
+            g_array_append_val(word_seed_list, seed);
+            }
+        }
+    Index_Minimizer_destroy(minimizer);
+    g_free(str);
+    return;
+    }
+/* The query is sampled in the same way as the index,
+ * so that shared exact matches still yield a common word.
+ */
+
+static void Index_get_query_word_list(Index *index, Index_Strand *index_strand,
+                                      Sequence *query, GArray *word_seed_list,
+                                      gint frame, HSP_Param *hsp_param){
+    register gint i;
+    register gchar *str;
     register VFSM_Int state = 0;
     Index_WordSeed seed;
+    if(index->seed_pattern){
+        Index_get_query_word_list_spaced(index, index_strand, query,
+                                         word_seed_list, frame, hsp_param);
+        return;
+        }
+    if(index->header->minimizer_window){
+        Index_get_query_word_list_minimizer(index, index_strand, query,
+                                         word_seed_list, frame, hsp_param);
+        return;
+        }
+    str = Sequence_get_str(query);
     for(i = 0; str[i]; i++){
         if(!index->vfsm->index[(guchar)str[i]]){
             state = 0;
@@ -997,6 +1313,7 @@ static void Index_get_query_word_list(Index *index, Index_Strand *index_strand,
     }
 /* FIXME: needs to work with softmasked sequences */
 
+
 typedef struct {
     gint start;
     gint length;
@@ -1221,19 +1538,14 @@ typedef struct {
           GArray  *word_seed_list;
 } Index_Word_Collect_Traverse_Data;
 
-static gboolean Index_WordHood_collect_traverse_func(gchar *word, gint score,
-                                                     gpointer user_data){
-    register VFSM_Int state;
-    VFSM_Int leaf;
+static gboolean Index_WordHood_collect_traverse_func(VFSM_Int leaf,
+                                   gint score, gpointer user_data){
     register Index_Word_Collect_Traverse_Data *iwctd = user_data;
-    state = VFSM_word2state(iwctd->index->vfsm, word);
-    leaf = VFSM_state2leaf(iwctd->index->vfsm, state);
     iwctd->seed.leaf = leaf;
     if(iwctd->index_strand->word_table[leaf] >= 0)
         g_array_append_val(iwctd->word_seed_list, iwctd->seed);
     return FALSE;
     }
-/* FIXME: optimisation: change to VFSM-based wordhoods */
 
 static void Index_expand_word_seed_list(Index *index,
                                         Index_Strand *index_strand,
@@ -1262,8 +1574,9 @@ static void Index_expand_word_seed_list(Index *index,
         state = VFSM_leaf2state(index->vfsm, init_seed_list[i].leaf);
         VFSM_state2word(index->vfsm, state, word);
         iwctd.seed.query_pos = init_seed_list[i].query_pos;
-        WordHood_traverse(wh, Index_WordHood_collect_traverse_func,
-                          word, index->header->word_length, &iwctd);
+        WordHood_traverse_VFSM(wh, index->vfsm,
+                               Index_WordHood_collect_traverse_func,
+                               word, index->header->word_length, &iwctd);
         }
     g_free(init_seed_list);
     g_free(word);
@@ -1458,6 +1771,14 @@ static GPtrArray *Index_get_HSPsets_interval(Index *index, HSP_Param *hsp_param,
     register gboolean free_word_seed_list = FALSE;
     /* Traverse the query using VSFM */
     g_assert(index_strand);
+    if(index->seed_pattern){
+        if((hsp_param->match->query->advance != 1)
+        || (hsp_param->match->target->advance != 1))
+            g_error("Seed patterns not implemented for translated matches");
+        if(hsp_param->seedlen > index->seed_pattern->run_length)
+            HSP_Param_set_seedlen(hsp_param,
+                                  index->seed_pattern->run_length);
+        }
     if(!word_seed_list){
         word_seed_list = Index_get_word_seed_list(index, query,
                                                   index_strand, hsp_param);
@@ -1607,12 +1928,10 @@ static void Index_Interval_NOI_Tree_traverse(gint start, gint length,
     }
 /* Need to have interval_list, interval, target_id */
 
-static int Index_Geneseed_Subseed_compare(const void *a,
-                                          const void *b){
-    register Index_Subseed **subseed_a = (Index_Subseed**)a,
-                           **subseed_b = (Index_Subseed**)b;
-    return (*subseed_a)->hsp->target_start
-         - (*subseed_b)->hsp->target_start;
+static guint64 Index_Geneseed_Subseed_key(gconstpointer data,
+                                          gpointer user_data){
+    register const Index_Subseed *subseed = data;
+    return subseed->hsp->target_start;
     }
 
 #if 0
@@ -1623,9 +1942,9 @@ static void Index_Geneseed_get_regions(Index_Geneseed *index_geneseed,
     register Index_Subseed *subseed;
     register HSP *hsp;
     NOI_Tree_delta_init(index_geneseed->coverage, nts);
-    /* FIXME: optimisation replace qsort of HSPset with radix type sort */
-    qsort(index_geneseed->subseed_list->pdata, index_geneseed->subseed_list->len,
-          sizeof(gpointer), Index_Geneseed_Subseed_compare);
+    RadixSort_sort_pointers(index_geneseed->subseed_list->pdata,
+                            index_geneseed->subseed_list->len,
+                            Index_Geneseed_Subseed_key, NULL);
     for(i = 0; i < index_geneseed->subseed_list->len; i++){
         subseed = index_geneseed->subseed_list->pdata[i];
         hsp = subseed->hsp;
@@ -1661,9 +1980,9 @@ static void Index_Geneseed_get_regions(Index_Geneseed *index_geneseed,
     register Index_Subseed *subseed;
     register HSP *hsp;
     NOI_Tree_delta_init(index_geneseed->coverage, nts);
-    /* FIXME: optimisation replace qsort of HSPset with radix type sort */
-    qsort(index_geneseed->subseed_list->pdata, index_geneseed->subseed_list->len,
-          sizeof(gpointer), Index_Geneseed_Subseed_compare);
+    RadixSort_sort_pointers(index_geneseed->subseed_list->pdata,
+                            index_geneseed->subseed_list->len,
+                            Index_Geneseed_Subseed_key, NULL);
     for(i = 0; i < index_geneseed->subseed_list->len; i++){
         subseed = index_geneseed->subseed_list->pdata[i];
         hsp = subseed->hsp;
@@ -1692,12 +2011,9 @@ static void Index_Geneseed_get_regions(Index_Geneseed *index_geneseed,
 
 /**/
 
-static int Index_Geneseed_compare(const void *a,
-                                  const void *b){
-    register Index_Geneseed **geneseed_a = (Index_Geneseed**)a,
-                            **geneseed_b = (Index_Geneseed**)b;
-    return (*geneseed_a)->target_id
-         - (*geneseed_b)->target_id;
+static guint64 Index_Geneseed_key(gconstpointer data, gpointer user_data){
+    register const Index_Geneseed *index_geneseed = data;
+    return index_geneseed->target_id;
     }
 
 static Index_Geneseed_List *Index_Geneseed_List_create(GPtrArray *hspset_list,
@@ -1721,9 +2037,9 @@ static Index_Geneseed_List *Index_Geneseed_List_create(GPtrArray *hspset_list,
         g_ptr_array_add(geneseed_list->index_geneseed_list, index_geneseed);
         }
     g_assert(hspset_list->len == geneseed_list->index_geneseed_list->len);
-    qsort(geneseed_list->index_geneseed_list->pdata,
-          geneseed_list->index_geneseed_list->len,
-          sizeof(gpointer), Index_Geneseed_compare);
+    RadixSort_sort_pointers(geneseed_list->index_geneseed_list->pdata,
+                            geneseed_list->index_geneseed_list->len,
+                            Index_Geneseed_key, NULL);
     return geneseed_list;
     }
 
@@ -1803,11 +2119,9 @@ static gboolean Index_Geneseed_refine_RangeTree_report_rev(gint x, gint y,
     return FALSE;
     }
 
-static int Index_HSPset_compare(const void *a, const void *b){
-    register Index_HSPset **index_hspset_a = (Index_HSPset**)a,
-                          **index_hspset_b = (Index_HSPset**)b;
-    return (*index_hspset_a)->target_id
-         - (*index_hspset_b)->target_id;
+static guint64 Index_HSPset_key(gconstpointer data, gpointer user_data){
+    register const Index_HSPset *index_hspset = data;
+    return index_hspset->target_id;
     }
 
 static void Index_Geneseed_refine_subseeds(
@@ -1820,8 +2134,8 @@ static void Index_Geneseed_refine_subseeds(
     register GPtrArray *swap_list;
     register Index_Subseed *subseed;
     /* Sort subseed_hsp_list by target_id */
-    qsort(subseed_hsp_list->pdata, subseed_hsp_list->len,
-          sizeof(gpointer), Index_HSPset_compare);
+    RadixSort_sort_pointers(subseed_hsp_list->pdata, subseed_hsp_list->len,
+                            Index_HSPset_key, NULL);
     /* For each subseed HSPset */
     for(i = 0; i < subseed_hsp_list->len; i++){
         index_hspset = subseed_hsp_list->pdata[i];
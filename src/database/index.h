@@ -33,6 +33,7 @@ extern "C" {
 #include "vfsm.h"
 #include "hspset.h"
 #include "bitarray.h"
+#include "seedpattern.h"
 
 /* File format:
    Header
@@ -62,6 +63,8 @@ typedef struct {
     guint64  word_jump;
     guint64  word_ambiguity;
     guint64  saturate_threshold;
+    guint64  seed_mask;           /* 0 for contiguous words */
+    guint64  minimizer_window;    /* 0 when every word is indexed */
 } Index_Header;
 
 typedef struct {
@@ -108,6 +111,7 @@ typedef struct {
        Index_Header *header;
                VFSM *vfsm;
         Index_Width *width;
+        SeedPattern *seed_pattern; /* NULL for contiguous words */
               /**/
        Index_Strand *forward;
        Index_Strand *revcomp; /* Only used when index is translated */
@@ -116,11 +120,47 @@ typedef struct {
 #endif /* USE_PTHREADS */
 } Index;
 
+/**/
+
+typedef struct {
+    guint64 hash;
+   VFSM_Int leaf;
+       gint pos;
+} Index_MinimizerWord;
+
+typedef struct {
+                   gint  window;
+               VFSM_Int  invalid_leaf;
+    Index_MinimizerWord *ring;
+                   gint  count;
+                   gint  min_count;
+                   gint  last_pos;
+} Index_Minimizer;
+/* A ring of the most recent window words,
+ * with min_count recording when the current minimizer was added.
+ */
+
+    Index_Minimizer *Index_Minimizer_create(gint window,
+                                            VFSM_Int invalid_leaf);
+               void  Index_Minimizer_destroy(Index_Minimizer *minimizer);
+            guint64  Index_Minimizer_hash(guint64 key);
+Index_MinimizerWord *Index_Minimizer_push(Index_Minimizer *minimizer,
+                                          gint pos, VFSM_Int leaf);
+/* Words must be pushed for every position, including invalid_leaf.
+ * Returns each new minimizer once, or NULL.
+ */
+
 /**/
 
    Index *Index_create(Dataset *dataset, gboolean is_translated, gint word_length,
                        gint word_jump, gint word_ambiguity, gint saturate_threshold,
-                       gchar *index_path, gchar *dataset_path, gint memory_limit);
+                       gchar *index_path, gchar *dataset_path, gint memory_limit,
+                       gchar *seed_pattern, gint minimizer_window);
+/* seed_pattern may be NULL for contiguous words,
+ * otherwise the pattern weight must be the same as word_length.
+ * When minimizer_window is non-zero, only the minimizer of each
+ * window of minimizer_window consecutive words is indexed.
+ */
    Index *Index_share(Index *index);
     void  Index_destroy(Index *index);
     void  Index_info(Index *index);
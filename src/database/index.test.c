@@ -14,8 +14,217 @@
 \****************************************************************/
 
 #include <string.h>
+#include <unistd.h>
 #include "index.h"
 
+#define TEST_WORD_LENGTH 8
+#define TEST_INVALID_LEAF (1 << (TEST_WORD_LENGTH << 1))
+
+static void test_random_seq(gchar *seq, gint len, guint32 *seed){
+    register gint i;
+    for(i = 0; i < len; i++){
+        (*seed) = ((*seed) * 1103515245) + 12345;
+        seq[i] = "ACGT"[((*seed) >> 16) & 3];
+        }
+    seq[len] = '\0';
+    return;
+    }
+
+static VFSM_Int test_word_leaf(gchar *word){
+    register gint i;
+    register VFSM_Int leaf = 0;
+    for(i = 0; i < TEST_WORD_LENGTH; i++){
+        switch(word[i]){
+            case 'A': leaf = (leaf << 2);     break;
+            case 'C': leaf = (leaf << 2) | 1; break;
+            case 'G': leaf = (leaf << 2) | 2; break;
+            case 'T': leaf = (leaf << 2) | 3; break;
+            default:  return TEST_INVALID_LEAF;
+            }
+        }
+    return leaf;
+    }
+/* Packs the word into 2 bits per base, as stand-in VFSM leaves */
+
+static void test_minimizer_collect(gchar *seq, gint window,
+                                   gchar *leaf_seen, gboolean *shared){
+    register Index_Minimizer *minimizer
+        = Index_Minimizer_create(window, TEST_INVALID_LEAF);
+    register Index_MinimizerWord *word;
+    register gint i, last_pos = -1, len = strlen(seq);
+    for(i = 0; (i + TEST_WORD_LENGTH) <= len; i++){
+        word = Index_Minimizer_push(minimizer, i, test_word_leaf(seq+i));
+        if(!word)
+            continue;
+        /* Each minimizer position is returned once, in order */
+        g_assert(word->pos > last_pos);
+        g_assert(word->pos > (i - window));
+        last_pos = word->pos;
+        if(shared){
+            if(leaf_seen[word->leaf])
+                (*shared) = TRUE;
+        } else {
+            leaf_seen[word->leaf] = TRUE;
+            }
+        }
+    Index_Minimizer_destroy(minimizer);
+    return;
+    }
+
+static void test_minimizer_shared_run(void){
+    register gint window, trial, run, offset, flank = 100,
+                  target_len = 500;
+    register gchar *target = g_new(gchar, target_len+1),
+                   *query = g_new(gchar, target_len+1),
+                   *leaf_seen = g_new(gchar, TEST_INVALID_LEAF);
+    guint32 seed = 1;
+    gboolean shared;
+    for(window = 1; window <= 20; window++){
+        run = window + TEST_WORD_LENGTH - 1;
+        for(trial = 0; trial < 50; trial++){
+            test_random_seq(target, target_len, &seed);
+            memset(leaf_seen, 0, sizeof(gchar)*TEST_INVALID_LEAF);
+            test_minimizer_collect(target, window, leaf_seen, NULL);
+            offset = (seed >> 16) % (target_len - run);
+            test_random_seq(query, flank, &seed);
+            strncpy(query+flank, target+offset, run);
+            test_random_seq(query+flank+run, flank, &seed);
+            shared = FALSE;
+            test_minimizer_collect(query, window, leaf_seen, &shared);
+            g_assert(shared);
+            }
+        }
+    g_free(target);
+    g_free(query);
+    g_free(leaf_seen);
+    return;
+    }
+/* Any exact run of (window + word_length - 1)
+ * must give the query and target a shared minimizer.
+ */
+
+static void test_minimizer_ties(void){
+    register gint i, window = 5;
+    register Index_Minimizer *minimizer
+        = Index_Minimizer_create(window, TEST_INVALID_LEAF);
+    register Index_MinimizerWord *word;
+    for(i = 0; i < 20; i++){
+        word = Index_Minimizer_push(minimizer, i, 42);
+        if(i < (window-1)){
+            g_assert(!word);
+        } else {
+            /* The leftmost of equal words is always chosen */
+            g_assert(word);
+            g_assert(word->pos == (i - window + 1));
+            g_assert(word->leaf == 42);
+            }
+        }
+    Index_Minimizer_destroy(minimizer);
+    return;
+    }
+
+static void test_minimizer_dedupe(void){
+    register gint i, j, window = 6;
+    register Index_Minimizer *minimizer
+        = Index_Minimizer_create(window, TEST_INVALID_LEAF);
+    register Index_MinimizerWord *word;
+    register VFSM_Int min_leaf = 0, leaf;
+    /* Find the lowest ranked leaf of a small set */
+    for(leaf = 1; leaf < 64; leaf++)
+        if(Index_Minimizer_hash(leaf) < Index_Minimizer_hash(min_leaf))
+            min_leaf = leaf;
+    for(i = 0, leaf = 0; i < (window << 1) - 1; i++){
+        if(i == (window-1)){
+            word = Index_Minimizer_push(minimizer, i, min_leaf);
+        } else {
+            if(leaf == min_leaf)
+                leaf++;
+            word = Index_Minimizer_push(minimizer, i, leaf++);
+            }
+        if(i == (window-1)){
+            g_assert(word);
+            g_assert(word->pos == i);
+            g_assert(word->leaf == min_leaf);
+        } else {
+            /* Still in the ring, so not returned again */
+            g_assert(!word);
+            }
+        }
+    Index_Minimizer_destroy(minimizer);
+    /* Invalid words are never returned */
+    minimizer = Index_Minimizer_create(window, TEST_INVALID_LEAF);
+    for(j = 0; j < (window << 1); j++)
+        g_assert(!Index_Minimizer_push(minimizer, j, TEST_INVALID_LEAF));
+    Index_Minimizer_destroy(minimizer);
+    return;
+    }
+
+static void test_minimizer_index(HSP_Param *hsp_param){
+    register gint window = 10, word_length = hsp_param->wordlen,
+                  run = window + word_length - 1,
+                  target_len = 2000, flank = 200, offset = 1000;
+    register gchar *tmp_dir = (gchar*)g_get_tmp_dir(),
+                   *fasta_path = g_strdup_printf("%s/index.test.%d.fa",
+                                                 tmp_dir, (gint)getpid()),
+                   *dataset_path = g_strdup_printf("%s/index.test.%d.esd",
+                                                   tmp_dir, (gint)getpid()),
+                   *index_path = g_strdup_printf("%s/index.test.%d.esi",
+                                                 tmp_dir, (gint)getpid()),
+                   *target = g_new(gchar, target_len+1),
+                   *query_seq = g_new(gchar, run+(flank << 1)+1);
+    register GPtrArray *path_list = g_ptr_array_new();
+    register Alphabet *alphabet = Alphabet_create(Alphabet_Type_DNA, FALSE);
+    register Dataset *dataset;
+    register Index *index;
+    register Sequence *query;
+    register GPtrArray *index_hsp_set_list;
+    register FILE *fp;
+    register gint i;
+    guint32 seed = 7;
+    test_random_seq(target, target_len, &seed);
+    fp = fopen(fasta_path, "w");
+    g_assert(fp);
+    fprintf(fp, ">target\n%s\n", target);
+    fclose(fp);
+    g_ptr_array_add(path_list, fasta_path);
+    dataset = Dataset_create(path_list, Alphabet_Type_DNA, FALSE);
+    Dataset_write(dataset, dataset_path);
+    unlink(index_path);
+    index = Index_create(dataset, FALSE, word_length, 1, 1, 0,
+                         index_path, dataset_path, 64, NULL, window);
+    Index_destroy(index);
+    Dataset_destroy(dataset);
+    index = Index_open(index_path);
+    g_assert(index->header->version == 5);
+    g_assert(index->header->minimizer_window == window);
+    /* The query only shares a minimal exact run with the target */
+    test_random_seq(query_seq, flank, &seed);
+    strncpy(query_seq+flank, target+offset, run);
+    test_random_seq(query_seq+flank+run, flank, &seed);
+    query = Sequence_create("query", NULL, query_seq, 0,
+                            Sequence_Strand_FORWARD, alphabet);
+    index_hsp_set_list = Index_get_HSPsets(index, hsp_param, query, FALSE);
+    g_assert(index_hsp_set_list);
+    g_assert(index_hsp_set_list->len);
+    for(i = 0; i < index_hsp_set_list->len; i++)
+        Index_HSPset_destroy(index_hsp_set_list->pdata[i]);
+    g_ptr_array_free(index_hsp_set_list, TRUE);
+    Index_destroy(index);
+    Sequence_destroy(query);
+    Alphabet_destroy(alphabet);
+    unlink(index_path);
+    unlink(dataset_path);
+    unlink(fasta_path);
+    g_ptr_array_free(path_list, TRUE);
+    g_free(fasta_path);
+    g_free(dataset_path);
+    g_free(index_path);
+    g_free(target);
+    g_free(query_seq);
+    return;
+    }
+/* Builds a minimizer index, then finds a query by a minimal shared run */
+
 gint Argument_main(Argument *arg){
     register Index *index;
     register Alphabet *alphabet = Alphabet_create(Alphabet_Type_DNA, FALSE);
@@ -50,12 +259,19 @@ gint Argument_main(Argument *arg){
     HSPset_ArgumentSet_create(arg);
     Match_ArgumentSet_create(arg);
     Argument_process(arg, "index.test", NULL, NULL);
+    match = Match_find(Match_Type_DNA2DNA);
+    hsp_param = HSP_Param_create(match, FALSE);
+    test_minimizer_ties();
+    test_minimizer_dedupe();
+    test_minimizer_shared_run();
+    test_minimizer_index(hsp_param);
     if(!strcmp(path, "none")){ /* To ensure 'make check' does not fail */
         g_warning("No path set for test index file");
+        HSP_Param_destroy(hsp_param);
+        Alphabet_destroy(alphabet);
+        Sequence_destroy(query);
         return 0;
         }
-    match = Match_find(Match_Type_DNA2DNA);
-    hsp_param = HSP_Param_create(match, FALSE);
     /**/
     index = Index_open(path);
     index_hsp_set_list = Index_get_HSPsets(index, hsp_param, query, FALSE);
@@ -115,15 +115,26 @@ void JobQueue_submit(JobQueue *jq, JobQueue_Func job_func,
 /* waits until less than (thread_total * 2) jobs are queued
  */
 
-void JobQueue_complete(JobQueue *jq){
+void JobQueue_wait(JobQueue *jq){
 #ifdef USE_PTHREADS
-    register gint i, job_total;
+    register gint job_total;
     do { /* wait for job queue to empty */
         pthread_mutex_lock(&jq->queue_lock);
         job_total = PQueue_total(jq->pq) + jq->running_count;
         pthread_mutex_unlock(&jq->queue_lock);
         usleep(1000); /* wait before checking if queue is empty again */
     } while(job_total);
+#endif /* USE_PTHREADS */
+    return;
+    }
+/* Waits for all submitted jobs to finish,
+ * leaving the threads running for further jobs
+ */
+
+void JobQueue_complete(JobQueue *jq){
+#ifdef USE_PTHREADS
+    register gint i;
+    JobQueue_wait(jq);
     jq->is_complete = TRUE;
     /* wait for threads to finish */
     for(i = 0; i < jq->thread_total; i++)
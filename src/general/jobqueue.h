@@ -52,6 +52,7 @@ JobQueue *JobQueue_create(gint thread_total);
     void  JobQueue_destroy(JobQueue *jq);
     void  JobQueue_submit(JobQueue *jq, JobQueue_Func job_func,
                           gpointer job_data, gint priority);
+    void  JobQueue_wait(JobQueue *jq);
     void  JobQueue_complete(JobQueue *jq);
 
 /* Lower priority jobs are run first */
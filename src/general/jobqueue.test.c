@@ -35,7 +35,10 @@ int main(void){
         g_thread_init(NULL);
 #endif /* USE_PTHREADS */
 
-    for(i = 0; i < 10; i++)
+    for(i = 0; i < 5; i++)
+        JobQueue_submit(jq, test_run_func, test_str[i], 0);
+    JobQueue_wait(jq);
+    for(i = 5; i < 10; i++)
         JobQueue_submit(jq, test_run_func, test_str[i], 0);
     JobQueue_complete(jq);
     JobQueue_destroy(jq);
@@ -29,6 +29,8 @@
 #include <sys/types.h>  /* For stat() */
 #include <sys/stat.h>   /* For stat() */
 #include <unistd.h>     /* For stat() */
+#include <sys/wait.h>   /* For waitpid() */
+#include <signal.h>     /* For kill() */
 
 Analysis_ArgumentSet *Analysis_ArgumentSet_create(Argument *arg){
     register ArgumentSet *as;
@@ -55,10 +57,26 @@ Analysis_ArgumentSet *Analysis_ArgumentSet_create(Argument *arg){
         ArgumentSet_add_option(as, 0, "customserver", "command",
             "Custom command to send non-standard server", "NULL",
             Argument_parse_string, &aas.custom_server_command);
+        /**/
+        ArgumentSet_add_option(as, '\0', "forks", "number",
+            "Number of worker processes, each comparing a database chunk",
+            "1", Argument_parse_int, &aas.fork_count);
+        ArgumentSet_add_option(as, '\0', "forksplit", "[q|t]",
+            "Split query or target database between worker processes",
+            "query", Argument_parse_string, &aas.fork_split);
 #ifdef USE_PTHREADS
         ArgumentSet_add_option(as, 'c', "cores", "number",
             "Number of cores/CPUs/threads for alignment computation", "1",
             Argument_parse_int, &aas.thread_count);
+        ArgumentSet_add_option(as, '\0', "serverconnections", "number",
+            "Maximum number of connections to each server", "4",
+            Argument_parse_int, &aas.server_connections);
+        ArgumentSet_add_option(as, '\0', "ordered", NULL,
+            "Write results in input order when using several cores",
+            "FALSE", Argument_parse_boolean, &aas.use_ordered_output);
+        ArgumentSet_add_option(as, '\0', "orderwindow", "number",
+            "Maximum number of comparisons pending for ordered output",
+            "1024", Argument_parse_int, &aas.order_window);
 #endif
         Argument_absorb_ArgumentSet(arg, as);
         }
@@ -70,6 +88,7 @@ Analysis_ArgumentSet *Analysis_ArgumentSet_create(Argument *arg){
 typedef struct {
            GAM *gam;
     Comparison *comparison;
+         glong  order_id;
 } Analysis_HeuristicJob;
 
 static Analysis_HeuristicJob *Analysis_HeuristicJob_create(GAM *gam,
@@ -77,6 +96,8 @@ static Analysis_HeuristicJob *Analysis_HeuristicJob_create(GAM *gam,
     register Analysis_HeuristicJob *ahj = g_new(Analysis_HeuristicJob, 1);
     ahj->gam = GAM_share(gam);
     ahj->comparison = Comparison_share(comparison);
+    ahj->order_id = GAM_order_next(gam);
+    GAM_begin_query_job(gam, comparison->query->id);
     return ahj;
     }
 
@@ -92,18 +113,66 @@ static void Analysis_HeuristicJob_run(gpointer data){
     register GAM_Result *gam_result
            = GAM_Result_heuristic_create(ahj->gam, ahj->comparison);
     if(gam_result){
+        gam_result->order_id = ahj->order_id;
         GAM_Result_submit(gam_result);
         GAM_Result_destroy(gam_result);
+    } else {
+        GAM_order_skip(ahj->gam, ahj->order_id);
         }
+    GAM_end_query_job(ahj->gam, ahj->comparison->query->id);
     Analysis_HeuristicJob_destroy(ahj);
     return;
     }
 
+#ifdef USE_PTHREADS
+static guint64 Analysis_HSPset_estimate_cost(HSPset *hsp_set){
+    register gint i;
+    register HSP *hsp;
+    register guint query_start, query_end, target_start, target_end;
+    register guint64 hsp_total;
+    if((!hsp_set) || HSPset_is_empty(hsp_set)
+    || (!hsp_set->hsp_list->len))
+        return 0;
+    hsp = hsp_set->hsp_list->pdata[0];
+    query_start = hsp->query_start;
+    query_end = HSP_query_end(hsp);
+    target_start = hsp->target_start;
+    target_end = HSP_target_end(hsp);
+    for(i = 1; i < hsp_set->hsp_list->len; i++){
+        hsp = hsp_set->hsp_list->pdata[i];
+        query_start = MIN(query_start, hsp->query_start);
+        query_end = MAX(query_end, HSP_query_end(hsp));
+        target_start = MIN(target_start, hsp->target_start);
+        target_end = MAX(target_end, HSP_target_end(hsp));
+        }
+    hsp_total = hsp_set->hsp_list->len;
+    return (hsp_total * hsp_total)
+         + (query_end - query_start)
+         + (target_end - target_start);
+    }
+/* The gapped DP work grows with the number of HSP pairs
+ * that could be joined, and with the span to be covered between them.
+ */
+
+static gint Analysis_HeuristicJob_get_priority(Comparison *comparison){
+    register guint64 cost
+        = Analysis_HSPset_estimate_cost(comparison->dna_hspset)
+        + Analysis_HSPset_estimate_cost(comparison->protein_hspset)
+        + Analysis_HSPset_estimate_cost(comparison->codon_hspset);
+    return -(gint)MIN(cost, G_MAXINT);
+    }
+/* Lower priority jobs are run first, so the most expensive
+ * comparisons are started first, and the cheaper ones
+ * fill the gaps left at the end of each batch.
+ */
+#endif /* USE_PTHREADS */
+
 static void Analysis_report_func(Comparison *comparison,
                                  gpointer user_data){
     register Analysis *analysis = user_data;
     register GAM_Result *gam_result;
     register Analysis_HeuristicJob *ahj;
+    register glong order_id;
     g_assert(Comparison_has_hsps(comparison));
     if(analysis->scan_query){
         /* Swap back query and target after a query scan */
@@ -121,17 +190,21 @@ static void Analysis_report_func(Comparison *comparison,
         ahj = Analysis_HeuristicJob_create(analysis->gam, comparison);
 #ifdef USE_PTHREADS
         g_assert(analysis->job_queue);
-        /* FIXME: need to use priority here */
-        JobQueue_submit(analysis->job_queue, Analysis_HeuristicJob_run, ahj, 2);
+        JobQueue_submit(analysis->job_queue, Analysis_HeuristicJob_run, ahj,
+                        Analysis_HeuristicJob_get_priority(comparison));
 #else /* USE_PTHREADS */
         Analysis_HeuristicJob_run(ahj);
 #endif /* USE_PTHREADS */
     } else {
+        order_id = GAM_order_next(analysis->gam);
         gam_result = GAM_Result_ungapped_create(analysis->gam,
                                                 comparison);
         if(gam_result){
+            gam_result->order_id = order_id;
             GAM_Result_submit(gam_result);
             GAM_Result_destroy(gam_result);
+        } else {
+            GAM_order_skip(analysis->gam, order_id);
             }
         }
     return;
@@ -139,6 +212,38 @@ static void Analysis_report_func(Comparison *comparison,
 
 /**/
 
+static void Analysis_add_chunk_query(Analysis *analysis, gchar *query_id){
+    if(analysis->report_finished_queries)
+        g_ptr_array_add(analysis->chunk_query_id_list,
+                        g_strdup(query_id));
+    return;
+    }
+
+static void Analysis_report_finished_queries(Analysis *analysis){
+    register gint i;
+    register gchar *query_id;
+    fflush(stdout); /* Query chunk boundary */
+    if(!analysis->report_finished_queries)
+        return;
+    for(i = 0; i < analysis->chunk_query_id_list->len; i++){
+        query_id = analysis->chunk_query_id_list->pdata[i];
+        if(analysis->held_query_id){
+            if(strcmp(analysis->held_query_id, query_id))
+                GAM_report_query(analysis->gam, analysis->held_query_id);
+            g_free(analysis->held_query_id);
+            }
+        analysis->held_query_id = query_id;
+        }
+    g_ptr_array_set_size(analysis->chunk_query_id_list, 0);
+    return;
+    }
+/* Called once every comparison for a query chunk has been submitted.
+ * The workers are not drained: each query is reported
+ * when the last of its jobs ends (see GAM_report_query()).
+ * The last query in the chunk is held back,
+ * as its reverse strand may start the next chunk.
+ */
+
 static void Analysis_FastaPipe_Pair_init_func(gpointer user_data){
     register Analysis *analysis = user_data;
     g_assert(!analysis->curr_query);
@@ -157,6 +262,7 @@ static void Analysis_FastaPipe_Pair_term_func(gpointer user_data){
     register Analysis *analysis = user_data;
     FastaDB_Seq_destroy(analysis->curr_query);
     analysis->curr_query = NULL;
+    Analysis_report_finished_queries(analysis);
     return;
     }
 /* Called after query pipeline analysis */
@@ -173,6 +279,7 @@ static gboolean Analysis_FastaPipe_Pair_query_func(FastaDB_Seq *fdbs,
         g_message("Load query for pairwise comparision [%s] (%d)",
                   fdbs->seq->id, fdbs->seq->len);
     analysis->curr_query = FastaDB_Seq_share(fdbs);
+    Analysis_add_chunk_query(analysis, fdbs->seq->id);
     return TRUE; /* take queries one at a time */
     }
 /* Called on query loading */
@@ -197,6 +304,7 @@ typedef struct {
          GAM *gam;
     Sequence *query;
     Sequence *target;
+       glong  order_id;
 } Analysis_ExhaustiveJob;
 
 static Analysis_ExhaustiveJob *Analysis_ExhaustiveJob_create(GAM *gam,
@@ -205,6 +313,8 @@ static Analysis_ExhaustiveJob *Analysis_ExhaustiveJob_create(GAM *gam,
     aej->gam = GAM_share(gam);
     aej->query = Sequence_share(query);
     aej->target = Sequence_share(target);
+    aej->order_id = GAM_order_next(gam);
+    GAM_begin_query_job(gam, query->id);
     return aej;
     }
 
@@ -222,9 +332,13 @@ static void Analysis_ExhaustiveJob_run(gpointer data){
     gam_result = GAM_Result_exhaustive_create(aej->gam,
                                               aej->query, aej->target);
     if(gam_result){
+        gam_result->order_id = aej->order_id;
         GAM_Result_submit(gam_result);
         GAM_Result_destroy(gam_result);
+    } else {
+        GAM_order_skip(aej->gam, aej->order_id);
         }
+    GAM_end_query_job(aej->gam, aej->query->id);
     Analysis_ExhaustiveJob_destroy(aej);
     return;
     }
@@ -299,6 +413,7 @@ static void Analysis_FastaPipe_Seeder_term_func(gpointer user_data){
         RecycleBin_profile();
         }
     analysis->curr_seeder = NULL;
+    Analysis_report_finished_queries(analysis);
     return;
     }
 /* Called after query pipeline analysis */
@@ -309,6 +424,7 @@ static gboolean Analysis_FastaPipe_Seeder_query_func(FastaDB_Seq *fdbs,
     if(analysis->verbosity > 1)
         g_message("Load query for Seeder [%s] (%d)",
                 fdbs->seq->id, fdbs->seq->len);
+    Analysis_add_chunk_query(analysis, fdbs->seq->id);
     return Seeder_add_query(analysis->curr_seeder, fdbs->seq);
     }
 /* Called on query loading */
@@ -500,6 +616,13 @@ static void Analysis_Client_set_param(Analysis_Client *aclient, GAM *gam){
     snprintf(msg, sizeof(msg), "set param seedrepeat %d", has->seed_repeat);
     reply = Analysis_Client_send(aclient, msg, "ok:", FALSE);
     g_free(reply);
+    /* Only sent when set, so older servers are still usable */
+    if(has->two_hit_window){
+        snprintf(msg, sizeof(msg), "set param twohitwindow %d",
+                              has->two_hit_window);
+        reply = Analysis_Client_send(aclient, msg, "ok:", FALSE);
+        g_free(reply);
+        }
     /**/
     snprintf(msg, sizeof(msg), "set param dnahspthreshold %d",
                           has->dna_hsp_threshold);
@@ -584,7 +707,7 @@ static Analysis_Client *Analysis_Client_create(gchar *path, gint verbosity){
     aclient->ref_count = 1;
     aclient->sc = sc;
     aclient->verbosity = verbosity;
-    aclient->probe_fdb = NULL;
+    aclient->server = NULL;
     dbinfo = Analysis_Client_send(aclient, "dbinfo", "dbinfo:", FALSE);
     dbinfo_word = g_strsplit(dbinfo, " ", 8);
     /**/
@@ -616,44 +739,21 @@ static Analysis_Client *Analysis_Client_create(gchar *path, gint verbosity){
     g_strfreev(dbinfo_word);
     g_free(dbinfo);
     aclient->curr_query = NULL;
-    aclient->seq_cache = g_new0(Sequence*, aclient->num_seqs);
     Analysis_Client_info(aclient);
     return aclient;
     }
 
-static Analysis_Client *Analysis_Client_share(Analysis_Client *aclient){
-    aclient->ref_count++;
-    return aclient;
-    }
-
 static void Analysis_Client_destroy(Analysis_Client *aclient){
-    register gint i;
-    register Sequence *seq;
     if(--aclient->ref_count)
         return;
     if(aclient->curr_query)
         Sequence_destroy(aclient->curr_query);
-    for(i = 0; i < aclient->num_seqs; i++){
-        seq = aclient->seq_cache[i];
-        if(seq)
-            Sequence_destroy(seq);
-        }
-    g_free(aclient->seq_cache);
-    if(aclient->probe_fdb)
-        FastaDB_close(aclient->probe_fdb);
     SocketClient_destroy(aclient->sc);
     Alphabet_destroy(aclient->server_alphabet);
     g_free(aclient);
     return;
     }
 
-static void Analysis_Client_set_probe_fdb(Analysis_Client *aclient,
-                                          FastaDB *probe_fdb){
-    g_assert(!aclient->probe_fdb);
-    aclient->probe_fdb = FastaDB_dup(probe_fdb);
-    return;
-    }
-
 static void Analysis_Client_set_query(Analysis_Client *aclient, Sequence *seq){
     register gchar *seq_str = Sequence_get_str(seq);
     register gchar *msg = g_strdup_printf("set query %s", seq_str);
@@ -700,23 +800,156 @@ static void Analysis_Client_revcomp_target(Analysis_Client *aclient){
 
 /**/
 
+static Analysis_Server *Analysis_Server_create(Analysis_Builder *ab,
+                                               gchar *name, gint priority){
+    register Analysis_Server *as = g_new(Analysis_Server, 1);
+    as->name = g_strdup(name);
+    as->ab = ab;
+    as->priority = priority;
+    as->ref_count = 1;
+    as->client_pool = g_ptr_array_new();
+    as->client_total = 0;
+#ifdef USE_PTHREADS
+    as->client_limit = ab->analysis->aas->server_connections;
+    if(as->client_limit < 2)
+        g_error("Need at least 2 connections to server [%s]", name);
+#else /* USE_PTHREADS */
+    as->client_limit = 2;
+#endif /* USE_PTHREADS */
+    as->query_client_count = 0;
+    as->pending_query_count = 0;
+    as->query_list = g_ptr_array_new();
+    as->num_seqs = ab->server_num_seqs;
+    as->seq_cache = g_new0(Sequence*, as->num_seqs);
+#ifdef USE_PTHREADS
+    pthread_mutex_init(&as->pool_lock, NULL);
+    pthread_cond_init(&as->pool_cond, NULL);
+#endif /* USE_PTHREADS */
+    return as;
+    }
+
+static Analysis_Server *Analysis_Server_share(Analysis_Server *as){
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&as->pool_lock);
+#endif /* USE_PTHREADS */
+    as->ref_count++;
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&as->pool_lock);
+#endif /* USE_PTHREADS */
+    return as;
+    }
+
+static void Analysis_Server_destroy(Analysis_Server *as){
+    register gint i, ref_count;
+    register Sequence *seq;
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&as->pool_lock);
+#endif /* USE_PTHREADS */
+    ref_count = --as->ref_count;
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&as->pool_lock);
+#endif /* USE_PTHREADS */
+    if(ref_count)
+        return;
+    g_assert(as->client_pool->len == as->client_total);
+    for(i = 0; i < as->client_pool->len; i++)
+        Analysis_Client_destroy(as->client_pool->pdata[i]);
+    g_ptr_array_free(as->client_pool, TRUE);
+    g_assert(!as->query_list->len);
+    g_ptr_array_free(as->query_list, TRUE);
+    for(i = 0; i < as->num_seqs; i++){
+        seq = as->seq_cache[i];
+        if(seq)
+            Sequence_destroy(seq);
+        }
+    g_free(as->seq_cache);
+#ifdef USE_PTHREADS
+    pthread_mutex_destroy(&as->pool_lock);
+    pthread_cond_destroy(&as->pool_cond);
+#endif /* USE_PTHREADS */
+    g_free(as->name);
+    g_free(as);
+    return;
+    }
+
+static Analysis_Client *Analysis_Server_acquire_client(Analysis_Server *as,
+                                                      gboolean for_query){
+    register Analysis_Client *aclient = NULL;
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&as->pool_lock);
+    while(((!as->client_pool->len)
+          && (as->client_total >= as->client_limit))
+       || (for_query
+          && (as->query_client_count >= (as->client_limit-1))))
+        pthread_cond_wait(&as->pool_cond, &as->pool_lock);
+#endif /* USE_PTHREADS */
+    if(for_query)
+        as->query_client_count++;
+    if(as->client_pool->len){
+        aclient = as->client_pool->pdata[as->client_pool->len-1];
+        g_ptr_array_set_size(as->client_pool, as->client_pool->len-1);
+    } else {
+        as->client_total++;
+        }
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&as->pool_lock);
+#endif /* USE_PTHREADS */
+    if(!aclient){
+        aclient = Analysis_Client_create(as->name, as->ab->verbosity);
+        if(!aclient)
+            g_error("Could not connect to server [%s]", as->name);
+        aclient->server = as;
+        Analysis_Client_set_param(aclient, as->ab->analysis->gam);
+        if(as->ab->verbosity > 1)
+            g_message("Opened connection [%d] to server [%s]",
+                      as->client_total, as->name);
+        }
+    return aclient;
+    }
+/* Takes an idle connection from the pool, or opens a new one
+ * while fewer than client_limit are open, otherwise waits for one.
+ * A query holds its connection while it fetches subsequences
+ * on another, so queries may only hold client_limit-1 connections,
+ * leaving one for the subsequence fetches, which never wait
+ * while holding a connection.
+ */
+
+static void Analysis_Server_release_client(Analysis_Server *as,
+                                           Analysis_Client *aclient,
+                                           gboolean for_query){
+    g_assert(aclient->server == as);
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&as->pool_lock);
+#endif /* USE_PTHREADS */
+    g_ptr_array_add(as->client_pool, aclient);
+    if(for_query)
+        as->query_client_count--;
+#ifdef USE_PTHREADS
+    pthread_cond_broadcast(&as->pool_cond);
+    pthread_mutex_unlock(&as->pool_lock);
+#endif /* USE_PTHREADS */
+    return;
+    }
+
+/**/
+
 typedef struct {
-    Analysis_Client *aclient;
+    Analysis_Server *server;
                gint  target_id;
                gint  seq_len;
 } Analysis_Client_Key;
 
-static Analysis_Client_Key *Analysis_Client_Key_create(Analysis_Client *aclient,
+static Analysis_Client_Key *Analysis_Client_Key_create(Analysis_Server *server,
                                                    gint target_id, gint seq_len){
     register Analysis_Client_Key *key = g_new(Analysis_Client_Key, 1);
-    key->aclient = Analysis_Client_share(aclient);
+    key->server = Analysis_Server_share(server);
     key->target_id = target_id;
     key->seq_len = seq_len;
     return key;
     }
 
 static void Analysis_Client_Key_destroy(Analysis_Client_Key *key){
-    Analysis_Client_destroy(key->aclient);
+    Analysis_Server_destroy(key->server);
     g_free(key);
     return;
     }
@@ -735,8 +968,11 @@ static SparseCache_Page *Analysis_Client_SparseCache_fill_func(gint start,
                   page_len;
     register gchar *msg = g_strdup_printf("get subseq %d %d %d",
             key->target_id, start, len);
-    register gchar *reply = Analysis_Client_send(key->aclient, msg,
+    register Analysis_Client *aclient
+           = Analysis_Server_acquire_client(key->server, FALSE);
+    register gchar *reply = Analysis_Client_send(aclient, msg,
                                                 "subseq:", FALSE);
+    Analysis_Server_release_client(key->server, aclient, FALSE);
     if(strncmp(reply, "subseq:", 7))
         g_error("Failed to get subseq for target (%d,%d,%d) [%s]",
                 key->target_id, start, len, reply);
@@ -750,7 +986,10 @@ static SparseCache_Page *Analysis_Client_SparseCache_fill_func(gint start,
     FastaDB_SparseCache_compress(page, page_len);
     return page;
     }
-/* FIXME: move compression stuff to SeqPage in Sequence */
+/* Pages are fetched on any idle pooled connection,
+ * so they need not wait for a long "get hsps" request.
+ * FIXME: move compression stuff to SeqPage in Sequence
+ */
 
 static void Analysis_Client_SparseCache_free_func(gpointer user_data){
     register Analysis_Client_Key *key = user_data;
@@ -762,7 +1001,7 @@ static SparseCache *Analysis_Client_get_SparseCache(
                     Analysis_Client *aclient,
                     gint sequence_id, gint len){
     register Analysis_Client_Key *key
-        = Analysis_Client_Key_create(aclient, sequence_id, len);
+        = Analysis_Client_Key_create(aclient->server, sequence_id, len);
     return SparseCache_create(len, Analysis_Client_SparseCache_fill_func,
                          NULL, Analysis_Client_SparseCache_free_func, key);
     }
@@ -772,13 +1011,27 @@ static Sequence *Analysis_Client_get_Sequence(Analysis_Client *aclient,
                                               gboolean revcomp_target){
     register gchar *msg, *reply, *id, *def;
     register SparseCache *cache;
-    register Sequence *seq = aclient->seq_cache[sequence_id];
+    register Analysis_Server *server = aclient->server;
+    register Sequence *seq, *cached_seq;
     register gint len, checksum;
     register gchar **seqinfo_word;
+    g_assert(server);
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&server->pool_lock);
+#endif /* USE_PTHREADS */
+    seq = server->seq_cache[sequence_id];
+    if(seq)
+        seq = Sequence_share(seq);
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&server->pool_lock);
+#endif /* USE_PTHREADS */
     if(seq){
-        if(revcomp_target)
-            return Sequence_revcomp(seq);
-        return Sequence_share(seq);
+        if(revcomp_target){
+            cached_seq = seq;
+            seq = Sequence_revcomp(cached_seq);
+            Sequence_destroy(cached_seq);
+            }
+        return seq;
         }
     msg = g_strdup_printf("get info %d", sequence_id);
     reply = Analysis_Client_send(aclient, msg, "seqinfo:", FALSE);
@@ -802,15 +1055,30 @@ static Sequence *Analysis_Client_get_Sequence(Analysis_Client *aclient,
                        (aclient->server_alphabet->type == Alphabet_Type_DNA)
                        ?Sequence_Strand_FORWARD:Sequence_Strand_UNKNOWN,
                        aclient->server_alphabet, cache);
-    g_assert(!aclient->seq_cache[sequence_id]);
-    aclient->seq_cache[sequence_id] = seq;
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&server->pool_lock);
+#endif /* USE_PTHREADS */
+    cached_seq = server->seq_cache[sequence_id];
+    if(cached_seq){ /* Fetched concurrently on another connection */
+        Sequence_destroy(seq);
+        seq = cached_seq;
+    } else {
+        server->seq_cache[sequence_id] = seq;
+        }
+    seq = Sequence_share(seq);
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&server->pool_lock);
+#endif /* USE_PTHREADS */
     g_strfreev(seqinfo_word);
     SparseCache_destroy(cache);
     g_free(reply);
     g_free(msg);
-    if(revcomp_target)
-        return Sequence_revcomp(seq);
-    return Sequence_share(seq);
+    if(revcomp_target){
+        cached_seq = seq;
+        seq = Sequence_revcomp(cached_seq);
+        Sequence_destroy(cached_seq);
+        }
+    return seq;
     }
 
 typedef enum {
@@ -966,8 +1234,7 @@ static void Analysis_Client_process_query(Analysis_Client *aclient,
                                           Analysis *analysis,
                                           Sequence *query,
                                           gboolean swap_chains,
-                                          gboolean revcomp_target,
-                                          gint priority){
+                                          gboolean revcomp_target){
     Analysis_Client_set_query(aclient, query);
     Analysis_Client_get_hsp_sets(aclient, analysis, swap_chains, revcomp_target);
     /* Revcomp query if DNA */
@@ -980,44 +1247,100 @@ static void Analysis_Client_process_query(Analysis_Client *aclient,
     }
 
 static void Analysis_Client_process(Analysis_Client *aclient, Analysis *analysis,
-                                    gboolean swap_chains, gint priority){
-    register FastaDB_Seq *fdbs;
-    /* FIXME: need to check for appropriate database type */
-    while((fdbs = FastaDB_next(aclient->probe_fdb, FastaDB_Mask_ALL))){
-        Analysis_Client_process_query(aclient, analysis, fdbs->seq,
-                                      swap_chains, FALSE, priority);
-        /* Revcomp target if protein vs DNA or translate_both */
-        if(((aclient->curr_query->alphabet->type == Alphabet_Type_PROTEIN)
-          && (aclient->server_alphabet->type == Alphabet_Type_DNA))
-           || analysis->gam->translate_both){
-            Analysis_Client_revcomp_target(aclient);
-            Analysis_Client_process_query(aclient, analysis,
-                                          fdbs->seq, swap_chains, TRUE,
-                                          priority);
-            Analysis_Client_revcomp_target(aclient);
-            }
-        FastaDB_Seq_destroy(fdbs);
+                                    Sequence *query, gboolean swap_chains){
+    Analysis_Client_process_query(aclient, analysis, query,
+                                  swap_chains, FALSE);
+    /* Revcomp target if protein vs DNA or translate_both */
+    if(((aclient->curr_query->alphabet->type == Alphabet_Type_PROTEIN)
+      && (aclient->server_alphabet->type == Alphabet_Type_DNA))
+       || analysis->gam->translate_both){
+        Analysis_Client_revcomp_target(aclient);
+        Analysis_Client_process_query(aclient, analysis,
+                                      query, swap_chains, TRUE);
+        Analysis_Client_revcomp_target(aclient);
         }
     return;
     }
 
 /**/
 
-static Analysis_Server *Analysis_Server_create(Analysis_Builder *ab,
-                                               gchar *name, gint priority){
-    register Analysis_Server *as = g_new(Analysis_Server, 1);
-    as->name = g_strdup(name);
-    as->ab = ab;
-    as->priority = priority;
-    return as;
+static void Analysis_Server_process_query(Analysis_Server *server,
+                                         Sequence *query){
+    register Analysis_Client *aclient
+        = Analysis_Server_acquire_client(server, TRUE);
+    Analysis_Client_process(aclient, server->ab->analysis, query,
+                            server->ab->swap_chains);
+    Analysis_Server_release_client(server, aclient, TRUE);
+    Sequence_destroy(query);
+    return;
     }
+/* Each query holds one pooled connection for its set/get hsps requests,
+ * while concurrent queries (and subseq fetches for the gapped alignment
+ * of earlier queries) use the other connections in the pool.
+ */
 
-static void Analysis_Server_destroy(Analysis_Server *as){
-    g_free(as->name);
-    g_free(as);
+#ifdef USE_PTHREADS
+static Sequence *Analysis_Server_pop_query(Analysis_Server *server){
+    register Sequence *query = NULL;
+    if(server->query_list->len){
+        query = server->query_list->pdata[0];
+        g_ptr_array_remove_index(server->query_list, 0);
+        }
+    return query;
+    }
+/* Should be called with the pool_lock held */
+
+static void Analysis_Server_run_queued_query(Analysis_Server *server,
+                                             Sequence *query){
+    Analysis_Server_process_query(server, query);
+    pthread_mutex_lock(&server->pool_lock);
+    server->pending_query_count--;
+    pthread_cond_broadcast(&server->pool_cond);
+    pthread_mutex_unlock(&server->pool_lock);
+    return;
+    }
+
+static void Analysis_Server_query_job(gpointer data){
+    register Analysis_Server *server = data;
+    register Sequence *query;
+    pthread_mutex_lock(&server->pool_lock);
+    query = Analysis_Server_pop_query(server);
+    pthread_mutex_unlock(&server->pool_lock);
+    if(query) /* Otherwise already run by the probe reader */
+        Analysis_Server_run_queued_query(server, query);
+    Analysis_Server_destroy(server);
     return;
     }
 
+static void Analysis_Server_queue_query(Analysis_Server *server,
+                                        Sequence *query){
+    register Analysis *analysis = server->ab->analysis;
+    register Sequence *queued_query;
+    pthread_mutex_lock(&server->pool_lock);
+    while(server->pending_query_count >= (server->client_limit-1)){
+        queued_query = Analysis_Server_pop_query(server);
+        if(queued_query){ /* Run a queued query here rather than wait */
+            pthread_mutex_unlock(&server->pool_lock);
+            Analysis_Server_run_queued_query(server, queued_query);
+            pthread_mutex_lock(&server->pool_lock);
+        } else {
+            pthread_cond_wait(&server->pool_cond, &server->pool_lock);
+            }
+        }
+    server->pending_query_count++;
+    g_ptr_array_add(server->query_list, query);
+    pthread_mutex_unlock(&server->pool_lock);
+    JobQueue_submit(analysis->job_queue, Analysis_Server_query_job,
+                    Analysis_Server_share(server), server->priority);
+    return;
+    }
+/* No more queries are queued or running than there are connections
+ * for them, so a query job never waits for a query connection.
+ * When the limit is reached, the probe reader runs queued queries itself,
+ * and only waits when all of them are already running.
+ */
+#endif /* USE_PTHREADS */
+
 /**/
 
 static Analysis_Builder *Analysis_Builder_create(GPtrArray *path_list,
@@ -1036,6 +1359,7 @@ static Analysis_Builder *Analysis_Builder_create(GPtrArray *path_list,
     ab->verbosity = verbosity;
     ab->server_list = g_ptr_array_new();
     ab->server_type = ac->server_alphabet->type;
+    ab->server_num_seqs = ac->num_seqs;
     ab->probe_fdb = NULL;
     ab->analysis = analysis;
     Analysis_Client_destroy(ac);
@@ -1062,19 +1386,34 @@ static void Analysis_Builder_destroy(Analysis_Builder *ab){
 
 static void Analysis_Server_run(gpointer data){
     register Analysis_Server *server = data;
-    register Analysis_Client *client
-                = Analysis_Client_create(server->name,
-                                         server->ab->analysis->verbosity);
-    if(!client)
-        g_error("Could not connect to server [%s]", server->name);
-    Analysis_Client_set_param(client, server->ab->analysis->gam);
-    Analysis_Client_set_probe_fdb(client, server->ab->probe_fdb);
-    Analysis_Client_process(client, server->ab->analysis,
-                            server->ab->swap_chains, server->priority);
-    /**/
-    Analysis_Client_destroy(client);
+    register FastaDB *probe_fdb = FastaDB_dup(server->ab->probe_fdb);
+    register FastaDB_Seq *fdbs;
+    register Sequence *query;
+#ifdef USE_PTHREADS
+    /* With one thread, queries are run here in probe order */
+    register gboolean use_jobs
+        = (server->ab->analysis->aas->thread_count > 1);
+#endif /* USE_PTHREADS */
+    /* FIXME: need to check for appropriate database type */
+    while((fdbs = FastaDB_next(probe_fdb, FastaDB_Mask_ALL))){
+        query = Sequence_share(fdbs->seq);
+        FastaDB_Seq_destroy(fdbs);
+#ifdef USE_PTHREADS
+        if(use_jobs){
+            Analysis_Server_queue_query(server, query);
+            continue;
+            }
+#endif /* USE_PTHREADS */
+        Analysis_Server_process_query(server, query);
+        }
+    FastaDB_close(probe_fdb);
     return;
     }
+/* Fans the probe sequences out over the job queue,
+ * so several queries are in flight on each server at once.
+ * Queries only take the Sequence, so the FastaDB_Seq
+ * (and the probe FastaDB it shares) stay on this thread.
+ */
 
 static void Analysis_Builder_process(Analysis_Builder *ab,
                                      Analysis *analysis, gboolean swap_chains){
@@ -1160,6 +1499,139 @@ static GPtrArray *Analysis_FOSN_expand_path_list(GPtrArray *path_list){
  * it is assumed to be a FOSN, and parsed to expand the path_list.
  */
 
+/**/
+
+static Analysis_Worker *Analysis_Worker_create(gboolean merge_bestn){
+    register Analysis_Worker *worker = g_new(Analysis_Worker, 1);
+    worker->pid = -1;
+    worker->output_file = tmpfile();
+    if(!worker->output_file)
+        g_error("Could not create tmp file for worker output");
+    if(merge_bestn){
+        worker->bestn_file = tmpfile();
+        if(!worker->bestn_file)
+            g_error("Could not create tmp file for worker results");
+    } else {
+        worker->bestn_file = NULL;
+        }
+    return worker;
+    }
+
+static void Analysis_Worker_destroy(Analysis_Worker *worker){
+    fclose(worker->output_file);
+    if(worker->bestn_file)
+        fclose(worker->bestn_file);
+    g_free(worker);
+    return;
+    }
+
+static gboolean Analysis_fork_split_query(gchar *fork_split){
+    if((!strcasecmp(fork_split, "query"))
+    || (!strcasecmp(fork_split, "q")))
+        return TRUE;
+    if((!strcasecmp(fork_split, "target"))
+    || (!strcasecmp(fork_split, "t")))
+        return FALSE;
+    g_error("Unknown fork split [%s]", fork_split);
+    return FALSE; /* not reached */
+    }
+
+static void Analysis_fork_workers(Analysis *analysis,
+                                  gint *chunk_id, gint *chunk_total,
+                                  gboolean merge_bestn){
+    register gint i;
+    register pid_t pid;
+    register Analysis_Worker *worker;
+    if(*chunk_total)
+        g_error("Cannot fork workers over a database"
+                " which is already split into chunks");
+    fflush(NULL); /* Workers must not repeat buffered output */
+    analysis->worker_list = g_ptr_array_new();
+    for(i = 0; i < analysis->aas->fork_count; i++){
+        worker = Analysis_Worker_create(merge_bestn);
+        pid = fork();
+        if(pid == -1)
+            g_error("Could not fork worker [%d]", i+1);
+        if(!pid){ /* Worker */
+            while(analysis->worker_list->len){
+                Analysis_Worker_destroy(analysis->worker_list->pdata
+                                       [analysis->worker_list->len-1]);
+                g_ptr_array_set_size(analysis->worker_list,
+                                     analysis->worker_list->len-1);
+                }
+            g_ptr_array_free(analysis->worker_list, TRUE);
+            analysis->worker_list = NULL;
+            if(dup2(fileno(worker->output_file), STDOUT_FILENO) == -1)
+                g_error("Could not redirect output of worker [%d]", i+1);
+            analysis->worker = worker;
+            (*chunk_id) = i + 1;
+            (*chunk_total) = analysis->aas->fork_count;
+            return;
+            }
+        worker->pid = pid;
+        g_ptr_array_add(analysis->worker_list, worker);
+        }
+    return;
+    }
+/* Each worker is given one chunk of the database being split,
+ * and shares the models and other state built before the fork
+ * with the parent until either writes to it.
+ */
+
+static void Analysis_Worker_finish(Analysis_Worker *worker, GAM *gam){
+    if(worker->bestn_file)
+        GAM_write_bestn(gam, worker->bestn_file);
+    else
+        GAM_report(gam);
+    if(fflush(stdout))
+        g_error("Could not write worker output");
+    _exit(0);
+    return; /* not reached */
+    }
+/* Workers exit here, without freeing anything,
+ * so that only the parent writes the final output.
+ */
+
+static gboolean Analysis_Worker_collect(Analysis_Worker *worker, GAM *gam){
+    register gint len;
+    gchar buffer[BUFSIZ];
+    int status;
+    if(waitpid(worker->pid, &status, 0) == -1)
+        return FALSE;
+    worker->pid = -1;
+    if((!WIFEXITED(status)) || WEXITSTATUS(status))
+        return FALSE;
+    rewind(worker->output_file);
+    while((len = fread(buffer, sizeof(gchar), BUFSIZ,
+                       worker->output_file)) > 0)
+        fwrite(buffer, sizeof(gchar), len, stdout);
+    fflush(stdout);
+    if(worker->bestn_file){
+        rewind(worker->bestn_file);
+        GAM_read_bestn(gam, worker->bestn_file);
+        }
+    return TRUE;
+    }
+/* Output is copied in worker order,
+ * so it does not depend on which worker finishes first.
+ * Returns FALSE if the worker failed.
+ */
+
+static void Analysis_Worker_kill(Analysis_Worker *worker){
+    int status;
+    if(worker->pid <= 0)
+        return;
+    kill(worker->pid, SIGTERM);
+    waitpid(worker->pid, &status, 0);
+    worker->pid = -1;
+    return;
+    }
+/* Stops and reaps a worker which has not been collected,
+ * so no orphaned workers are left when the parent aborts.
+ */
+
+/**/
+
 Analysis *Analysis_create(
               GPtrArray *query_path_list, Alphabet_Type query_type,
               gint query_chunk_id, gint query_chunk_total,
@@ -1175,7 +1647,7 @@ Analysis *Analysis_create(
     register HSP_Param *dna_hsp_param, *protein_hsp_param,
                        *codon_hsp_param;
     register Match_ArgumentSet *mas = Match_ArgumentSet_create(NULL);
-    register gboolean use_horizon;
+    register gboolean use_horizon, fork_split_query;
     register GPtrArray *expanded_query_path_list = NULL,
                        *expanded_target_path_list = NULL;
     g_assert(query_path_list);
@@ -1184,11 +1656,6 @@ Analysis *Analysis_create(
     g_assert(target_path_list->len);
     analysis->aas = Analysis_ArgumentSet_create(NULL);
     analysis->verbosity = verbosity;
-#ifdef USE_PTHREADS
-    analysis->job_queue = JobQueue_create(analysis->aas->thread_count);
-#else
-    analysis->job_queue = JobQueue_create(1);
-#endif
 
     /* Expand FOSN paths */
     expanded_query_path_list = Analysis_FOSN_expand_path_list(
@@ -1241,6 +1708,18 @@ Analysis *Analysis_create(
                                mas->translate,
                                analysis->aas->use_exhaustive,
                                verbosity);
+#ifdef USE_PTHREADS
+    if(analysis->aas->use_ordered_output){
+        if(analysis->query_builder || analysis->target_builder){
+            g_warning("Ordered output is not used with servers");
+        } else {
+            if(analysis->aas->order_window < 1)
+                g_error("Order window must be at least one");
+            GAM_set_ordered_output(analysis->gam,
+                                   analysis->aas->order_window);
+            }
+        }
+#endif /* USE_PTHREADS */
     /**/
     Analysis_find_matches(analysis, &dna_match, &protein_match,
                                     &codon_match);
@@ -1250,6 +1729,39 @@ Analysis *Analysis_create(
     if(!match)
         match = codon_match;
     g_assert(match);
+    if(analysis->aas->fork_count > 1){
+        if(analysis->query_builder || analysis->target_builder){
+            g_warning("Forked workers are not used with servers");
+        } else {
+            fork_split_query = Analysis_fork_split_query(
+                                   analysis->aas->fork_split);
+            /* Best n results for a query from each target chunk
+             * must be merged by the parent
+             */
+            if(fork_split_query)
+                Analysis_fork_workers(analysis,
+                    &query_chunk_id, &query_chunk_total, FALSE);
+            else
+                Analysis_fork_workers(analysis,
+                    &target_chunk_id, &target_chunk_total,
+                    analysis->gam->gas->best_n?TRUE:FALSE);
+            }
+        }
+    if(analysis->worker_list){ /* Parent only collects the results */
+        if(expanded_query_path_list)
+            Analysis_path_list_destroy(expanded_query_path_list);
+        if(expanded_target_path_list)
+            Analysis_path_list_destroy(expanded_target_path_list);
+        return analysis;
+        }
+    /* Threads are started after forking, as workers cannot inherit them */
+#ifdef USE_PTHREADS
+    analysis->job_queue = JobQueue_create(analysis->aas->thread_count);
+    if(analysis->gam->sdp)
+        SDP_set_job_queue(analysis->gam->sdp, analysis->job_queue);
+#else
+    analysis->job_queue = JobQueue_create(1);
+#endif
     if(!analysis->query_builder)
         query_fdb = FastaDB_open_list_with_limit(query_path_list,
                 match->query->alphabet, query_chunk_id, query_chunk_total);
@@ -1369,6 +1881,15 @@ Analysis *Analysis_create(
                 }
             }
         }
+    /* Best n results can be reported as each query chunk finishes,
+     * unless the queries are scanned against each target chunk
+     */
+    if(analysis->gam->gas->best_n && analysis->fasta_pipe
+    && (!analysis->scan_query)
+    && (!(analysis->worker && analysis->worker->bestn_file))){
+        analysis->report_finished_queries = TRUE;
+        analysis->chunk_query_id_list = g_ptr_array_new();
+        }
     if(query_fdb)
         FastaDB_close(query_fdb);
     if(target_fdb)
@@ -1382,7 +1903,9 @@ Analysis *Analysis_create(
     }
 
 void Analysis_destroy(Analysis *analysis){
-    JobQueue_destroy(analysis->job_queue);
+    register gint i;
+    if(analysis->job_queue)
+        JobQueue_destroy(analysis->job_queue);
     if(analysis->fasta_pipe)
         FastaPipe_destroy(analysis->fasta_pipe);
     if(analysis->curr_query)
@@ -1403,12 +1926,36 @@ void Analysis_destroy(Analysis *analysis){
         Analysis_Builder_destroy(analysis->query_builder);
     if(analysis->target_builder)
         Analysis_Builder_destroy(analysis->target_builder);
+    if(analysis->chunk_query_id_list){
+        for(i = 0; i < analysis->chunk_query_id_list->len; i++)
+            g_free(analysis->chunk_query_id_list->pdata[i]);
+        g_ptr_array_free(analysis->chunk_query_id_list, TRUE);
+        }
+    g_free(analysis->held_query_id);
+    if(analysis->worker_list){
+        for(i = 0; i < analysis->worker_list->len; i++)
+            Analysis_Worker_destroy(analysis->worker_list->pdata[i]);
+        g_ptr_array_free(analysis->worker_list, TRUE);
+        }
     GAM_destroy(analysis->gam);
     g_free(analysis);
     return;
     }
 
 void Analysis_process(Analysis *analysis){
+    register gint i, j;
+    if(analysis->worker_list){
+        for(i = 0; i < analysis->worker_list->len; i++){
+            if(Analysis_Worker_collect(analysis->worker_list->pdata[i],
+                                       analysis->gam))
+                continue;
+            for(j = i+1; j < analysis->worker_list->len; j++)
+                Analysis_Worker_kill(analysis->worker_list->pdata[j]);
+            g_error("Worker [%d] failed", i+1);
+            }
+        GAM_report(analysis->gam);
+        return;
+        }
     if(analysis->query_builder){
         Analysis_Builder_process(analysis->query_builder, analysis, TRUE);
     } else if(analysis->target_builder){
@@ -1418,6 +1965,8 @@ void Analysis_process(Analysis *analysis){
         }
     if(analysis->job_queue)
         JobQueue_complete(analysis->job_queue);
+    if(analysis->worker)
+        Analysis_Worker_finish(analysis->worker, analysis->gam);
     GAM_report(analysis->gam);
     return;
     }
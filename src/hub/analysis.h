@@ -21,6 +21,8 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include <glib.h>
+#include <stdio.h>
+#include <sys/types.h> /* For pid_t */
 
 #include "fastapipe.h"
 #include "gam.h"
@@ -39,8 +41,13 @@ typedef struct {
        gchar *force_scan;
         gint  saturate_threshold;
        gchar *custom_server_command;
+        gint  fork_count;
+       gchar *fork_split;
 #ifdef USE_PTHREADS
         gint  thread_count;
+        gint  server_connections;
+    gboolean  use_ordered_output;
+        gint  order_window;
 #endif
 } Analysis_ArgumentSet;
 
@@ -58,15 +65,27 @@ typedef struct {
                 guint64   total_seq_len;
                 /**/
            SocketClient  *sc;
-                FastaDB  *probe_fdb;
                Sequence  *curr_query;
-               Sequence **seq_cache;
+ struct Analysis_Server  *server;
 } Analysis_Client;
 
-typedef struct {
-                      gchar *name;
-                       gint  priority;   /* used for job queues */
-    struct Analysis_Builder *ab;
+typedef struct Analysis_Server {
+                      gchar  *name;
+                       gint   priority;   /* used for job queues */
+                       gint   ref_count;
+    struct Analysis_Builder  *ab;
+                  GPtrArray  *client_pool; /* Idle Analysis_Client objects */
+                       gint   client_total;
+                       gint   client_limit;
+                       gint   query_client_count; /* Held by queries */
+                       gint   pending_query_count; /* Queued or running */
+                  GPtrArray  *query_list;  /* Queued query Sequences */
+                    guint64   num_seqs;
+                   Sequence **seq_cache;   /* Shared by all pooled clients */
+#ifdef USE_PTHREADS
+            pthread_mutex_t   pool_lock;
+             pthread_cond_t   pool_cond;   /* Signalled on release */
+#endif /* USE_PTHREADS */
 } Analysis_Server;
 
 typedef struct Analysis_Builder {
@@ -74,10 +93,21 @@ typedef struct Analysis_Builder {
             FastaDB *probe_fdb;
           GPtrArray *server_list; /* Contains Analysis_Server objects */
       Alphabet_Type  server_type;
+            guint64  server_num_seqs;
     struct Analysis *analysis;
            gboolean  swap_chains;
 } Analysis_Builder;
 
+typedef struct {
+    pid_t  pid;
+     FILE *output_file;
+     FILE *bestn_file; /* Only when best n results are merged */
+} Analysis_Worker;
+/* A forked process comparing one chunk of the query or target database.
+ * Its output is written to output_file, and copied to stdout
+ * by the parent once the worker has finished.
+ */
+
 typedef struct Analysis {
                FastaPipe *fasta_pipe;
                      GAM *gam;
@@ -95,6 +125,11 @@ typedef struct Analysis {
         Analysis_Builder *query_builder;
         Analysis_Builder *target_builder;
                 JobQueue *job_queue;
+                gboolean  report_finished_queries;
+               GPtrArray *chunk_query_id_list;
+                   gchar *held_query_id;
+               GPtrArray *worker_list; /* In the parent process */
+         Analysis_Worker *worker;      /* In a forked worker */
 } Analysis;
 
 Analysis *Analysis_create(
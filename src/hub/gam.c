@@ -19,13 +19,21 @@
 #include <string.h> /* For strcmp() */
 #include <strings.h> /* For strcasecmp() */
 #include <unistd.h> /* For unlink(), getpid(), getppid() etc */
+#include <sys/mman.h> /* For mmap(), munmap() */
 
 #include "gam.h"
+#include "alignmentrecord.h"
 #include "ungapped.h"
 #include "opair.h"
 #include "rangetree.h"
 
+#ifdef HAVE_OPEN_MEMSTREAM
+extern FILE *open_memstream(char **ptr, size_t *sizeloc);
+/* Not declared by stdio.h with _XOPEN_SOURCE 600 */
+#endif /* HAVE_OPEN_MEMSTREAM */
+
 static GAM *_gam; /* file-scope variable for passing to twalk() */
+static FILE *_gam_fp; /* file-scope variable for passing to twalk() */
 
 static gchar *GAM_Argument_parse_Model_Type(gchar *arg_string,
                                             gpointer data){
@@ -129,12 +137,18 @@ GAM_ArgumentSet *GAM_ArgumentSet_create(Argument *arg){
         ArgumentSet_add_option(as, 0, "showtargetgff", NULL,
          "Include GFF output on target in results", "FALSE",
          Argument_parse_boolean, &gas.show_target_gff);
+        ArgumentSet_add_option(as, 0, "showbinary", NULL,
+         "Write binary alignment records instead of text", "FALSE",
+         Argument_parse_boolean, &gas.show_binary);
         ArgumentSet_add_option(as, 0, "ryo", "format",
          "Roll-your-own printf-esque output format", "NULL",
          Argument_parse_string, &gas.ryo);
         ArgumentSet_add_option(as, 'n', "bestn", "number",
          "Report best N results per query", "0",
          Argument_parse_int, &gas.best_n);
+        ArgumentSet_add_option(as, '\0', "bestnmemory", "Mb",
+         "Memory for best N results before using disk", "256",
+         Argument_parse_int, &gas.bestn_memory_limit);
         ArgumentSet_add_option(as, 'S', "subopt", NULL,
          "Search for suboptimal alignments", "TRUE",
          Argument_parse_boolean, &gas.use_subopt);
@@ -166,57 +180,292 @@ static gboolean GAM_StoredResult_compare(gpointer low,
 
 static void GAM_display_alignment(GAM *gam,
             Alignment *alignment, Sequence *query, Sequence *target,
-            gint result_id, gint rank,
+            gint result_id, gint rank, GArray *rank_pos_list,
             gpointer user_data, gpointer self_data, FILE *fp);
 
+static GAM_OutputBuffer *GAM_OutputBuffer_create(void){
+    register GAM_OutputBuffer *output_buffer = g_new(GAM_OutputBuffer, 1);
+    output_buffer->data = NULL;
+    output_buffer->len = 0;
+#ifdef HAVE_OPEN_MEMSTREAM
+    output_buffer->fp = open_memstream(&output_buffer->data,
+                                       &output_buffer->len);
+#else /* HAVE_OPEN_MEMSTREAM */
+    output_buffer->fp = tmpfile();
+#endif /* HAVE_OPEN_MEMSTREAM */
+    if(!output_buffer->fp)
+        g_error("Could not create output buffer");
+    return output_buffer;
+    }
+
+static void GAM_OutputBuffer_finish(GAM_OutputBuffer *output_buffer){
+#ifdef HAVE_OPEN_MEMSTREAM
+    if(fclose(output_buffer->fp))
+        g_error("Could not finish output buffer");
+#else /* HAVE_OPEN_MEMSTREAM */
+    output_buffer->len = ftell(output_buffer->fp);
+    output_buffer->data = malloc(output_buffer->len+1);
+    if(!output_buffer->data)
+        g_error("Could not allocate output buffer");
+    rewind(output_buffer->fp);
+    if(fread(output_buffer->data, sizeof(char), output_buffer->len,
+             output_buffer->fp) != output_buffer->len)
+        g_error("Could not read output buffer");
+    fclose(output_buffer->fp);
+#endif /* HAVE_OPEN_MEMSTREAM */
+    output_buffer->fp = NULL;
+    return;
+    }
+/* After this, data holds the len bytes written to fp */
+
+static void GAM_OutputBuffer_write(GAM_OutputBuffer *output_buffer,
+                                   FILE *dst){
+    g_assert(!output_buffer->fp);
+    fwrite(output_buffer->data, sizeof(char), output_buffer->len, dst);
+    return;
+    }
+
+static void GAM_OutputBuffer_destroy(GAM_OutputBuffer *output_buffer){
+    g_assert(!output_buffer->fp);
+    free(output_buffer->data); /* allocated by open_memstream() */
+    g_free(output_buffer);
+    return;
+    }
+/* Results are rendered into memory without holding gam_lock,
+ * then written to stdout as a single block while the lock is held,
+ * so the output of concurrent comparisons is never interleaved.
+ * Best n results are also rendered here before they are stored.
+ * A tmp file is only used where open_memstream() is missing.
+ */
+
+static GAM_StoreBlock *GAM_StoreBlock_create(glong size){
+    register GAM_StoreBlock *block = g_new(GAM_StoreBlock, 1);
+    block->data = g_malloc(size);
+    block->size = size;
+    block->used = 0;
+    block->live_count = 0;
+    return block;
+    }
+
+static void GAM_StoreBlock_destroy(GAM_StoreBlock *block){
+    g_free(block->data);
+    g_free(block);
+    return;
+    }
+
+#define GAM_StoreBlock_SIZE (1 << 20)
+
+static GAM_ResultStore *GAM_ResultStore_create(gint memory_limit){
+    register GAM_ResultStore *store = g_new(GAM_ResultStore, 1);
+    store->spill_file = NULL;
+    store->spill_len = 0;
+    store->block = NULL;
+    store->memory_used = 0;
+    store->memory_limit = ((glong)memory_limit) << 20;
+    return store;
+    }
+
+static void GAM_ResultStore_destroy(GAM_ResultStore *store){
+    if(store->block){
+        g_assert(!store->block->live_count);
+        GAM_StoreBlock_destroy(store->block);
+        }
+    if(store->spill_file)
+        fclose(store->spill_file);
+    g_free(store);
+    return;
+    }
+
+static gchar *GAM_ResultStore_alloc(GAM_ResultStore *store, glong len,
+                                    GAM_StoreBlock **block){
+    register gchar *data;
+    register glong block_size;
+    if((!store->block)
+    || ((store->block->used + len) > store->block->size)){
+        block_size = MAX(len, GAM_StoreBlock_SIZE);
+        if(store->block && (!store->block->live_count)){
+            store->memory_used -= store->block->size;
+            GAM_StoreBlock_destroy(store->block);
+            store->block = NULL;
+            }
+        if((store->memory_used + block_size) > store->memory_limit)
+            return NULL;
+        store->block = GAM_StoreBlock_create(block_size);
+        store->memory_used += block_size;
+        }
+    data = store->block->data + store->block->used;
+    store->block->used += len;
+    store->block->live_count++;
+    (*block) = store->block;
+    return data;
+    }
+/* Results are packed into blocks which are only freed
+ * once every result they contain has been released.
+ * Returns NULL when the memory limit would be exceeded.
+ */
+
+static void GAM_ResultStore_release(GAM_ResultStore *store,
+                                    GAM_StoreBlock *block){
+    if(--block->live_count)
+        return;
+    if(block == store->block){
+        block->used = 0;
+    } else {
+        store->memory_used -= block->size;
+        GAM_StoreBlock_destroy(block);
+        }
+    return;
+    }
+
+static glong GAM_ResultStore_spill(GAM_ResultStore *store,
+                                   gchar *data, glong len){
+    register glong pos = store->spill_len;
+    if(!store->spill_file){
+        store->spill_file = tmpfile();
+        if(!store->spill_file)
+            g_error("Could not create tmp file for best n results");
+        }
+    if(fwrite(data, sizeof(gchar), len, store->spill_file) != len)
+        g_error("Could not write best n results to tmp file");
+    store->spill_len += len;
+    return pos;
+    }
+/* FIXME: optimisation:
+ *        could store unused positions in the spill file for reuse
+ */
+
+/**/
+
+static GAM_ResultStore *GAM_get_bestn_store(GAM *gam){
+    if(!gam->bestn_store)
+        gam->bestn_store
+            = GAM_ResultStore_create(gam->gas->bestn_memory_limit);
+    return gam->bestn_store;
+    }
+/* The store is created with the first result,
+ * so that forked workers do not share its tmp files.
+ */
+
+static GAM_StoredResult *GAM_StoredResult_alloc(GAM *gam,
+                         C4_Score score, glong len, gint rank_pos_total){
+    register GAM_StoredResult *gsr = g_new(GAM_StoredResult, 1);
+    register GAM_ResultStore *store = GAM_get_bestn_store(gam);
+    GAM_StoreBlock *block = NULL;
+    gsr->score = score;
+    gsr->len = len;
+    gsr->data = GAM_ResultStore_alloc(store, gsr->len, &block);
+    gsr->pos = -1;
+    gsr->block = block;
+    gsr->rank_pos_list = rank_pos_total
+                       ? g_new(glong, rank_pos_total) : NULL;
+    gsr->rank_pos_total = rank_pos_total;
+    return gsr;
+    }
+/* The caller fills in the rank positions,
+ * and the data when it fits in memory, or spills it
+ */
+
+static GAM_StoredResult *GAM_StoredResult_read(GAM *gam, C4_Score score,
+                         glong len, gint rank_pos_total, FILE *fp){
+    register GAM_StoredResult *gsr = GAM_StoredResult_alloc(gam, score,
+                                                    len, rank_pos_total);
+    register gchar *data = gsr->data ? gsr->data : g_new(gchar, len);
+    if((fread(gsr->rank_pos_list, sizeof(glong), rank_pos_total, fp)
+        != rank_pos_total)
+    || (fread(data, sizeof(gchar), len, fp) != len))
+        g_error("Could not read best n result");
+    if(!gsr->data){
+        gsr->pos = GAM_ResultStore_spill(gam->bestn_store, data, len);
+        g_free(data);
+        }
+    return gsr;
+    }
+
 static GAM_StoredResult *GAM_StoredResult_create(GAM *gam,
                          Sequence *query, Sequence *target,
                          Alignment *alignment,
                          gpointer user_data, gpointer self_data){
-    register GAM_StoredResult *gsr = g_new(GAM_StoredResult, 1);
-    gsr->score = alignment->score;
-    gsr->pos = ftell(gam->bestn_tmp_file);
+    register GAM_OutputBuffer *output_buffer = GAM_OutputBuffer_create();
+    register GArray *rank_pos_list = g_array_new(FALSE, FALSE,
+                                                 sizeof(glong));
+    register GAM_StoredResult *gsr;
     GAM_display_alignment(gam, alignment, query, target,
-                          0, -1, user_data, self_data, gam->bestn_tmp_file);
-    gsr->len = ftell(gam->bestn_tmp_file)
-             - gsr->pos;
+                          0, -1, rank_pos_list, user_data, self_data,
+                          output_buffer->fp);
+    GAM_OutputBuffer_finish(output_buffer);
+    gsr = GAM_StoredResult_alloc(gam, alignment->score,
+                                 output_buffer->len, rank_pos_list->len);
+    memcpy(gsr->rank_pos_list, rank_pos_list->data,
+           sizeof(glong)*rank_pos_list->len);
+    if(gsr->data)
+        memcpy(gsr->data, output_buffer->data, gsr->len);
+    else
+        gsr->pos = GAM_ResultStore_spill(gam->bestn_store,
+                                         output_buffer->data, gsr->len);
+    g_array_free(rank_pos_list, TRUE);
+    GAM_OutputBuffer_destroy(output_buffer);
     return gsr;
     }
+/* The rank positions are recorded while the result is rendered,
+ * so it is never scanned for them.
+ */
 
-static void GAM_StoredResult_destroy(GAM_StoredResult *gsr){
+static void GAM_StoredResult_destroy(GAM_StoredResult *gsr,
+                                     GAM_ResultStore *store){
+    if(gsr->block)
+        GAM_ResultStore_release(store, gsr->block);
+    g_free(gsr->rank_pos_list);
     g_free(gsr);
     return;
     }
-/* FIXME: optimisation:
- *        could store unused positions in the tmp file for reuse
- */
 
 static void GAM_StoredResult_display(GAM_StoredResult *gsr,
-                                     GAM *gam, gint rank){
-    register gint i, ch, tag_pos = 0;
-    register gchar *rank_tag = "%_EXONERATE_BESTN_RANK_%";
-    if(fseek(gam->bestn_tmp_file, gsr->pos, SEEK_SET))
-        g_error("Could not seek in tmp file");
-    for(i = 0; i < gsr->len; i++){
-        ch = getc(gam->bestn_tmp_file);
-        g_assert(ch != EOF);
-        if(ch == rank_tag[tag_pos]){
-            tag_pos++;
-            if(!rank_tag[tag_pos]){
-                printf("%d", rank);
-                tag_pos = 0;
-                }
-        } else {
-            if(tag_pos){
-                printf("%.*s", tag_pos, rank_tag);
-                tag_pos = 0;
-                }
-            putchar(ch);
+                                     GAM *gam, gint rank, FILE *fp){
+    register GAM_ResultStore *store = gam->bestn_store;
+    register gchar *data = gsr->data, *map = NULL, *ranked = NULL;
+    register glong i, start = 0, map_offset = 0, map_len = 0,
+                   len = gsr->len, rank_len, segment_len;
+    gchar rank_str[16];
+    if(!gsr->len)
+        return;
+    if(!data){
+        if(fflush(store->spill_file))
+            g_error("Could not flush best n tmp file");
+        map_offset = gsr->pos % sysconf(_SC_PAGESIZE);
+        map_len = gsr->len + map_offset;
+        map = mmap(NULL, map_len, PROT_READ, MAP_SHARED,
+                   fileno(store->spill_file), gsr->pos - map_offset);
+        if(map == MAP_FAILED)
+            g_error("Could not map best n tmp file");
+        data = map + map_offset;
+        }
+    if((rank != -1) && gsr->rank_pos_total){
+        rank_len = snprintf(rank_str, sizeof(rank_str), "%d", rank);
+        ranked = g_new(gchar, gsr->len + (rank_len*gsr->rank_pos_total));
+        len = 0;
+        for(i = 0; i < gsr->rank_pos_total; i++){
+            segment_len = gsr->rank_pos_list[i] - start;
+            memcpy(ranked+len, data+start, segment_len);
+            len += segment_len;
+            memcpy(ranked+len, rank_str, rank_len);
+            len += rank_len;
+            start = gsr->rank_pos_list[i];
             }
+        memcpy(ranked+len, data+start, gsr->len-start);
+        len += gsr->len-start;
+        data = ranked;
         }
-    fflush(stdout);
+    if(fwrite(data, sizeof(gchar), len, fp) != len)
+        g_error("Could not write best n result");
+    g_free(ranked);
+    if(map)
+        munmap(map, map_len);
     return;
     }
+/* The segments between the rank positions are joined with the rank,
+ * and written in a single block.
+ * A rank of -1 writes the result without its ranks.
+ */
 
 /**/
 
@@ -233,98 +482,125 @@ static GAM_QueryResult *GAM_QueryResult_create(GAM *gam,
     gqr->query_id = g_strdup(query_id);
     gqr->tie_count = 0;
     gqr->tie_score = C4_IMPOSSIBLY_LOW_SCORE;
+    gqr->job_count = 0;
+    gqr->is_finished = FALSE;
     return gqr;
     }
 
 static void GAM_QueryResult_pqueue_destroy_GAM_Result(gpointer data,
                                                  gpointer user_data){
     register GAM_StoredResult *gsr = data;
-    GAM_StoredResult_destroy(gsr);
+    register GAM_ResultStore *store = user_data;
+    GAM_StoredResult_destroy(gsr, store);
     return;
     }
 
-static void GAM_QueryResult_destroy(GAM_QueryResult *gqr){
+static void GAM_QueryResult_destroy(GAM_QueryResult *gqr,
+                                    GAM_ResultStore *store){
     PQueue_destroy(gqr->pq,
-                   GAM_QueryResult_pqueue_destroy_GAM_Result, NULL);
+                   GAM_QueryResult_pqueue_destroy_GAM_Result, store);
     g_free(gqr->query_id);
     g_free(gqr);
     return;
     }
 
-static void GAM_QueryResult_push(GAM_QueryResult *gqr,
-                                 GAM_Result *gam_result,
-                                 Alignment *alignment){
-    register GAM_StoredResult *gsr = GAM_StoredResult_create(gam_result->gam,
-                                          gam_result->query,
-                                          gam_result->target,
-                                          alignment,
-                                          gam_result->user_data,
-                                          gam_result->self_data);
+static gboolean GAM_QueryResult_accepts(GAM_QueryResult *gqr,
+                                        GAM *gam, C4_Score score){
+    if(score >= gqr->tie_score)
+        return TRUE;
+    return PQueue_total(gqr->pq) < gam->gas->best_n;
+    }
+/* Returns FALSE when a result with this score would be discarded */
+
+static void GAM_QueryResult_insert(GAM_QueryResult *gqr, GAM *gam,
+                                   GAM_StoredResult *gsr){
+    register C4_Score score = gsr->score;
+    register GPtrArray *tie_list;
     PQueue_push(gqr->pq, gsr);
+    if(score == gqr->tie_score){
+        gqr->tie_count++;
+    } else if(score < gqr->tie_score){
+        g_assert(PQueue_total(gqr->pq) <= gam->gas->best_n);
+        gqr->tie_count = 1;
+        gqr->tie_score = score;
+    } else { /* (score > gqr->tie_score) */
+        if((PQueue_total(gqr->pq)-gqr->tie_count) >= gam->gas->best_n){
+            /* Remove old ties */
+            while(gqr->tie_count){
+                gsr = PQueue_pop(gqr->pq);
+                GAM_StoredResult_destroy(gsr, gam->bestn_store);
+                gqr->tie_count--;
+                }
+            /* Count new ties */
+            tie_list = g_ptr_array_new();
+            gsr = PQueue_top(gqr->pq);
+            gqr->tie_score = gsr->score;
+            do {
+                gsr = PQueue_top(gqr->pq);
+                if(gsr && (gsr->score == gqr->tie_score)){
+                    gsr = PQueue_pop(gqr->pq);
+                    g_ptr_array_add(tie_list, gsr);
+                } else {
+                    break;
+                    }
+            } while(TRUE);
+            gqr->tie_count = tie_list->len;
+            /* Replace new ties */
+            while(tie_list->len){
+                gsr = tie_list->pdata[tie_list->len-1];
+                PQueue_push(gqr->pq, gsr);
+                g_ptr_array_set_size(tie_list, tie_list->len-1);
+                }
+            g_ptr_array_free(tie_list, TRUE);
+        } else {
+            if(PQueue_total(gqr->pq) == 1){ /* First alignment */
+                gqr->tie_count = 1;
+                gqr->tie_score = score;
+                }
+            }
+        }
     return;
     }
+/* Keeps the best n results, and any ties with the worst of them */
 
 static void GAM_QueryResult_submit(GAM_QueryResult *gqr,
                                    GAM_Result *gam_result){
     register GAM_StoredResult *gsr;
     register Alignment *alignment;
     register gint i;
-    register GPtrArray *tie_list = g_ptr_array_new();
     g_assert(!strcmp(gqr->query_id, gam_result->query->id));
     for(i = 0; i < gam_result->alignment_list->len; i++){
         alignment = gam_result->alignment_list->pdata[i];
-        if(alignment->score == gqr->tie_score){
-            GAM_QueryResult_push(gqr, gam_result, alignment);
-            gqr->tie_count++;
-        } else if(alignment->score < gqr->tie_score){
-            if(PQueue_total(gqr->pq) < gam_result->gam->gas->best_n){
-                GAM_QueryResult_push(gqr, gam_result, alignment);
-                gqr->tie_count = 1;
-                gqr->tie_score = alignment->score;
-            } else {
-                break; /* Other alignments are worse */
-                }
-        } else { /* (alignment->score > gqr->tie_score) */
-            GAM_QueryResult_push(gqr, gam_result, alignment);
-            if((PQueue_total(gqr->pq)-gqr->tie_count)
-               >= gam_result->gam->gas->best_n){
-                /* Remove old ties */
-                while(gqr->tie_count){
-                    gsr = PQueue_pop(gqr->pq);
-                    GAM_StoredResult_destroy(gsr);
-                    gqr->tie_count--;
-                    }
-                /* Count new ties */
-                gsr = PQueue_top(gqr->pq);
-                gqr->tie_score = gsr->score;
-                do {
-                    gsr = PQueue_top(gqr->pq);
-                    if(gsr && (gsr->score == gqr->tie_score)){
-                        gsr = PQueue_pop(gqr->pq);
-                        g_ptr_array_add(tie_list, gsr);
-                    } else {
-                        break;
-                        }
-                } while(TRUE);
-                gqr->tie_count = tie_list->len;
-                /* Replace new ties */
-                while(tie_list->len){
-                    gsr = tie_list->pdata[tie_list->len-1];
-                    PQueue_push(gqr->pq, gsr);
-                    g_ptr_array_set_size(tie_list, tie_list->len-1);
-                    }
-            } else {
-                if(PQueue_total(gqr->pq) == 1){ /* First alignment */
-                    gqr->tie_count = 1;
-                    gqr->tie_score = alignment->score;
-                    }
-                }
-            }
+        if(!GAM_QueryResult_accepts(gqr, gam_result->gam,
+                                    alignment->score))
+            break; /* Other alignments are worse */
+        gsr = GAM_StoredResult_create(gam_result->gam,
+                                      gam_result->query,
+                                      gam_result->target,
+                                      alignment,
+                                      gam_result->user_data,
+                                      gam_result->self_data);
+        GAM_QueryResult_insert(gqr, gam_result->gam, gsr);
         }
-    g_ptr_array_free(tie_list, TRUE);
     return;
     }
 
+static GAM_QueryResult *GAM_QueryResult_lookup(GAM *gam,
+                                               gchar *query_id){
+    register GAM_QueryResult *gqr;
+    GAM_QueryResult gqr_lookup;
+    void *tree_node;
+    gqr_lookup.query_id = query_id;
+    tree_node = tfind((void*)&gqr_lookup, &gam->bestn_tree,
+                      GAM_compare_id);
+    if(tree_node)
+        return *(GAM_QueryResult **)tree_node;
+    gqr = GAM_QueryResult_create(gam, query_id);
+    tsearch((void*)gqr, &gam->bestn_tree, GAM_compare_id);
+    return gqr;
+    }
+/* Must be called with the GAM locked */
+
 /**/
 
 static gboolean GAM_QueryResult_report_traverse_func(gpointer data,
@@ -356,8 +632,9 @@ static void GAM_QueryResult_report(GAM_QueryResult *gqr, GAM *gam){
           sizeof(gpointer), GAM_QueryResult_report_sort_func);
     for(i = result_list->len-1; i >= 0; i--){
         gsr = result_list->pdata[i];
-        GAM_StoredResult_display(gsr, gam, result_list->len-i);
+        GAM_StoredResult_display(gsr, gam, result_list->len-i, stdout);
         }
+    fflush(stdout);
     g_ptr_array_free(result_list, TRUE);
     return;
     }
@@ -406,10 +683,12 @@ GAM *GAM_create(Alphabet_Type query_type, Alphabet_Type target_type,
                   " will be VERY SLOW: use -S no");
     gam->query_type = query_type;
     gam->target_type = target_type;
-    if(gam->gas->best_n){
-        gam->bestn_tmp_file = tmpfile();
+    if(gam->gas->show_binary)
+        AlignmentRecord_write_header(stdout);
+    if(gam->gas->ryo)
+        gam->ryo = Alignment_RYO_create(gam->gas->ryo);
+    if(gam->gas->best_n)
         gam->pqueue_set = PQueueSet_create();
-        }
     gam->translate_both = Model_Type_translate_both(gam->gas->type);
     gam->dual_match = Model_Type_has_dual_match(gam->gas->type);
     gam->model = Model_Type_get_model(gam->gas->type,
@@ -451,6 +730,11 @@ GAM *GAM_create(Alphabet_Type query_type, Alphabet_Type target_type,
         }
 #ifdef USE_PTHREADS
     pthread_mutex_init(&gam->gam_lock, NULL);
+    pthread_cond_init(&gam->order_cond, NULL);
+    gam->order_window = 0;
+    gam->order_next_id = 0;
+    gam->order_emit_id = 0;
+    gam->order_slot = NULL;
 #endif /* USE_PTHREADS */
     return gam;
     }
@@ -494,11 +778,12 @@ static void GAM_QueryInfo_destroy(GAM_QueryInfo *gqi){
 
 /**/
 
-static void GAM_bestn_tree_destroy(void *bestn_tree){
+static void GAM_bestn_tree_destroy(void *bestn_tree,
+                                   GAM_ResultStore *store){
     while (bestn_tree) {
         GAM_QueryResult *gqr = *(GAM_QueryResult **)bestn_tree;
         tdelete((void *)gqr, &bestn_tree, GAM_compare_id);
-        GAM_QueryResult_destroy(gqr);
+        GAM_QueryResult_destroy(gqr, store);
         }
     }
 
@@ -516,6 +801,9 @@ void GAM_destroy(GAM *gam){
         return;
 #ifdef USE_PTHREADS
     pthread_mutex_destroy(&gam->gam_lock);
+    pthread_cond_destroy(&gam->order_cond);
+    g_assert(gam->order_emit_id == gam->order_next_id);
+    g_free(gam->order_slot);
 #endif /* USE_PTHREADS */
     g_assert(gam->model);
     g_ptr_array_free(gam->match_list, TRUE);
@@ -529,13 +817,15 @@ void GAM_destroy(GAM *gam){
     if(gam->translate)
         Translate_destroy(gam->translate);
     if(gam->bestn_tree)
-        GAM_bestn_tree_destroy(gam->bestn_tree);
+        GAM_bestn_tree_destroy(gam->bestn_tree, gam->bestn_store);
     if(gam->percent_threshold_tree)
         GAM_percent_threshold_tree_destroy(gam->percent_threshold_tree);
-    if(gam->bestn_tmp_file)
-        fclose(gam->bestn_tmp_file);
+    if(gam->bestn_store)
+        GAM_ResultStore_destroy(gam->bestn_store);
     if(gam->pqueue_set)
         PQueueSet_destroy(gam->pqueue_set);
+    if(gam->ryo)
+        Alignment_RYO_destroy(gam->ryo);
     g_free(gam);
     return;
     }
@@ -552,8 +842,153 @@ void GAM_report(GAM *gam){
         _gam = gam;
         twalk(gam->bestn_tree, GAM_bestn_tree_report_traverse);
     }
+    fflush(stdout);
+    return;
+    }
+
+static void GAM_QueryResult_finish(GAM_QueryResult *gqr, GAM *gam){
+    tdelete((void*)gqr, &gam->bestn_tree, GAM_compare_id);
+    GAM_QueryResult_report(gqr, gam);
+    GAM_QueryResult_destroy(gqr, gam->bestn_store);
+    return;
+    }
+/* Must be called with the GAM locked */
+
+void GAM_report_query(GAM *gam, gchar *query_id){
+    register GAM_QueryResult *gqr;
+    GAM_QueryResult gqr_lookup;
+    void *tree_node;
+    if(!gam->gas->best_n)
+        return;
+    GAM_lock(gam);
+    gqr_lookup.query_id = query_id;
+    tree_node = tfind((void*)&gqr_lookup, &gam->bestn_tree,
+                      GAM_compare_id);
+    if(tree_node){
+        gqr = *(GAM_QueryResult **)tree_node;
+        gqr->is_finished = TRUE;
+        if(!gqr->job_count)
+            GAM_QueryResult_finish(gqr, gam);
+        }
+    GAM_unlock(gam);
     return;
     }
+/* Reports and frees the best n results for a query
+ * once the caller knows that no more comparisons will be made for it.
+ * If any of its jobs are still running,
+ * this is left to the last one to end.
+ */
+
+void GAM_begin_query_job(GAM *gam, gchar *query_id){
+    register GAM_QueryResult *gqr;
+    if(!gam->gas->best_n)
+        return;
+    GAM_lock(gam);
+    gqr = GAM_QueryResult_lookup(gam, query_id);
+    g_assert(!gqr->is_finished);
+    gqr->job_count++;
+    GAM_unlock(gam);
+    return;
+    }
+
+void GAM_end_query_job(GAM *gam, gchar *query_id){
+    register GAM_QueryResult *gqr;
+    if(!gam->gas->best_n)
+        return;
+    GAM_lock(gam);
+    gqr = GAM_QueryResult_lookup(gam, query_id);
+    g_assert(gqr->job_count > 0);
+    if((!--gqr->job_count) && gqr->is_finished)
+        GAM_QueryResult_finish(gqr, gam);
+    GAM_unlock(gam);
+    return;
+    }
+
+static void GAM_QueryResult_write(GAM_QueryResult *gqr, GAM *gam,
+                                  FILE *fp){
+    register GPtrArray *result_list = g_ptr_array_new();
+    register GAM_StoredResult *gsr;
+    register gint i;
+    gint id_len = strlen(gqr->query_id), result_total;
+    PQueue_traverse(gqr->pq, GAM_QueryResult_report_traverse_func,
+                    result_list);
+    result_total = result_list->len;
+    fwrite(&id_len, sizeof(gint), 1, fp);
+    fwrite(gqr->query_id, sizeof(gchar), id_len, fp);
+    fwrite(&result_total, sizeof(gint), 1, fp);
+    for(i = 0; i < result_list->len; i++){
+        gsr = result_list->pdata[i];
+        fwrite(&gsr->score, sizeof(C4_Score), 1, fp);
+        fwrite(&gsr->len, sizeof(glong), 1, fp);
+        fwrite(&gsr->rank_pos_total, sizeof(gint), 1, fp);
+        fwrite(gsr->rank_pos_list, sizeof(glong), gsr->rank_pos_total, fp);
+        GAM_StoredResult_display(gsr, gam, -1, fp);
+        }
+    g_ptr_array_free(result_list, TRUE);
+    return;
+    }
+
+static void GAM_bestn_tree_write_traverse(const void *gqr,
+                                          VISIT order, int level){
+    if((order == leaf) || (order == postorder))
+        GAM_QueryResult_write(*(GAM_QueryResult**)gqr, _gam, _gam_fp);
+    return;
+    }
+
+void GAM_write_bestn(GAM *gam, FILE *fp){
+    g_assert(gam->gas->best_n);
+    GAM_lock(gam);
+    if(gam->bestn_tree){
+        _gam = gam;
+        _gam_fp = fp;
+        twalk(gam->bestn_tree, GAM_bestn_tree_write_traverse);
+        }
+    GAM_unlock(gam);
+    if(fflush(fp) || ferror(fp))
+        g_error("Could not write best n results");
+    return;
+    }
+
+void GAM_read_bestn(GAM *gam, FILE *fp){
+    register GAM_QueryResult *gqr;
+    register GAM_StoredResult *gsr;
+    register gchar *query_id = NULL;
+    register gint i;
+    gint id_len, result_total, rank_pos_total;
+    C4_Score score;
+    glong len;
+    g_assert(gam->gas->best_n);
+    GAM_lock(gam);
+    while(fread(&id_len, sizeof(gint), 1, fp) == 1){
+        query_id = g_renew(gchar, query_id, id_len+1);
+        if((fread(query_id, sizeof(gchar), id_len, fp) != id_len)
+        || (fread(&result_total, sizeof(gint), 1, fp) != 1))
+            g_error("Could not read best n results");
+        query_id[id_len] = '\0';
+        gqr = GAM_QueryResult_lookup(gam, query_id);
+        for(i = 0; i < result_total; i++){
+            if((fread(&score, sizeof(C4_Score), 1, fp) != 1)
+            || (fread(&len, sizeof(glong), 1, fp) != 1)
+            || (fread(&rank_pos_total, sizeof(gint), 1, fp) != 1))
+                g_error("Could not read best n results");
+            if(GAM_QueryResult_accepts(gqr, gam, score)){
+                gsr = GAM_StoredResult_read(gam, score, len,
+                                            rank_pos_total, fp);
+                GAM_QueryResult_insert(gqr, gam, gsr);
+            } else {
+                if(fseek(fp, (sizeof(glong)*rank_pos_total) + len,
+                         SEEK_CUR))
+                    g_error("Could not read best n results");
+                }
+            }
+        }
+    g_free(query_id);
+    GAM_unlock(gam);
+    return;
+    }
+/* Results read from another GAM are merged with the same tie rules,
+ * and those which could not be reported are skipped unread.
+ */
 
 /**/
 
@@ -594,6 +1029,7 @@ static GAM_Result *GAM_Result_create(GAM *gam,
     gam_result->alignment_list = NULL;
     gam_result->query = Sequence_share(query);
     gam_result->target = Sequence_share(target);
+    gam_result->order_id = -1;
     gam_result->user_data = Model_Type_create_data(gam->gas->type,
                                                    query, target);
     gam_result->self_data = Model_Type_create_data(gam->gas->type,
@@ -678,8 +1114,10 @@ static C4_Score GAM_get_query_threshold(GAM *gam, Sequence *query){
     register GAM_QueryResult *gqr;
     register GAM_StoredResult *gsr;
     register GAM_QueryInfo *gqi;
+    register C4_Score threshold = gam->gas->threshold;
     GAM_QueryResult gq_lookup = {.query_id = query->id};
     void *tree_node;
+    GAM_lock(gam);
     if(gam->gas->best_n){
         tree_node = tfind((void*)&gq_lookup, &gam->bestn_tree, GAM_compare_id);
         gqr = tree_node ? *(GAM_QueryResult **)tree_node : NULL;
@@ -688,21 +1126,68 @@ static C4_Score GAM_get_query_threshold(GAM *gam, Sequence *query){
             if(gam->verbosity > 2)
                 g_message("Using threshold [%d] for query [%s]",
                       gsr->score, query->id);
+            GAM_unlock(gam);
             return gsr->score;
             }
         }
     if(gam->gas->percent_threshold){
         tree_node = tfind((void*)&gq_lookup, &gam->percent_threshold_tree, 
                           GAM_compare_id);
-        gqi = tree_node ? *(GAM_QueryInfo **)tree_node : NULL;
-        if(!gqi){
+        if(!tree_node){
+            /* Scan the query without holding gam_lock */
+            GAM_unlock(gam);
             gqi = GAM_QueryInfo_create(query, gam);
-            tsearch((void*)gqi, &gam->percent_threshold_tree, GAM_compare_id);
+            GAM_lock(gam);
+            tree_node = tsearch((void*)gqi, &gam->percent_threshold_tree,
+                                GAM_compare_id);
+            if(*(GAM_QueryInfo**)tree_node != gqi) /* Added by another thread */
+                GAM_QueryInfo_destroy(gqi);
             }
-        return gqi->threshold;
+        gqi = *(GAM_QueryInfo**)tree_node;
+        threshold = gqi->threshold;
+        }
+    GAM_unlock(gam);
+    return threshold;
+    }
+/* Takes gam_lock, as the trees are updated by other threads
+ * as results are submitted, so must not be called with gam_lock held.
+ * The query self score is found with the lock released,
+ * and kept only if no other thread added this query meanwhile.
+ */
+
+static C4_Score GAM_Result_get_threshold(GAM_Result *gam_result){
+    register C4_Score threshold = GAM_get_query_threshold(gam_result->gam,
+                                                      gam_result->query);
+    register Alignment *alignment;
+    register gint best_n = gam_result->gam->gas->best_n;
+    if(best_n && gam_result->alignment_list
+    && (gam_result->alignment_list->len >= best_n)
+    && (gam_result->gam->gas->refinement == GAM_Refinement_NONE)){
+        alignment = gam_result->alignment_list->pdata[best_n-1];
+        if(threshold < alignment->score)
+            threshold = alignment->score;
         }
-    return gam->gas->threshold;
+    return threshold;
     }
+/* Alignments are found in order of decreasing score,
+ * so once this result holds best_n of them,
+ * any later alignment must at least tie the last of these
+ * to be reported.
+ */
+
+static gboolean GAM_Result_cannot_improve(GAM_Result *gam_result,
+                                          C4_Score threshold){
+    register Alignment *last;
+    if(!gam_result->alignment_list)
+        return FALSE;
+    last = gam_result->alignment_list->pdata
+          [gam_result->alignment_list->len-1];
+    return (last->score < threshold)?TRUE:FALSE;
+    }
+/* As later paths cannot score above the last one found,
+ * there is no need to search for further suboptimal alignments
+ * once the threshold has risen above it.
+ */
 
 static int GAM_Result_ungapped_create_sort_func(const void *a,
                                                 const void *b){
@@ -719,9 +1204,9 @@ static void GAM_Result_ungapped_add_HSPset(GAM_Result *gam_result,
     register Alignment *alignment;
     register HSP *hsp;
     HSPset_filter_ungapped(hspset);
+    threshold = GAM_get_query_threshold(gam_result->gam, hspset->query);
     for(i = 0; i < hspset->hsp_list->len; i++){
         hsp = hspset->hsp_list->pdata[i];
-        threshold = GAM_get_query_threshold(gam_result->gam, hspset->query);
         if(hsp->score >= threshold){
             alignment = Ungapped_Alignment_create(model,
                                                   gam_result->user_data,
@@ -798,8 +1283,7 @@ static GAM_Result *GAM_Result_BSDP_create(GAM *gam,
                                           Comparison *comparison){
     register HPair *hpair;
     register Alignment *alignment;
-    register C4_Score threshold
-             = GAM_get_query_threshold(gam, comparison->query);
+    register C4_Score threshold;
     register GAM_Result *gam_result = GAM_Result_create(gam,
                                         comparison->query,
                                         comparison->target);
@@ -822,11 +1306,13 @@ static GAM_Result *GAM_Result_BSDP_create(GAM *gam,
     if(comparison->codon_hspset)
         GAM_Result_BSDP_add_HSPset(comparison->codon_hspset, gam,
                                    hpair);
-    HPair_finalise(hpair, threshold);
+    HPair_finalise(hpair, GAM_Result_get_threshold(gam_result));
     if(gam->verbosity > 2)
         g_message("Finalised HPair");
     do {
-        threshold = GAM_get_query_threshold(gam, comparison->query);
+        threshold = GAM_Result_get_threshold(gam_result);
+        if(GAM_Result_cannot_improve(gam_result, threshold))
+            break;
         alignment = HPair_next_path(hpair, threshold);
         if(!alignment)
             break;
@@ -845,10 +1331,22 @@ static GAM_Result *GAM_Result_BSDP_create(GAM *gam,
         }
     return gam_result;
     }
-/* FIXME: optimisation: change to update threshold between
- *        suboptimal alignments.
+/* The threshold is updated between suboptimal alignments,
+ * so results submitted by other threads can stop the search early.
  */
 
+static gpointer GAM_Result_SDP_create_data(gpointer data){
+    register GAM_Result *gam_result = data;
+    return Model_Type_create_data(gam_result->gam->gas->type,
+                                  gam_result->query, gam_result->target);
+    }
+
+static void GAM_Result_SDP_destroy_data(gpointer user_data, gpointer data){
+    register GAM_Result *gam_result = data;
+    Model_Type_destroy_data(gam_result->gam->gas->type, user_data);
+    return;
+    }
+
 static GAM_Result *GAM_Result_SDP_create(GAM *gam,
                                          Comparison *comparison){
     register SDP_Pair *sdp_pair;
@@ -866,8 +1364,13 @@ static GAM_Result *GAM_Result_SDP_create(GAM *gam,
     g_assert(Comparison_has_hsps(comparison));
     sdp_pair = SDP_Pair_create(gam->sdp, gam_result->subopt,
                                comparison, gam_result->user_data);
+    SDP_Pair_set_data_funcs(sdp_pair, GAM_Result_SDP_create_data,
+                                      GAM_Result_SDP_destroy_data,
+                                      gam_result);
     do {
-        threshold = GAM_get_query_threshold(gam, comparison->query);
+        threshold = GAM_Result_get_threshold(gam_result);
+        if(GAM_Result_cannot_improve(gam_result, threshold))
+            break;
         alignment = SDP_Pair_next_path(sdp_pair, threshold);
         if(!alignment)
             break;
@@ -1159,9 +1662,9 @@ GAM_Result *GAM_Result_exhaustive_create(GAM *gam,
                   query->id, target->id);
     /**/
     do {
-        GAM_lock(gam);
-        threshold = GAM_get_query_threshold(gam, query);
-        GAM_unlock(gam);
+        threshold = GAM_Result_get_threshold(gam_result);
+        if(GAM_Result_cannot_improve(gam_result, threshold))
+            break;
         alignment = OPair_next_path(opair, threshold);
         if(!alignment)
             break;
@@ -1209,8 +1712,12 @@ void GAM_Result_destroy(GAM_Result *gam_result){
 
 static void GAM_display_alignment(GAM *gam, Alignment *alignment,
             Sequence *query, Sequence *target,
-            gint result_id, gint rank,
+            gint result_id, gint rank, GArray *rank_pos_list,
             gpointer user_data, gpointer self_data, FILE *fp){
+    if(gam->gas->show_binary){
+        Alignment_display_binary(alignment, query, target, fp);
+        return;
+        }
     if(gam->gas->show_alignment)
         Alignment_display(alignment, query, target,
                           gam->dna_submat, gam->protein_submat,
@@ -1228,15 +1735,14 @@ static void GAM_display_alignment(GAM *gam, Alignment *alignment,
         Alignment_display_gff(alignment, query, target, gam->translate,
              FALSE, Model_Type_has_genomic_target(gam->gas->type),
              result_id, user_data, fp);
-    if(gam->gas->ryo)
-        Alignment_display_ryo(alignment, query, target,
-                              gam->gas->ryo, gam->translate, rank,
+    if(gam->ryo)
+        Alignment_RYO_display(gam->ryo, alignment, query, target,
+                              gam->translate, rank, rank_pos_list,
                               user_data, self_data, fp);
-    fflush(fp);
     return;
     }
 
-static void GAM_Result_display(GAM_Result *gam_result){
+static void GAM_Result_display(GAM_Result *gam_result, FILE *fp){
     register gint i;
     register Alignment *alignment;
     g_assert(gam_result);
@@ -1244,35 +1750,119 @@ static void GAM_Result_display(GAM_Result *gam_result){
         alignment = gam_result->alignment_list->pdata[i];
         GAM_display_alignment(gam_result->gam, alignment,
                 gam_result->query, gam_result->target,
-                i+1, 0, gam_result->user_data, gam_result->self_data, stdout);
+                i+1, 0, NULL,
+                gam_result->user_data, gam_result->self_data, fp);
         }
     return;
     }
 
+#ifdef USE_PTHREADS
+
+static void GAM_order_set_ready(GAM *gam, glong order_id,
+                                GAM_OutputBuffer *output_buffer){
+    register GAM_OrderSlot *slot;
+    g_assert(gam->order_window);
+    GAM_lock(gam);
+    g_assert(order_id >= gam->order_emit_id);
+    g_assert(order_id < gam->order_next_id);
+    slot = &gam->order_slot[order_id % gam->order_window];
+    g_assert(!slot->is_ready);
+    slot->is_ready = TRUE;
+    slot->output_buffer = output_buffer;
+    do {
+        slot = &gam->order_slot[gam->order_emit_id % gam->order_window];
+        if(!slot->is_ready)
+            break;
+        if(slot->output_buffer){
+            GAM_OutputBuffer_write(slot->output_buffer, stdout);
+            GAM_OutputBuffer_destroy(slot->output_buffer);
+            }
+        slot->is_ready = FALSE;
+        slot->output_buffer = NULL;
+        gam->order_emit_id++;
+        pthread_cond_signal(&gam->order_cond);
+    } while(gam->order_emit_id < gam->order_next_id);
+    GAM_unlock(gam);
+    return;
+    }
+/* Stores a finished result in the reorder window,
+ * then writes out every result which is now next in input order.
+ */
+#endif /* USE_PTHREADS */
+
+void GAM_set_ordered_output(GAM *gam, gint window){
+#ifdef USE_PTHREADS
+    g_assert(window > 0);
+    g_assert(!gam->order_next_id);
+    if(gam->gas->best_n){ /* best_n results are reported at the end */
+        g_warning("Ordered output is not used with best n");
+        return;
+        }
+    gam->order_window = window;
+    g_free(gam->order_slot);
+    gam->order_slot = g_new0(GAM_OrderSlot, window);
+#endif /* USE_PTHREADS */
+    return;
+    }
+
+glong GAM_order_next(GAM *gam){
+#ifdef USE_PTHREADS
+    register glong order_id;
+    if(!gam->order_window)
+        return -1;
+    GAM_lock(gam);
+    while((gam->order_next_id - gam->order_emit_id) >= gam->order_window)
+        pthread_cond_wait(&gam->order_cond, &gam->gam_lock);
+    order_id = gam->order_next_id++;
+    GAM_unlock(gam);
+    return order_id;
+#endif /* USE_PTHREADS */
+    return -1;
+    }
+
+void GAM_order_skip(GAM *gam, glong order_id){
+#ifdef USE_PTHREADS
+    if(order_id != -1)
+        GAM_order_set_ready(gam, order_id, NULL);
+#endif /* USE_PTHREADS */
+    return;
+    }
+
 void GAM_Result_submit(GAM_Result *gam_result){
     register GAM_QueryResult *gqr;
+#ifdef USE_PTHREADS
+    register GAM_OutputBuffer *output_buffer;
+#endif /* USE_PTHREADS */
     g_assert(gam_result);
-    GAM_lock(gam_result->gam);
-    if(gam_result->gam->gas->best_n){
-        GAM_QueryResult gqr_lookup = {.query_id = gam_result->query->id};
-        void *tree_node = tfind((void*)&gqr_lookup,
-                                      &gam_result->gam->bestn_tree,
-                                      GAM_compare_id);
-        gqr = tree_node ? *(GAM_QueryResult **)tree_node : NULL;
-        if(!gqr){
-            gqr = GAM_QueryResult_create(gam_result->gam,
-                                         gam_result->query->id);
-            tsearch((void*)gqr, &gam_result->gam->bestn_tree, GAM_compare_id);
+    if(!gam_result->gam->gas->best_n){
+#ifdef USE_PTHREADS
+        output_buffer = GAM_OutputBuffer_create();
+        GAM_Result_display(gam_result, output_buffer->fp);
+        GAM_OutputBuffer_finish(output_buffer);
+        if(gam_result->order_id != -1){
+            GAM_order_set_ready(gam_result->gam, gam_result->order_id,
+                                output_buffer);
+            return;
             }
-        g_assert(gqr);
-        g_assert(!strcmp(gqr->query_id, gam_result->query->id));
-        GAM_QueryResult_submit(gqr, gam_result);
-    } else {
-        GAM_Result_display(gam_result);
+        GAM_lock(gam_result->gam);
+        GAM_OutputBuffer_write(output_buffer, stdout);
+        GAM_unlock(gam_result->gam);
+        GAM_OutputBuffer_destroy(output_buffer);
+#else /* USE_PTHREADS */
+        GAM_Result_display(gam_result, stdout);
+#endif /* USE_PTHREADS */
+        return;
         }
+    GAM_lock(gam_result->gam);
+    gqr = GAM_QueryResult_lookup(gam_result->gam, gam_result->query->id);
+    g_assert(!strcmp(gqr->query_id, gam_result->query->id));
+    GAM_QueryResult_submit(gqr, gam_result);
     GAM_unlock(gam_result->gam);
     return;
     }
+/* Without best_n, results are left in the stdout buffer,
+ * which is flushed at query and report boundaries.
+ */
 
 void GAM_lock(GAM *gam){
 #ifdef USE_PTHREADS
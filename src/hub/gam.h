@@ -59,8 +59,10 @@ typedef struct {
           gboolean  show_vulgar;
           gboolean  show_query_gff;
           gboolean  show_target_gff;
+          gboolean  show_binary;
              gchar *ryo;
               gint  best_n;
+              gint  bestn_memory_limit;
           gboolean  use_subopt;
           gboolean  use_gapped_extension;
       /**/
@@ -71,9 +73,31 @@ typedef struct {
 GAM_ArgumentSet *GAM_ArgumentSet_create(Argument *arg);
 
 typedef struct {
-       C4_Score score;
-          glong pos;
-          glong len;
+    gchar *data;
+    glong  size;
+    glong  used;
+     gint  live_count;
+} GAM_StoreBlock;
+
+typedef struct {
+              FILE *spill_file;
+             glong  spill_len;
+    GAM_StoreBlock *block;
+             glong  memory_used;
+             glong  memory_limit;
+} GAM_ResultStore;
+/* Best n results are kept in arena blocks until memory_limit
+ * is reached, after which they are appended to spill_file.
+ */
+
+typedef struct {
+          C4_Score  score;
+             gchar *data; /* NULL when in spill_file */
+             glong  pos;  /* Offset in spill_file */
+             glong  len;
+    GAM_StoreBlock *block;
+             glong *rank_pos_list; /* Offsets where the rank goes */
+              gint  rank_pos_total;
 } GAM_StoredResult;
 
 typedef struct {
@@ -81,6 +105,8 @@ typedef struct {
     PQueue *pq; /* Contains GAM_StoredResult */
       gint  tie_count; /* For best_n */
   C4_Score  tie_score; /* For best_n */
+      gint  job_count; /* Comparisons still running for this query */
+  gboolean  is_finished; /* Set by GAM_report_query() */
 } GAM_QueryResult;
 
 typedef struct {
@@ -88,6 +114,20 @@ typedef struct {
     C4_Score threshold;
 } GAM_QueryInfo;
 
+typedef struct {
+     FILE *fp;
+     char *data;
+    size_t len;
+} GAM_OutputBuffer;
+/* Output rendered in memory, to be written out in one block */
+
+#ifdef USE_PTHREADS
+typedef struct {
+            gboolean  is_ready;
+    GAM_OutputBuffer *output_buffer; /* NULL when there was no result */
+} GAM_OrderSlot;
+#endif /* USE_PTHREADS */
+
 typedef struct {
              ThreadRef *thread_ref;
          Alphabet_Type  query_type;
@@ -101,8 +141,9 @@ typedef struct {
                 Submat *protein_submat;
              Translate *translate;
        GAM_ArgumentSet *gas;
+         Alignment_RYO *ryo;
                   void *bestn_tree; /* Contains GAM_QueryResult */
-                  FILE *bestn_tmp_file;
+       GAM_ResultStore *bestn_store;
                   gint  verbosity;
               gboolean  translate_both;
               gboolean  dual_match;
@@ -112,6 +153,11 @@ typedef struct {
                   gint  max_target_span;
 #ifdef USE_PTHREADS
        pthread_mutex_t  gam_lock;
+                  gint  order_window; /* Zero unless output is ordered */
+                 glong  order_next_id;
+                 glong  order_emit_id;
+         GAM_OrderSlot *order_slot;
+        pthread_cond_t  order_cond; /* Signalled as results are written */
 #endif /* USE_PTHREADS */
 } GAM;
 
@@ -122,6 +168,21 @@ GAM *GAM_create(Alphabet_Type query_type, Alphabet_Type target_type,
 GAM *GAM_share(GAM *gam);
 void GAM_destroy(GAM *gam);
 void GAM_report(GAM *gam);
+void GAM_report_query(GAM *gam, gchar *query_id);
+void GAM_begin_query_job(GAM *gam, gchar *query_id);
+void GAM_end_query_job(GAM *gam, gchar *query_id);
+/* With best_n, GAM_report_query() is called once every comparison
+ * for a query has been submitted.  The results are reported
+ * when the last job begun for the query has ended.
+ */
+
+void GAM_write_bestn(GAM *gam, FILE *fp);
+void GAM_read_bestn(GAM *gam, FILE *fp);
+/* Best n results are written unreported, with their scores
+ * and the offsets where their ranks go,
+ * so they can be merged into the GAM of another process.
+ * Both processes must run the same binary with the same options.
+ */
 
 typedef struct {
          gint  ref_count;
@@ -132,6 +193,7 @@ typedef struct {
      gpointer  user_data;
      gpointer  self_data;
        SubOpt *subopt;
+        glong  order_id; /* -1 unless output is ordered */
 } GAM_Result;
 
 GAM_Result *GAM_Result_ungapped_create(GAM *gam,
@@ -153,6 +215,18 @@ GAM_Result *GAM_Result_share(GAM_Result *gam_result);
 void GAM_lock(GAM *gam);
 void GAM_unlock(GAM *gam);
 
+ void GAM_set_ordered_output(GAM *gam, gint window);
+glong GAM_order_next(GAM *gam);
+ void GAM_order_skip(GAM *gam, glong order_id);
+/* With ordered output, each comparison takes an id from GAM_order_next()
+ * in input order, and results are written to stdout in id order.
+ * GAM_order_next() waits while window results are pending,
+ * so it must only be called by the thread submitting the comparisons.
+ * Comparisons which give no GAM_Result must call GAM_order_skip().
+ * Without USE_PTHREADS, output is always in input order,
+ * and these calls do nothing.
+ */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -13,10 +13,215 @@
 *                                                                *
 \****************************************************************/
 
+#include <string.h> /* For strcmp() */
+
 #include "gam.h"
 
+typedef struct {
+    C4_Score  score;
+       gchar *data;
+       glong  rank_pos; /* -1 when there is no rank */
+} Test_BestN_Result;
+
+static void test_bestn_write_query(FILE *fp, gchar *query_id,
+                                   Test_BestN_Result *result,
+                                   gint result_total){
+    register gint i;
+    gint id_len = strlen(query_id), rank_pos_total;
+    glong len;
+    fwrite(&id_len, sizeof(gint), 1, fp);
+    fwrite(query_id, sizeof(gchar), id_len, fp);
+    fwrite(&result_total, sizeof(gint), 1, fp);
+    for(i = 0; i < result_total; i++){
+        len = strlen(result[i].data);
+        rank_pos_total = (result[i].rank_pos != -1);
+        fwrite(&result[i].score, sizeof(C4_Score), 1, fp);
+        fwrite(&len, sizeof(glong), 1, fp);
+        fwrite(&rank_pos_total, sizeof(gint), 1, fp);
+        fwrite(&result[i].rank_pos, sizeof(glong), rank_pos_total, fp);
+        fwrite(result[i].data, sizeof(gchar), len, fp);
+        }
+    return;
+    }
+/* Writes best n results in the GAM_write_bestn() format,
+ * as a forked worker would.
+ */
+
+static void test_bestn_merge(GAM *gam, gchar *query_id,
+                             Test_BestN_Result *result,
+                             gint result_total){
+    register FILE *fp = tmpfile();
+    g_assert(fp);
+    test_bestn_write_query(fp, query_id, result, result_total);
+    rewind(fp);
+    GAM_read_bestn(gam, fp);
+    fclose(fp);
+    return;
+    }
+
+static gint test_bestn_check(GAM *gam, gchar *query_id,
+                             Test_BestN_Result *expect,
+                             gint expect_total){
+    register FILE *fp = tmpfile();
+    register gint i, j, found = 0;
+    register gchar *data;
+    gint id_len, result_total, rank_pos_total;
+    gchar id[64];
+    C4_Score score;
+    glong len, rank_pos;
+    g_assert(fp);
+    GAM_write_bestn(gam, fp);
+    rewind(fp);
+    while(fread(&id_len, sizeof(gint), 1, fp) == 1){
+        g_assert(id_len < sizeof(id));
+        g_assert(fread(id, sizeof(gchar), id_len, fp) == id_len);
+        id[id_len] = '\0';
+        g_assert(fread(&result_total, sizeof(gint), 1, fp) == 1);
+        if(strcmp(id, query_id)){ /* Skip other queries */
+            for(i = 0; i < result_total; i++){
+                g_assert(fread(&score, sizeof(C4_Score), 1, fp) == 1);
+                g_assert(fread(&len, sizeof(glong), 1, fp) == 1);
+                g_assert(fread(&rank_pos_total, sizeof(gint), 1, fp) == 1);
+                g_assert(!fseek(fp, (sizeof(glong)*rank_pos_total) + len,
+                                SEEK_CUR));
+                }
+            continue;
+            }
+        g_assert(result_total == expect_total);
+        for(i = 0; i < result_total; i++){
+            g_assert(fread(&score, sizeof(C4_Score), 1, fp) == 1);
+            g_assert(fread(&len, sizeof(glong), 1, fp) == 1);
+            g_assert(fread(&rank_pos_total, sizeof(gint), 1, fp) == 1);
+            g_assert(rank_pos_total <= 1);
+            rank_pos = -1;
+            if(rank_pos_total)
+                g_assert(fread(&rank_pos, sizeof(glong), 1, fp) == 1);
+            data = g_new(gchar, len+1);
+            g_assert(fread(data, sizeof(gchar), len, fp) == len);
+            data[len] = '\0';
+            /* Each kept result must be expected, data unchanged */
+            for(j = 0; j < expect_total; j++)
+                if(!strcmp(expect[j].data, data))
+                    break;
+            g_assert(j < expect_total);
+            g_assert(expect[j].score == score);
+            g_assert(expect[j].rank_pos == rank_pos);
+            g_free(data);
+            found++;
+            }
+        }
+    fclose(fp);
+    return found;
+    }
+/* Returns the number of kept results for query_id,
+ * checking each against the expected set.
+ */
+
+static void test_bestn_merge_workers(GAM *gam){
+    Test_BestN_Result worker_a[] = {
+        {50, "vulgar: q1 t1 50\n", -1},
+        {30, "vulgar: q1 t2 30\n", -1},
+        {20, "vulgar: q1 t3 20\n", -1}},
+                      worker_b[] = {
+        {30, "vulgar: q1 t4 30\n", -1},
+        {10, "vulgar: q1 t5 10\n", -1}},
+                      worker_c[] = {
+        {60, "vulgar: q1 t6 60\n", -1}},
+                      worker_rank[] = {
+        {5, "rank:  of q2\n", 6}},
+                      expect_tie[] = {
+        {50, "vulgar: q1 t1 50\n", -1},
+        {30, "vulgar: q1 t2 30\n", -1},
+        {30, "vulgar: q1 t4 30\n", -1}},
+                      expect_top[] = {
+        {60, "vulgar: q1 t6 60\n", -1},
+        {50, "vulgar: q1 t1 50\n", -1}};
+    g_assert(gam->gas->best_n == 2);
+    /* t3 is skipped unread: it cannot beat the two already kept */
+    test_bestn_merge(gam, "q1", worker_a, 3);
+    g_assert(test_bestn_check(gam, "q1", expect_tie, 2) == 2);
+    /* A tie at the cut is kept, a worse result is skipped */
+    test_bestn_merge(gam, "q1", worker_b, 2);
+    g_assert(test_bestn_check(gam, "q1", expect_tie, 3) == 3);
+    /* A better result evicts both ties at the cut */
+    test_bestn_merge(gam, "q1", worker_c, 1);
+    g_assert(test_bestn_check(gam, "q1", expect_top, 2) == 2);
+    /* Rank positions are kept until the result is reported */
+    test_bestn_merge(gam, "q2", worker_rank, 1);
+    g_assert(test_bestn_check(gam, "q2", worker_rank, 1) == 1);
+    g_assert(test_bestn_check(gam, "q1", expect_top, 2) == 2);
+    return;
+    }
+
+static void test_bestn_query_jobs(GAM *gam){
+    Test_BestN_Result forward[] = {
+        {40, "vulgar: q3 t1 40 +\n", -1}},
+                      reverse[] = {
+        {45, "vulgar: q3 t1 45 -\n", -1}},
+                      expect_both[] = {
+        {45, "vulgar: q3 t1 45 -\n", -1},
+        {40, "vulgar: q3 t1 40 +\n", -1}},
+                      repeat[] = {
+        {15, "vulgar: q3 t2 15 +\n", -1}};
+    g_assert(gam->gas->best_n == 2);
+    /* Finish before end: reported when the last job ends */
+    GAM_begin_query_job(gam, "q3");
+    test_bestn_merge(gam, "q3", forward, 1);
+    GAM_report_query(gam, "q3");
+    g_assert(test_bestn_check(gam, "q3", forward, 1) == 1);
+    GAM_end_query_job(gam, "q3");
+    g_assert(test_bestn_check(gam, "q3", forward, 1) == 0);
+    /* End before finish: reported when finished */
+    GAM_begin_query_job(gam, "q3");
+    test_bestn_merge(gam, "q3", forward, 1);
+    GAM_end_query_job(gam, "q3");
+    g_assert(test_bestn_check(gam, "q3", forward, 1) == 1);
+    GAM_report_query(gam, "q3");
+    g_assert(test_bestn_check(gam, "q3", forward, 1) == 0);
+    /* A repeated query id (as for both strands) shares its results,
+     * and is reported once when the last of its jobs ends
+     */
+    GAM_begin_query_job(gam, "q3");
+    GAM_begin_query_job(gam, "q3");
+    test_bestn_merge(gam, "q3", forward, 1);
+    GAM_end_query_job(gam, "q3");
+    test_bestn_merge(gam, "q3", reverse, 1);
+    GAM_report_query(gam, "q3");
+    g_assert(test_bestn_check(gam, "q3", expect_both, 2) == 2);
+    GAM_end_query_job(gam, "q3");
+    g_assert(test_bestn_check(gam, "q3", expect_both, 2) == 0);
+    /* The id seen again after it is reported starts afresh */
+    GAM_begin_query_job(gam, "q3");
+    test_bestn_merge(gam, "q3", repeat, 1);
+    GAM_end_query_job(gam, "q3");
+    GAM_report_query(gam, "q3");
+    g_assert(test_bestn_check(gam, "q3", repeat, 1) == 0);
+    /* Queries without results are not reported */
+    GAM_report_query(gam, "q4");
+    g_assert(test_bestn_check(gam, "q4", repeat, 1) == 0);
+    return;
+    }
+/* Checks the GAM_begin_query_job(), GAM_end_query_job()
+ * and GAM_report_query() bookkeeping, in either order.
+ * A reported query leaves the best n tree.
+ */
+
 int Argument_main(Argument *arg){
-    g_warning("test [%s] not implemented", __FILE__);
+    register GAM_ArgumentSet *gas = GAM_ArgumentSet_create(arg);
+    register Match_ArgumentSet *mas;
+    register GAM *gam;
+    Match_ArgumentSet_create(arg);
+    Alignment_ArgumentSet_create(arg);
+    Argument_process(arg, "gam.test", NULL, NULL);
+    mas = Match_ArgumentSet_create(NULL); /* Creates mas->translate */
+    gas->best_n = 2;
+    gam = GAM_create(Alphabet_Type_DNA, Alphabet_Type_DNA,
+                     mas->dna_submat, mas->protein_submat,
+                     mas->translate, FALSE, 0);
+    test_bestn_merge_workers(gam);
+    test_bestn_query_jobs(gam);
+    GAM_report(gam);
+    GAM_destroy(gam);
     return 0;
     }
 
@@ -47,6 +47,89 @@ static C4_Score edit_match_calc_func(gint query_pos, gint target_pos,
          return -1;
     }
 
+/**/
+
+#define EditDistance_WORD_BITS 64
+
+static gint EditDistance_Block_advance(guint64 *pv, guint64 *mv,
+                                       guint64 eq, gint hin,
+                                       gint out_bit){
+    register guint64 xv, xh, ph, mh;
+    register guint64 hin_is_neg = (hin < 0)?1:0;
+    register gint hout;
+    xv = eq | *mv;
+    eq |= hin_is_neg;
+    xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+    ph = *mv | ~(xh | *pv);
+    mh = *pv & xh;
+    hout = (gint)((ph >> out_bit) & 1) - (gint)((mh >> out_bit) & 1);
+    ph <<= 1;
+    mh <<= 1;
+    mh |= hin_is_neg;
+    ph |= (hin > 0)?1:0;
+    *pv = mh | ~(xv | ph);
+    *mv = ph & xv;
+    return hout;
+    }
+/* Advances one block of the Myers/Hyyro bit-vectors by one column.
+ * hin is the horizontal delta entering the top row of the block,
+ * the delta leaving row out_bit of the block is returned.
+ */
+
+C4_Score EditDistance_find_score(EditDistance_Data *edd, Region *region){
+    register gint i, j, block, hin, symbol_total = 0;
+    register gint block_total
+        = (region->query_length + EditDistance_WORD_BITS - 1)
+        / EditDistance_WORD_BITS;
+    register gint last_bit
+        = (region->query_length - 1) % EditDistance_WORD_BITS;
+    register gchar *query = edd->query + region->query_start,
+                   *target = edd->target + region->target_start;
+    register guint64 *peq, *pv, *mv, *eq;
+    register gint distance = region->query_length;
+    gint symbol_map[256];
+    g_assert(Region_query_end(region) <= edd->query_len);
+    g_assert(Region_target_end(region) <= edd->target_len);
+    if(!region->query_length)
+        return -region->target_length;
+    /* Build the match vectors for each query symbol */
+    for(i = 0; i < 256; i++)
+        symbol_map[i] = -1;
+    for(i = 0; i < region->query_length; i++)
+        if(symbol_map[(guchar)query[i]] == -1)
+            symbol_map[(guchar)query[i]] = symbol_total++;
+    peq = g_new0(guint64, (symbol_total * block_total) + (block_total << 1));
+    pv = peq + (symbol_total * block_total);
+    mv = pv + block_total;
+    for(i = 0; i < region->query_length; i++){
+        block = symbol_map[(guchar)query[i]] * block_total
+              + (i / EditDistance_WORD_BITS);
+        peq[block] |= ((guint64)1) << (i % EditDistance_WORD_BITS);
+        }
+    for(i = 0; i < block_total; i++)
+        pv[i] = ~((guint64)0);
+    /* Each target symbol advances the blocks down the query */
+    for(j = 0; j < region->target_length; j++){
+        block = symbol_map[(guchar)target[j]];
+        eq = (block == -1)?NULL:(peq + (block * block_total));
+        hin = 1; /* Top row of the DP matrix increases by one */
+        for(i = 0; i < block_total; i++)
+            hin = EditDistance_Block_advance(&pv[i], &mv[i],
+                      eq?eq[i]:0, hin,
+                      (i == (block_total-1))?last_bit
+                                            :(EditDistance_WORD_BITS-1));
+        distance += hin;
+        }
+    g_free(peq);
+    return -distance;
+    }
+/* Returns the same score as Optimal_find_score() with this model,
+ * using the bit-parallel algorithm of Myers (1999)
+ * with the multi-word blocks of Hyyro (2003).
+ * Bits above the query end in the last block are never read,
+ * as carries only propagate towards higher rows.
+ */
+
 C4_Model *EditDistance_create(void){
     register C4_Model *edit_distance = C4_Model_create("edit distance");
     register C4_State
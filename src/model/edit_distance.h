@@ -34,6 +34,7 @@ EditDistance_Data *EditDistance_Data_create(gchar *query,
 void EditDistance_Data_destroy(EditDistance_Data *edd);
 
 C4_Model *EditDistance_create(void);
+C4_Score EditDistance_find_score(EditDistance_Data *edd, Region *region);
 
 #ifdef __cplusplus
 }
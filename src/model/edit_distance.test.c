@@ -38,6 +38,8 @@ int Argument_main(Argument *arg){
     register EditDistance_Data *edd = EditDistance_Data_create(qy, tg);
 /**/
     register C4_Score score;
+    register gint i;
+    register Region *sub_region;
     register Alignment *alignment;
     register Optimal *optimal = Optimal_create(edit_distance,
                                                NULL,
@@ -50,6 +52,15 @@ int Argument_main(Argument *arg){
     score = Optimal_find_score(optimal, region, edd, NULL);
     g_message("Score is [%d] (expect -23)", score);
     g_assert(score == -23);
+    g_assert(EditDistance_find_score(edd, region) == score);
+/**/
+    for(i = 0; i < edd->query_len; i += 7){
+        sub_region = Region_create(i, i >> 1, edd->query_len-i,
+                                   edd->target_len-(i >> 1));
+        g_assert(EditDistance_find_score(edd, sub_region)
+              == Optimal_find_score(optimal, sub_region, edd, NULL));
+        Region_destroy(sub_region);
+        }
 /**/
     alignment = Optimal_find_path(optimal, region, edd,
                                   C4_IMPOSSIBLY_LOW_SCORE, NULL);
@@ -95,6 +95,7 @@ typedef struct {
           HSP_Param *hsp_param;
           /**/
                gint  seed_repeat;
+               gint  two_hit_window;
                gint  dna_hsp_threshold;
                gint  protein_hsp_threshold;
                gint  codon_hsp_threshold;
@@ -124,6 +125,7 @@ static Exonerate_Server_Connection *Exonerate_Server_Connection_create(void){
     connection->revcomp_target = FALSE;
     /**/
     connection->seed_repeat = has->seed_repeat;
+    connection->two_hit_window = has->two_hit_window;
     connection->dna_hsp_threshold = has->dna_hsp_threshold;
     connection->protein_hsp_threshold = has->protein_hsp_threshold;
     connection->codon_hsp_threshold = has->codon_hsp_threshold;
@@ -232,6 +234,7 @@ static gchar *Exonerate_Server_help(void){
         "    valid parameters:\n"
         "        querytype\n"
         "        seedrepeat\n"
+        "        twohitwindow\n"
         "\n"
         "        dnahspthreshold\n"
         "        proteinhspthreshold\n"
@@ -408,6 +411,8 @@ static Sequence *Exonerate_Server_get_query(Index *index,
         g_assert(match);
         connection->hsp_param = HSP_Param_create(match, FALSE);
         connection->hsp_param->seed_repeat = connection->seed_repeat;
+        HSP_Param_set_two_hit_window(connection->hsp_param,
+                                     connection->two_hit_window);
         /**/
         HSP_Param_set_dna_hsp_threshold(connection->hsp_param,
                                         connection->dna_hsp_threshold);
@@ -462,6 +467,17 @@ static gchar *Exonerate_Server_set_param_seedrepeat(
     return g_strdup_printf("ok: set\n");
     }
 
+static gchar *Exonerate_Server_set_param_twohitwindow(
+              Exonerate_Server_Connection *connection, GPtrArray *word_list){
+    register gint two_hit_window = atoi(word_list->pdata[3]);
+    if(two_hit_window < 0)
+        return g_strdup_printf("error: twohitwindow must be >= 0\n");
+    connection->two_hit_window = two_hit_window;
+    if(connection->hsp_param)
+        HSP_Param_set_two_hit_window(connection->hsp_param, two_hit_window);
+    return g_strdup_printf("ok: set\n");
+    }
+
 /**/
 
 static gchar *Exonerate_Server_set_param_dnahspthreshold(
@@ -619,6 +635,8 @@ static gchar *Exonerate_Server_set_param(Exonerate_Server_Connection *connection
         reply = Exonerate_Server_set_param_querytype(connection, word_list);
     } else if(!strcmp(name, "seedrepeat")){
         reply = Exonerate_Server_set_param_seedrepeat(connection, word_list);
+    } else if(!strcmp(name, "twohitwindow")){
+        reply = Exonerate_Server_set_param_twohitwindow(connection, word_list);
     } else if(!strcmp(name, "dnahspthreshold")){
         reply = Exonerate_Server_set_param_dnahspthreshold(connection, word_list);
     } else if(!strcmp(name, "proteinhspthreshold")){
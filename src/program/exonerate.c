@@ -37,6 +37,7 @@
 
 int Argument_main(Argument *arg){
     register Analysis *analysis;
+    register GAM_ArgumentSet *gas;
     register ArgumentSet *as_input =
         ArgumentSet_create("Sequence Input Options");
     GPtrArray *query_path_list, *target_path_list;
@@ -80,7 +81,7 @@ int Argument_main(Argument *arg){
     Translate_ArgumentSet_create(arg);
     Analysis_ArgumentSet_create(arg);
     FastaDB_ArgumentSet_create(arg);
-    GAM_ArgumentSet_create(arg);
+    gas = GAM_ArgumentSet_create(arg);
     Viterbi_ArgumentSet_create(arg);
     Codegen_ArgumentSet_create(arg);
     Heuristic_ArgumentSet_create(arg);
@@ -120,7 +121,7 @@ int Argument_main(Argument *arg){
       "    exonerate --help\n"
       "    man exonerate\n"
       "\n");
-    if(verbosity > 0)
+    if((verbosity > 0) && (!gas->show_binary))
         Argument_info(arg);
     /**/
     analysis = Analysis_create(query_path_list, query_type,
@@ -131,7 +132,7 @@ int Argument_main(Argument *arg){
     Analysis_process(analysis);
     Analysis_destroy(analysis);
     /**/
-    if(verbosity > 0)
+    if((verbosity > 0) && (!gas->show_binary))
         g_print("-- completed exonerate analysis\n");
     return 0;
     }
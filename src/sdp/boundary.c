@@ -17,24 +17,27 @@
 
 /**/
 
-static Boundary_Interval *Boundary_Interval_create(gint query_pos,
+static Boundary_Interval *Boundary_Interval_create(Boundary *boundary,
+                                                   gint query_pos,
                                                    gint seed_id){
-    register Boundary_Interval *interval = g_new(Boundary_Interval, 1);
+    register Boundary_Interval *interval
+           = RecycleBin_alloc(boundary->interval_recycle);
     interval->query_pos = query_pos;
     interval->length = 1;
     interval->seed_id = seed_id;
     return interval;
     }
 
-static void Boundary_Interval_destroy(Boundary_Interval *interval){
-    g_free(interval);
+static void Boundary_Interval_destroy(Boundary *boundary,
+                                      Boundary_Interval *interval){
+    RecycleBin_recycle(boundary->interval_recycle, interval);
     return;
     }
 
-static Boundary_Interval *Boundary_Interval_copy(
+static Boundary_Interval *Boundary_Interval_copy(Boundary *boundary,
                           Boundary_Interval *interval){
     register Boundary_Interval *new_interval
-           = Boundary_Interval_create(interval->query_pos,
+           = Boundary_Interval_create(boundary, interval->query_pos,
                                       interval->seed_id);
     new_interval->length = interval->length;
     return new_interval;
@@ -46,22 +49,25 @@ static Boundary_Interval *Boundary_Interval_copy(
 
 /**/
 
-static Boundary_Row *Boundary_Row_create(gint target_pos){
-    register Boundary_Row *boundary_row = g_new(Boundary_Row, 1);
+static Boundary_Row *Boundary_Row_create(Boundary *boundary,
+                                         gint target_pos){
+    register Boundary_Row *boundary_row
+           = RecycleBin_alloc(boundary->row_recycle);
     boundary_row->target_pos = target_pos;
     boundary_row->interval_list = g_ptr_array_new();
     return boundary_row;
     }
 
-static void Boundary_Row_destroy(Boundary_Row *boundary_row){
+static void Boundary_Row_destroy(Boundary *boundary,
+                                 Boundary_Row *boundary_row){
     register gint i;
     register Boundary_Interval *interval;
     for(i = 0; i < boundary_row->interval_list->len; i++){
         interval = boundary_row->interval_list->pdata[i];
-        Boundary_Interval_destroy(interval);
+        Boundary_Interval_destroy(boundary, interval);
         }
     g_ptr_array_free(boundary_row->interval_list, TRUE);
-    g_free(boundary_row);
+    RecycleBin_recycle(boundary->row_recycle, boundary_row);
     return;
     }
 
@@ -80,8 +86,9 @@ static void Boundary_Row_print_gnuplot(Boundary_Row *boundary_row,
     return;
     }
 
-static Boundary_Row *Boundary_Row_copy(Boundary_Row *boundary_row){
-    register Boundary_Row *new_row = Boundary_Row_create(
+static Boundary_Row *Boundary_Row_copy(Boundary *boundary,
+                                       Boundary_Row *boundary_row){
+    register Boundary_Row *new_row = Boundary_Row_create(boundary,
                                            boundary_row->target_pos);
     register gint i;
     register Boundary_Interval *interval;
@@ -89,7 +96,7 @@ static Boundary_Row *Boundary_Row_copy(Boundary_Row *boundary_row){
     for(i = 0; i < boundary_row->interval_list->len; i++){
         interval = boundary_row->interval_list->pdata[i];
         g_ptr_array_add(new_row->interval_list,
-                        Boundary_Interval_copy(interval));
+                        Boundary_Interval_copy(boundary, interval));
         }
     return new_row;
     }
@@ -106,16 +113,18 @@ static void Boundary_Row_reverse(Boundary_Row *boundary_row){
     return;
     }
 
-static void Boundary_Row_add_interval(Boundary_Row *boundary_row,
+static void Boundary_Row_add_interval(Boundary *boundary,
+                          Boundary_Row *boundary_row,
                           gint query_pos, gint length, gint seed_id){
     register Boundary_Interval *interval
-           = Boundary_Interval_create(query_pos, seed_id);
+           = Boundary_Interval_create(boundary, query_pos, seed_id);
     interval->length = length;
     g_ptr_array_add(boundary_row->interval_list, interval);
     return;
     }
 
 static void Boundary_Row_select(Boundary_Row *boundary_row,
+                                Boundary *sub_boundary,
                                 Boundary_Row *sub_boundary_row,
                                 Region *region){
     register gint i, query_start, query_end;
@@ -130,7 +139,7 @@ static void Boundary_Row_select(Boundary_Row *boundary_row,
         query_end = MIN(interval->query_pos+interval->length,
                         Region_query_end(region));
         if(query_end-query_start > 0)
-            Boundary_Row_add_interval(sub_boundary_row,
+            Boundary_Row_add_interval(sub_boundary, sub_boundary_row,
                                       query_start, query_end-query_start,
                                       interval->seed_id);
         }
@@ -150,7 +159,7 @@ static Boundary_Interval *Boundary_Row_get_last_interval(
     return interval;
     }
 
-void Boundary_Row_prepend(Boundary_Row *boundary_row,
+void Boundary_Row_prepend(Boundary *boundary, Boundary_Row *boundary_row,
                           gint query_pos, gint seed_id){
     register Boundary_Interval *interval
            = Boundary_Row_get_last_interval(boundary_row);
@@ -161,11 +170,12 @@ void Boundary_Row_prepend(Boundary_Row *boundary_row,
         interval->length++;
         return;
         }
-    Boundary_Row_add_interval(boundary_row, query_pos, 1, seed_id);
+    Boundary_Row_add_interval(boundary, boundary_row, query_pos, 1, seed_id);
     return;
     }
 
-static void Boundary_Row_append_interval(Boundary_Row *boundary_row,
+static void Boundary_Row_append_interval(Boundary *boundary,
+                                         Boundary_Row *boundary_row,
                                          Boundary_Interval *interval){
     register Boundary_Interval *last_interval
            = Boundary_Row_get_last_interval(boundary_row);
@@ -178,9 +188,9 @@ static void Boundary_Row_append_interval(Boundary_Row *boundary_row,
         last_interval->length += interval->length;
         return;
         }
-    Boundary_Row_add_interval(boundary_row, interval->query_pos,
-                                            interval->length,
-                                            interval->seed_id);
+    Boundary_Row_add_interval(boundary, boundary_row,
+                              interval->query_pos, interval->length,
+                              interval->seed_id);
     return;
     }
 
@@ -195,7 +205,8 @@ typedef enum {
 #define Boundary_State_pair(prev_state, curr_state) \
                            (((prev_state) << 4) | (curr_state))
 
-static void Boundary_Row_insert_append(Boundary_Row *boundary_row,
+static void Boundary_Row_insert_append(Boundary *boundary,
+            Boundary_Row *boundary_row,
             Boundary_Interval *interval,
             Boundary_Interval *boundary_stored,
             Boundary_Interval *insert_stored,
@@ -205,7 +216,7 @@ static void Boundary_Row_insert_append(Boundary_Row *boundary_row,
         case Boundary_State_pair(Boundary_State_START,
                                  Boundary_State_INSERT):
             /* S->I: report I, store I */
-            Boundary_Row_append_interval(boundary_row, interval);
+            Boundary_Row_append_interval(boundary, boundary_row, interval);
             insert_stored->query_pos = interval->query_pos;
             insert_stored->length    = interval->length;
             insert_stored->seed_id   = interval->seed_id;
@@ -226,7 +237,7 @@ static void Boundary_Row_insert_append(Boundary_Row *boundary_row,
              *       store B if +ve len else clear
              */
             if(boundary_stored->seed_id != -1){
-                Boundary_Row_append_interval(boundary_row,
+                Boundary_Row_append_interval(boundary, boundary_row,
                                              boundary_stored);
                 }
             boundary_stored->query_pos = interval->query_pos;
@@ -269,11 +280,11 @@ static void Boundary_Row_insert_append(Boundary_Row *boundary_row,
                         temp_interval.seed_id
                                        = boundary_stored->seed_id;
                         if(temp_interval.length > 0)
-                            Boundary_Row_append_interval(boundary_row,
-                                                       &temp_interval);
+                            Boundary_Row_append_interval(boundary,
+                                        boundary_row, &temp_interval);
                     } else {
-                        Boundary_Row_append_interval(boundary_row,
-                                                     boundary_stored);
+                        Boundary_Row_append_interval(boundary,
+                                        boundary_row, boundary_stored);
                         }
                 /**/
                 if(Boundary_Interval_end(interval)
@@ -291,7 +302,7 @@ static void Boundary_Row_insert_append(Boundary_Row *boundary_row,
                     }
                 }
             /**/
-            Boundary_Row_append_interval(boundary_row, interval);
+            Boundary_Row_append_interval(boundary, boundary_row, interval);
             insert_stored->query_pos = interval->query_pos;
             insert_stored->length    = interval->length;
             insert_stored->seed_id   = interval->seed_id;
@@ -303,7 +314,7 @@ static void Boundary_Row_insert_append(Boundary_Row *boundary_row,
                                  Boundary_State_END):
             /* [IB]->E: report stored B */
             if(boundary_stored->seed_id != -1)
-                Boundary_Row_append_interval(boundary_row,
+                Boundary_Row_append_interval(boundary, boundary_row,
                                              boundary_stored);
             break;
         default:
@@ -332,12 +343,13 @@ static gboolean Boundary_Row_is_valid(Boundary_Row *boundary_row){
     return TRUE;
     }
 
-static void Boundary_Row_insert(Boundary_Row *boundary_row,
+static void Boundary_Row_insert(Boundary *boundary,
+                                Boundary_Row *boundary_row,
                                 Boundary_Row *insert_row){
     register gint i = 0, j = 0;
     register Boundary_Interval *boundary_interval, *insert_interval;
     register Boundary_Row *combined_row
-           = Boundary_Row_create(boundary_row->target_pos);
+           = Boundary_Row_create(boundary, boundary_row->target_pos);
     Boundary_Interval boundary_stored = {-1, -1, -1},
                       insert_stored   = {-1, -1, -1};
     Boundary_State curr_state = Boundary_State_START,
@@ -355,14 +367,16 @@ static void Boundary_Row_insert(Boundary_Row *boundary_row,
         if(insert_interval->query_pos < boundary_interval->query_pos){
             prev_state = curr_state;
             curr_state = Boundary_State_INSERT;
-            Boundary_Row_insert_append(combined_row, insert_interval,
+            Boundary_Row_insert_append(boundary, combined_row,
+                                insert_interval,
                                 &boundary_stored, &insert_stored,
                                 &prev_state, &curr_state);
             i++;
         } else {
             prev_state = curr_state;
             curr_state = Boundary_State_BOUNDARY;
-            Boundary_Row_insert_append(combined_row, boundary_interval,
+            Boundary_Row_insert_append(boundary, combined_row,
+                                boundary_interval,
                                 &boundary_stored, &insert_stored,
                                 &prev_state, &curr_state);
             j++;
@@ -372,7 +386,8 @@ static void Boundary_Row_insert(Boundary_Row *boundary_row,
         prev_state = curr_state;
         curr_state = Boundary_State_INSERT;
         insert_interval = insert_row->interval_list->pdata[i++];
-        Boundary_Row_insert_append(combined_row, insert_interval,
+        Boundary_Row_insert_append(boundary, combined_row,
+                                   insert_interval,
                                    &boundary_stored, &insert_stored,
                                    &prev_state, &curr_state);
         }
@@ -380,23 +395,24 @@ static void Boundary_Row_insert(Boundary_Row *boundary_row,
         prev_state = curr_state;
         curr_state = Boundary_State_BOUNDARY;
         boundary_interval = boundary_row->interval_list->pdata[j++];
-        Boundary_Row_insert_append(combined_row, boundary_interval,
+        Boundary_Row_insert_append(boundary, combined_row,
+                                   boundary_interval,
                                    &boundary_stored, &insert_stored,
                                    &prev_state, &curr_state);
         }
     prev_state = curr_state;
     curr_state = Boundary_State_END;
     /* B -> E  report stored */
-    Boundary_Row_insert_append(combined_row, NULL,
+    Boundary_Row_insert_append(boundary, combined_row, NULL,
                                &boundary_stored, &insert_stored,
                                &prev_state, &curr_state);
     for(i = 0; i < boundary_row->interval_list->len; i++){
         boundary_interval = boundary_row->interval_list->pdata[i];
-        Boundary_Interval_destroy(boundary_interval);
+        Boundary_Interval_destroy(boundary, boundary_interval);
         }
     g_ptr_array_free(boundary_row->interval_list, TRUE);
     boundary_row->interval_list = combined_row->interval_list;
-    g_free(combined_row);
+    RecycleBin_recycle(boundary->row_recycle, combined_row);
     g_assert(boundary_row->interval_list->len);
     g_assert(Boundary_Row_is_valid(boundary_row));
     return;
@@ -408,6 +424,10 @@ Boundary *Boundary_create(void){
     register Boundary *boundary = g_new(Boundary, 1);
     boundary->row_list = g_ptr_array_new();
     boundary->ref_count = 1;
+    boundary->row_recycle = RecycleBin_create("Boundary_Row",
+                                        sizeof(Boundary_Row), 256);
+    boundary->interval_recycle = RecycleBin_create("Boundary_Interval",
+                                        sizeof(Boundary_Interval), 1024);
     return boundary;
     }
 
@@ -417,11 +437,14 @@ void Boundary_destroy(Boundary *boundary){
     g_assert(boundary);
     if(--boundary->ref_count)
         return;
+    /* Rows and intervals are freed in bulk with the RecycleBins */
     for(i = 0; i < boundary->row_list->len; i++){
         boundary_row = boundary->row_list->pdata[i];
-        Boundary_Row_destroy(boundary_row);
+        g_ptr_array_free(boundary_row->interval_list, TRUE);
         }
     g_ptr_array_free(boundary->row_list, TRUE);
+    RecycleBin_destroy(boundary->row_recycle);
+    RecycleBin_destroy(boundary->interval_recycle);
     g_free(boundary);
     return;
     }
@@ -438,7 +461,7 @@ Boundary_Row *Boundary_add_row(Boundary *boundary, gint target_pos){
     register Boundary_Row *boundary_row;
     g_assert(boundary);
     g_assert(boundary->row_list);
-    boundary_row = Boundary_Row_create(target_pos);
+    boundary_row = Boundary_Row_create(boundary, target_pos);
     g_ptr_array_add(boundary->row_list, boundary_row);
     return boundary_row;
     }
@@ -461,12 +484,12 @@ void Boundary_remove_empty_last_row(Boundary *boundary){
         return;
     if(boundary_row->interval_list->len)
         return; /* Don't remove if not empty */
-    Boundary_Row_destroy(boundary_row);
+    Boundary_Row_destroy(boundary, boundary_row);
     g_ptr_array_set_size(boundary->row_list, boundary->row_list->len-1);
     return;
     }
 
-/* FIXME: optimisation: use RecycleBin for boundary rows and cells */
+/* Rows and intervals come from RecycleBins owned by the boundary */
 
 
 /**/
@@ -502,7 +525,8 @@ Boundary *Boundary_select(Boundary *boundary, Region *region){
             break;
         sub_boundary_row = Boundary_add_row(sub_boundary,
                                             boundary_row->target_pos);
-        Boundary_Row_select(boundary_row, sub_boundary_row, region);
+        Boundary_Row_select(boundary_row, sub_boundary, sub_boundary_row,
+                            region);
         Boundary_remove_empty_last_row(sub_boundary);
         }
     return sub_boundary;
@@ -546,14 +570,15 @@ void Boundary_insert(Boundary *boundary, Boundary *insert){
                 last_boundary_row = boundary->row_list->pdata[j-1];
                 if(insert_row->target_pos
                 == last_boundary_row->target_pos){
-                    Boundary_Row_insert(last_boundary_row, insert_row);
+                    Boundary_Row_insert(boundary, last_boundary_row,
+                                        insert_row);
                 } else {
                     g_ptr_array_add(combined_row_list,
-                                    Boundary_Row_copy(insert_row));
+                                    Boundary_Row_copy(boundary, insert_row));
                     }
             } else {
                 g_ptr_array_add(combined_row_list,
-                                Boundary_Row_copy(insert_row));
+                                Boundary_Row_copy(boundary, insert_row));
                 }
         } else {
             j++;
@@ -566,14 +591,14 @@ void Boundary_insert(Boundary *boundary, Boundary *insert){
         last_boundary_row = boundary->row_list->pdata[j-1];
         insert_row = insert->row_list->pdata[i];
         if(insert_row->target_pos == last_boundary_row->target_pos){
-            Boundary_Row_insert(last_boundary_row, insert_row);
+            Boundary_Row_insert(boundary, last_boundary_row, insert_row);
             i++;
             }
         }
     while(i < insert->row_list->len){
         insert_row = insert->row_list->pdata[i++];
         g_ptr_array_add(combined_row_list,
-                        Boundary_Row_copy(insert_row));
+                        Boundary_Row_copy(boundary, insert_row));
         }
     while(j < boundary->row_list->len){
         boundary_row = boundary->row_list->pdata[j++];
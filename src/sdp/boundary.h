@@ -22,6 +22,7 @@ extern "C" {
 
 #include <glib.h>
 #include "region.h"
+#include "recyclebin.h"
 
 /**/
 
@@ -37,8 +38,10 @@ typedef struct {
 } Boundary_Row;
 
 typedef struct {
-         gint  ref_count;
-    GPtrArray *row_list;
+          gint  ref_count;
+     GPtrArray *row_list;
+    RecycleBin *row_recycle;
+    RecycleBin *interval_recycle;
 } Boundary;
 
 /**/
@@ -60,7 +63,7 @@ Boundary *Boundary_select(Boundary *boundary, Region *region);
 
 /**/
 
-void Boundary_Row_prepend(Boundary_Row *boundary_row,
+void Boundary_Row_prepend(Boundary *boundary, Boundary_Row *boundary_row,
                           gint query_pos, gint seed_id);
 
 void Boundary_insert(Boundary *boundary, Boundary *insert);
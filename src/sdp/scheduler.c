@@ -229,7 +229,7 @@ static void Scheduler_implement_DP(Scheduler *scheduler,
                         "Scheduler_SpanData_get_curr(\n"
                         "  span_data, spair->span_seed_cache,\n"
                         "  cell->query_pos, row->target_pos,\n"
-                        "  spair->straceback);\n");
+                        "  spair);\n");
                     /* Protect good present score from overwriting */
                     Codegen_printf(codegen,
                         "if(span_data->curr_span_seed\n"
@@ -439,10 +439,11 @@ static Scheduler_SpanSeed *Scheduler_SpanSeed_create(C4_Score score,
                          gint query_entry, gint target_entry,
                          STraceback_Cell *cell,
                          C4_Score *shadow_data,
-                         Scheduler *scheduler){
+                         Scheduler_Pair *spair){
     register Scheduler_SpanSeed *span_seed
-     = g_new(Scheduler_SpanSeed, 1);
+     = RecycleBin_alloc(spair->span_seed_recycle);
     register gint i;
+    register Scheduler *scheduler = spair->scheduler;
     register C4_Model *model = scheduler->model;
     span_seed->score = score;
     span_seed->max = max;
@@ -452,11 +453,10 @@ static Scheduler_SpanSeed *Scheduler_SpanSeed_create(C4_Score score,
     span_seed->cell = STraceback_Cell_share(cell);
     if(scheduler->is_forward
     && model->total_shadow_designations){
-        span_seed->shadow_data = g_new0(C4_Score,
-                                 model->total_shadow_designations);
-        if(shadow_data)
-            for(i = 0; i < model->total_shadow_designations; i++)
-                span_seed->shadow_data[i] = shadow_data[i];
+        /* Shadow data is stored after the span_seed */
+        span_seed->shadow_data = (C4_Score*)(span_seed+1);
+        for(i = 0; i < model->total_shadow_designations; i++)
+            span_seed->shadow_data[i] = shadow_data?shadow_data[i]:0;
     } else {
         span_seed->shadow_data = NULL;
         }
@@ -464,11 +464,9 @@ static Scheduler_SpanSeed *Scheduler_SpanSeed_create(C4_Score score,
     }
 
 static void Scheduler_SpanSeed_destroy(Scheduler_SpanSeed *span_seed,
-                                       STraceback *straceback){
-    if(span_seed->shadow_data)
-        g_free(span_seed->shadow_data);
-    STraceback_Cell_destroy(span_seed->cell, straceback);
-    g_free(span_seed);
+                                       Scheduler_Pair *spair){
+    STraceback_Cell_destroy(span_seed->cell, spair->straceback);
+    RecycleBin_recycle(spair->span_seed_recycle, span_seed);
     return;
     }
 
@@ -503,7 +501,7 @@ static Scheduler_SpanSeed *Scheduler_SpanSeed_duplicate(
                                span_seed->target_entry,
                                span_seed->cell,
                                span_seed->shadow_data,
-                               spair->scheduler);
+                               spair);
     }
 
 /**/
@@ -541,7 +539,7 @@ static void Scheduler_Cache_empty_func(SparseCache_Page *page,
         for(j = 0; j < spair->scheduler->model->span_list->len; j++){
             seed = seed_matrix[i][j];
             if(seed)
-                Scheduler_SpanSeed_destroy(seed, spair->straceback);
+                Scheduler_SpanSeed_destroy(seed, spair);
             }
     g_free(seed_matrix);
     g_free(page);
@@ -567,7 +565,7 @@ static void Scheduler_SpanData_destroy(Scheduler_SpanData *span_data){
 void Scheduler_SpanData_get_curr(Scheduler_SpanData *span_data,
                            SparseCache *cache,
                            gint query_pos, gint target_pos,
-                           STraceback *straceback){
+                           Scheduler_Pair *spair){
     register Scheduler_SpanSeed *stored_seed;
     g_assert(span_data);
     g_assert(cache);
@@ -597,7 +595,7 @@ void Scheduler_SpanData_get_curr(Scheduler_SpanData *span_data,
                 span_data->curr_span_seed = stored_seed;
                 }
         } else { /* Stored has expired */
-            Scheduler_SpanSeed_destroy(stored_seed, straceback);
+            Scheduler_SpanSeed_destroy(stored_seed, spair);
             Scheduler_Cache_set(cache, span_data->span->id, query_pos, NULL);
             }
         }
@@ -621,6 +619,10 @@ void Scheduler_SpanData_submit(Scheduler_SpanData *span_data,
                                SparseCache *cache, Scheduler_Pair *spair){
     register Scheduler_SpanSeed *stored_seed;
     if(span_data->span->max_target){ /* Challenge cache */
+        if(spair->target_reach < (span_seed->target_entry
+                                + span_data->span->max_target))
+            spair->target_reach = span_seed->target_entry
+                                + span_data->span->max_target;
         stored_seed = Scheduler_Cache_get(cache,
                                           span_data->span->id,
                                           span_seed->query_entry);
@@ -943,7 +945,7 @@ void Scheduler_Cell_process(Scheduler_Cell *cell,
                                                 spair->span_seed_cache,
                                                 cell->query_pos,
                                                 row->target_pos,
-                                                spair->straceback);
+                                                spair);
                     /* Protect good present score from overwriting */
                     if((span_data->curr_span_seed)
                     && (cell->score[input_pos][0]
@@ -1093,7 +1095,7 @@ static void Scheduler_Row_Lookahead_free_func(gpointer data,
 
 Scheduler_Row *Scheduler_Row_create(gint target_pos,
                                     Scheduler_Pair *spair){
-    register Scheduler_Row *row = g_new0(Scheduler_Row, 1);
+    register Scheduler_Row *row = RecycleBin_alloc(spair->row_recycle);
     if(spair->scheduler->is_forward){
         g_assert(target_pos >= 0);
     } else {
@@ -1201,14 +1203,15 @@ static void Scheduler_Row_traverse_cell_destroy(gpointer data,
         g_assert(boundary_row);
         state_id = model->start_state->state->id;
         if(cell->score[state_id][0] >= 0){
-            Boundary_Row_prepend(boundary_row, -cell->query_pos,
-                                 cell->score[state_id][2]);
+            Boundary_Row_prepend(spair->boundary, boundary_row,
+                                 -cell->query_pos, cell->score[state_id][2]);
         } else {
             for(i = 0; i < model->span_list->len; i++){
                 span = model->span_list->pdata[i];
                 state_id = span->span_state->id;
                 if(cell->score[state_id][0] > 0){
-                    Boundary_Row_prepend(boundary_row, -cell->query_pos,
+                    Boundary_Row_prepend(spair->boundary, boundary_row,
+                                         -cell->query_pos,
                                          cell->score[state_id][2]);
                     break;
                     }
@@ -1236,7 +1239,7 @@ static void Scheduler_Row_destroy(Scheduler_Row *row,
                             Scheduler_Row_traverse_cell_destroy, &std);
     if(boundary_row)
         Boundary_remove_empty_last_row(spair->boundary);
-    g_free(row);
+    RecycleBin_recycle(spair->row_recycle, row);
     return;
     }
 
@@ -1482,6 +1485,8 @@ void Scheduler_Pair_calculate(Scheduler_Pair *spair){
             }
         Scheduler_Pair_reset_rows(spair);
         Scheduler_Row_process(row, spair);
+        if(spair->target_reach < row->target_pos)
+            spair->target_reach = row->target_pos;
         Lookahead_next(spair->row_index);
     } while(TRUE);
     /* Call model calc exit funcs */
@@ -1533,6 +1538,8 @@ Scheduler_Pair *Scheduler_Pair_create(
                Scheduler_Lookahead_free_func, spair);
     spair->cell_recycle = RecycleBin_create("Scheduler_Cell",
                                             scheduler->cell_size, 1024);
+    spair->row_recycle = RecycleBin_create("Scheduler_Row",
+                                           sizeof(Scheduler_Row), 64);
     if(scheduler->use_boundary){
         g_assert(boundary);
         spair->boundary = Boundary_share(boundary);
@@ -1542,15 +1549,26 @@ Scheduler_Pair *Scheduler_Pair_create(
                                                     NULL, spair);
         spair->span_history = Scheduler_SpanHistory_create(spair->slist_set,
                                                            scheduler->model);
+        spair->span_seed_recycle = RecycleBin_create("Scheduler_SpanSeed",
+            sizeof(Scheduler_SpanSeed)
+          + (scheduler->is_forward
+            ?(sizeof(C4_Score)*scheduler->model->total_shadow_designations)
+            :0), 1024);
     } else {
         g_assert(!boundary);
         spair->boundary = NULL;
         spair->span_history = NULL;
         spair->span_seed_cache = NULL;
+        spair->span_seed_recycle = NULL;
         }
     spair->subopt_index = SubOpt_Index_create(subopt, spair->region);
+    spair->target_reach = scheduler->is_forward?-1:-(target_len+1);
     return spair;
     }
+/* spair->target_reach records the furthest row (in the row coordinates
+ * of the scheduler) which any cell or live span seed could have reached,
+ * so callers can check whether separately calculated seeds interacted.
+ */
 
 void Scheduler_Pair_destroy(Scheduler_Pair *spair){
     if(spair->straceback)
@@ -1562,9 +1580,12 @@ void Scheduler_Pair_destroy(Scheduler_Pair *spair){
     Region_destroy(spair->region);
     Lookahead_destroy(spair->row_index);
     RecycleBin_destroy(spair->cell_recycle);
+    RecycleBin_destroy(spair->row_recycle);
     SListSet_destroy(spair->slist_set);
     if(spair->span_seed_cache)
         SparseCache_destroy(spair->span_seed_cache);
+    if(spair->span_seed_recycle)
+        RecycleBin_destroy(spair->span_seed_recycle);
     if(spair->subopt_index)
         SubOpt_Index_destroy(spair->subopt_index);
     g_free(spair);
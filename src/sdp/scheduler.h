@@ -139,13 +139,16 @@ typedef struct Scheduler_Pair {
                  gpointer   seed_data;
                 Lookahead  *row_index;
                RecycleBin  *cell_recycle;
+               RecycleBin  *row_recycle;
                STraceback  *straceback;
 /**/
                  Boundary  *boundary;
               SparseCache  *span_seed_cache;
+               RecycleBin  *span_seed_recycle;
     Scheduler_SpanHistory  *span_history;
 /**/
              SubOpt_Index  *subopt_index;
+                     gint   target_reach; /* Furthest row reached */
 } Scheduler_Pair;
 
 Scheduler_Pair *Scheduler_Pair_create(
@@ -205,7 +208,7 @@ void Scheduler_Cell_assign(Scheduler_Pair *spair,
 void Scheduler_SpanData_get_curr(Scheduler_SpanData *span_data,
                                  SparseCache *cache,
                                  gint query_pos, gint target_pos,
-                                 STraceback *straceback);
+                                 Scheduler_Pair *spair);
 void Scheduler_SpanData_submit(Scheduler_SpanData *span_data,
                                 Scheduler_SpanSeed *span_seed,
                                 SparseCache *cache,
@@ -17,6 +17,7 @@
 
 #include "sdp.h"
 #include "matrix.h"
+#include "radixsort.h"
 
 /**/
 
@@ -31,6 +32,11 @@ SDP_ArgumentSet *SDP_ArgumentSet_create(Argument *arg){
         ArgumentSet_add_option(as, 0, "singlepass", NULL,
                 "Generate suboptimal alignment in a single pass", "TRUE",
                 Argument_parse_boolean, &sas.single_pass_subopt);
+#ifdef USE_PTHREADS
+        ArgumentSet_add_option(as, 0, "seedthreads", "number",
+                "Number of threads for independent seed regions", "1",
+                Argument_parse_int, &sas.thread_count);
+#endif /* USE_PTHREADS */
         Argument_absorb_ArgumentSet(arg, as);
         }
     return &sas;
@@ -41,6 +47,8 @@ SDP_ArgumentSet *SDP_ArgumentSet_create(Argument *arg){
 typedef struct {
      GPtrArray *seed_list;
           gint  seed_pos;
+          gint  first_seed; /* Range of seed_list to use */
+          gint  last_seed;
           gint  seed_state_id;
       SDP_Pair *sdp_pair;
 } Scheduler_Seed_List;
@@ -52,6 +60,8 @@ static Scheduler_Seed_List *Scheduler_Seed_List_create(SDP_Pair *sdp_pair,
     register C4_Model *model = sdp_pair->sdp->model;
     seed_info_list->seed_list = sdp_pair->seed_list;
     seed_info_list->seed_pos = 0;
+    seed_info_list->first_seed = 0;
+    seed_info_list->last_seed = sdp_pair->seed_list->len - 1;
     if(is_forward){
         seed_info_list->seed_state_id = model->start_state->state->id;
     } else {
@@ -70,21 +80,21 @@ static void Scheduler_Seed_List_destroy(
 static void Scheduler_Seed_List_init_forward(gpointer seed_data){
     register Scheduler_Seed_List *seed_info_list = seed_data;
     g_assert(seed_info_list);
-    seed_info_list->seed_pos = 0;
+    seed_info_list->seed_pos = seed_info_list->first_seed;
     return;
     }
 
 static void Scheduler_Seed_List_init_reverse(gpointer seed_data){
     register Scheduler_Seed_List *seed_info_list = seed_data;
     g_assert(seed_info_list);
-    seed_info_list->seed_pos = seed_info_list->seed_list->len - 1;
+    seed_info_list->seed_pos = seed_info_list->last_seed;
     return;
     }
 
 static void Scheduler_Seed_List_next_forward(gpointer seed_data){
     register Scheduler_Seed_List *seed_info_list = seed_data;
     g_assert(seed_info_list);
-    g_assert(seed_info_list->seed_pos < seed_info_list->seed_list->len);
+    g_assert(seed_info_list->seed_pos <= seed_info_list->last_seed);
     seed_info_list->seed_pos++;
     return;
     }
@@ -92,7 +102,7 @@ static void Scheduler_Seed_List_next_forward(gpointer seed_data){
 static void Scheduler_Seed_List_next_reverse(gpointer seed_data){
     register Scheduler_Seed_List *seed_info_list = seed_data;
     g_assert(seed_info_list);
-    g_assert(seed_info_list->seed_pos >= 0);
+    g_assert(seed_info_list->seed_pos >= seed_info_list->first_seed);
     seed_info_list->seed_pos--;
     return;
     }
@@ -102,7 +112,7 @@ static gboolean Scheduler_Seed_List_get_forward(gpointer seed_data,
     register Scheduler_Seed_List *seed_info_list = seed_data;
     register SDP_Seed *seed;
     g_assert(seed_info_list);
-    if(seed_info_list->seed_pos >= seed_info_list->seed_list->len)
+    if(seed_info_list->seed_pos > seed_info_list->last_seed)
         return FALSE;
     seed = seed_info_list->seed_list->pdata[seed_info_list->seed_pos];
     seed_info->query_pos = HSP_query_cobs(seed->hsp);
@@ -118,7 +128,7 @@ static gboolean Scheduler_Seed_List_get_reverse(gpointer seed_data,
     register Scheduler_Seed_List *seed_info_list = seed_data;
     register SDP_Seed *seed;
     g_assert(seed_info_list);
-    if(seed_info_list->seed_pos < 0)
+    if(seed_info_list->seed_pos < seed_info_list->first_seed)
         return FALSE;
     seed = seed_info_list->seed_list->pdata[seed_info_list->seed_pos];
     seed_info->query_pos = -HSP_query_cobs(seed->hsp);
@@ -373,6 +383,14 @@ void SDP_destroy(SDP *sdp){
     return;
     }
 
+#ifdef USE_PTHREADS
+void SDP_set_job_queue(SDP *sdp, JobQueue *job_queue){
+    g_assert(sdp);
+    sdp->job_queue = job_queue;
+    return;
+    }
+#endif /* USE_PTHREADS */
+
 /**/
 
 static void SDP_add_codegen(Scheduler *scheduler,
@@ -395,8 +413,8 @@ GPtrArray *SDP_get_codegen_list(SDP *sdp){
 
 /**/
 
-static SDP_Terminal *SDP_Terminal_create(void){
-    register SDP_Terminal *terminal = g_new(SDP_Terminal, 1);
+static SDP_Terminal *SDP_Terminal_create(RecycleBin *terminal_recycle){
+    register SDP_Terminal *terminal = RecycleBin_alloc(terminal_recycle);
     terminal->query_pos = 0;
     terminal->target_pos = 0;
     terminal->score = C4_IMPOSSIBLY_LOW_SCORE;
@@ -404,51 +422,37 @@ static SDP_Terminal *SDP_Terminal_create(void){
     return terminal;
     }
 
-static void SDP_Terminal_destroy(SDP_Terminal *terminal,
-                                 STraceback *straceback){
-    if(terminal->cell)
-        STraceback_Cell_destroy(terminal->cell, straceback);
-    g_free(terminal);
-    return;
-    }
-
 /**/
 
-static SDP_Seed *SDP_Seed_create(HSP *hsp, gint id){
+static SDP_Seed *SDP_Seed_create(HSP *hsp, gint id,
+                                 RecycleBin *terminal_recycle){
     register SDP_Seed *seed = g_new(SDP_Seed, 1);
     seed->seed_id = id;
     seed->hsp = hsp;
-    seed->max_start = SDP_Terminal_create();
-    seed->max_end = SDP_Terminal_create();
+    seed->max_start = SDP_Terminal_create(terminal_recycle);
+    seed->max_end = SDP_Terminal_create(terminal_recycle);
     seed->pq_node = NULL;
     return seed;
     }
-/* FIXME: optimisation: use RecycleBins for SDP_Terminal allocations
- */
 
-static void SDP_Seed_destroy(SDP_Seed *seed, STraceback *fwd_straceback,
-                                             STraceback *rev_straceback){
-    SDP_Terminal_destroy(seed->max_start, rev_straceback);
-    SDP_Terminal_destroy(seed->max_end, fwd_straceback);
+static void SDP_Seed_destroy(SDP_Seed *seed){
     g_free(seed);
     return;
     }
+/* The terminals and their traceback cells are not released here,
+ * as they are freed in bulk with the RecycleBins of the SDP_Pair
+ */
 
 /**/
 
-static int SDP_compare_HSP_cobs_in_forward_dp_order(const void *a,
-                                                    const void *b){
-    register HSP **hsp_a = (HSP**)a,
-                 **hsp_b = (HSP**)b;
-    register gint target_diff = HSP_target_cobs(*hsp_a)
-                              - HSP_target_cobs(*hsp_b);
-    if(!target_diff)
-        return HSP_query_cobs(*hsp_a)
-             - HSP_query_cobs(*hsp_b);
-    return target_diff;
+static guint64 SDP_HSP_cobs_forward_dp_order_key(gconstpointer data,
+                                                 gpointer user_data){
+    register const HSP *hsp = data;
+    return RadixSort_pair_key(HSP_target_cobs(hsp), HSP_query_cobs(hsp));
     }
 
-static GPtrArray *SDP_Pair_create_seed_list(Comparison *comparison){
+static GPtrArray *SDP_Pair_create_seed_list(Comparison *comparison,
+                                            RecycleBin *terminal_recycle){
     register gint i;
     register SDP_Seed *seed;
     register HSP *hsp, *prev_hsp = NULL;
@@ -473,9 +477,8 @@ static GPtrArray *SDP_Pair_create_seed_list(Comparison *comparison){
             g_ptr_array_add(hsp_list, hsp);
             }
     /* Sort hsps on cobs point in DP order */
-    qsort(hsp_list->pdata,
-          hsp_list->len, sizeof(gpointer),
-          SDP_compare_HSP_cobs_in_forward_dp_order);
+    RadixSort_sort_pointers(hsp_list->pdata, hsp_list->len,
+                            SDP_HSP_cobs_forward_dp_order_key, NULL);
     /* Make a seed for each unique HSP */
     g_assert(hsp_list->len);
     for(i = 0; i < hsp_list->len; i++){
@@ -483,7 +486,7 @@ static GPtrArray *SDP_Pair_create_seed_list(Comparison *comparison){
         if((!prev_hsp)
         || (HSP_query_cobs(hsp) != HSP_query_cobs(prev_hsp))
         || (HSP_target_cobs(hsp) != HSP_target_cobs(prev_hsp))){
-            seed = SDP_Seed_create(hsp, seed_list->len);
+            seed = SDP_Seed_create(hsp, seed_list->len, terminal_recycle);
             g_ptr_array_add(seed_list, seed);
             }
         prev_hsp = hsp;
@@ -503,9 +506,15 @@ SDP_Pair *SDP_Pair_create(SDP *sdp, SubOpt *subopt,
     g_assert(Comparison_has_hsps(comparison));
     sdp_pair->comparison = Comparison_share(comparison);
     sdp_pair->user_data = user_data;
+    sdp_pair->create_data_func = NULL;
+    sdp_pair->destroy_data_func = NULL;
+    sdp_pair->data_func_data = NULL;
     sdp_pair->alignment_count = 0;
     sdp_pair->subopt = SubOpt_share(subopt);
-    sdp_pair->seed_list = SDP_Pair_create_seed_list(comparison);
+    sdp_pair->terminal_recycle = RecycleBin_create("SDP_Terminal",
+                                         sizeof(SDP_Terminal), 512);
+    sdp_pair->seed_list = SDP_Pair_create_seed_list(comparison,
+                                         sdp_pair->terminal_recycle);
     sdp_pair->seed_list_by_score = NULL;
     sdp_pair->boundary = NULL;
     sdp_pair->last_score = C4_IMPOSSIBLY_LOW_SCORE;
@@ -522,10 +531,10 @@ void SDP_Pair_destroy(SDP_Pair *sdp_pair){
     SDP_destroy(sdp_pair->sdp);
     for(i = 0; i < sdp_pair->seed_list->len; i++){
         seed = sdp_pair->seed_list->pdata[i];
-        SDP_Seed_destroy(seed, sdp_pair->fwd_straceback,
-                               sdp_pair->rev_straceback);
+        SDP_Seed_destroy(seed);
         }
     g_ptr_array_free(sdp_pair->seed_list, TRUE);
+    RecycleBin_destroy(sdp_pair->terminal_recycle);
     if(sdp_pair->seed_list_by_score)
         g_free(sdp_pair->seed_list_by_score);
     SubOpt_destroy(sdp_pair->subopt);
@@ -537,6 +546,19 @@ void SDP_Pair_destroy(SDP_Pair *sdp_pair){
     return;
     }
 
+void SDP_Pair_set_data_funcs(SDP_Pair *sdp_pair,
+                             SDP_Pair_create_data_Func create_data_func,
+                             SDP_Pair_destroy_data_Func destroy_data_func,
+                             gpointer data_func_data){
+    g_assert(sdp_pair);
+    g_assert(create_data_func);
+    g_assert(destroy_data_func);
+    sdp_pair->create_data_func = create_data_func;
+    sdp_pair->destroy_data_func = destroy_data_func;
+    sdp_pair->data_func_data = data_func_data;
+    return;
+    }
+
 /**/
 
 static Boundary *SDP_Pair_find_start_points(SDP_Pair *sdp_pair){
@@ -599,31 +621,442 @@ static void SDP_Pair_find_end_points(SDP_Pair *sdp_pair){
 
 /**/
 
-static Boundary *SDP_Pair_update_starts(SDP_Pair *sdp_pair){
+#ifdef USE_PTHREADS
+typedef struct {
+          gint  first_seed;   /* Range of sdp_pair->seed_list */
+          gint  last_seed;
+      Boundary *boundary;
+    STraceback *straceback;
+          gint  target_reach; /* From the last Scheduler_Pair */
+      gboolean  is_calculated;
+} SDP_Region;
+
+static SDP_Region *SDP_Region_create(gint first_seed, gint last_seed){
+    register SDP_Region *region = g_new(SDP_Region, 1);
+    g_assert(first_seed <= last_seed);
+    region->first_seed = first_seed;
+    region->last_seed = last_seed;
+    region->boundary = NULL;
+    region->straceback = NULL;
+    region->target_reach = 0;
+    region->is_calculated = FALSE;
+    return region;
+    }
+
+static void SDP_Region_destroy(SDP_Region *region){
+    if(region->boundary)
+        Boundary_destroy(region->boundary);
+    if(region->straceback)
+        STraceback_destroy(region->straceback);
+    g_free(region);
+    return;
+    }
+
+static void SDP_Region_reset(SDP_Region *region, SDP_Pair *sdp_pair,
+                             gboolean is_forward){
     register gint i;
     register SDP_Seed *seed;
-    g_assert(sdp_pair->seed_list->len);
-    /* Set max start scores low */
+    register SDP_Terminal *terminal;
+    for(i = region->first_seed; i <= region->last_seed; i++){
+        seed = sdp_pair->seed_list->pdata[i];
+        terminal = is_forward?seed->max_end:seed->max_start;
+        terminal->score = C4_IMPOSSIBLY_LOW_SCORE;
+        terminal->cell = NULL; /* Freed with region->straceback */
+        }
+    if(region->straceback){
+        STraceback_destroy(region->straceback);
+        region->straceback = NULL;
+        }
+    if((!is_forward) && region->boundary){
+        Boundary_destroy(region->boundary);
+        region->boundary = NULL;
+        }
+    region->is_calculated = FALSE;
+    return;
+    }
+
+static void SDP_Region_calculate(SDP_Region *region, SDP_Pair *sdp_pair,
+                                 gboolean is_forward, gpointer user_data){
+    register Scheduler_Pair *spair;
+    register Scheduler_Seed_List *seed_info_list = NULL;
+    register Scheduler_Seed_Boundary *seed_info_boundary = NULL;
+    register Scheduler *scheduler = is_forward
+                                  ? sdp_pair->sdp->find_ends_scheduler
+                                  : sdp_pair->sdp->find_starts_scheduler;
+    g_assert(!region->straceback);
+    region->straceback = STraceback_create(sdp_pair->sdp->model,
+                                           is_forward);
+    if(sdp_pair->sdp->use_boundary && (!is_forward)){
+        g_assert(!region->boundary);
+        region->boundary = Boundary_create();
+        }
+    if(sdp_pair->sdp->use_boundary && is_forward){
+        seed_info_boundary = Scheduler_Seed_Boundary_create(region->boundary,
+                                                            sdp_pair);
+        spair = Scheduler_Pair_create(scheduler, region->straceback,
+                              sdp_pair->comparison->query->len,
+                              sdp_pair->comparison->target->len,
+                              sdp_pair->subopt, region->boundary, -1,
+                              seed_info_boundary, user_data);
+    } else {
+        seed_info_list = Scheduler_Seed_List_create(sdp_pair, is_forward);
+        seed_info_list->first_seed = region->first_seed;
+        seed_info_list->last_seed = region->last_seed;
+        spair = Scheduler_Pair_create(scheduler, region->straceback,
+                              sdp_pair->comparison->query->len,
+                              sdp_pair->comparison->target->len,
+                              sdp_pair->subopt, region->boundary, -1,
+                              seed_info_list, user_data);
+        }
+    Scheduler_Pair_calculate(spair);
+    region->target_reach = spair->target_reach;
+    Scheduler_Pair_destroy(spair);
+    if(seed_info_boundary)
+        Scheduler_Seed_Boundary_destroy(seed_info_boundary);
+    if(seed_info_list)
+        Scheduler_Seed_List_destroy(seed_info_list);
+    if(region->boundary && (!is_forward))
+        Boundary_reverse(region->boundary);
+    region->is_calculated = TRUE;
+    return;
+    }
+
+static gboolean SDP_Region_is_independent(SDP_Region *region,
+                                          SDP_Region *next_region,
+                                          SDP_Pair *sdp_pair,
+                                          gboolean is_forward){
+    register SDP_Seed *seed;
+    register Boundary_Row *boundary_row;
+    register gint next_row;
+    register gint max_advance = sdp_pair->sdp->model->max_target_advance;
+    if(is_forward){
+        if(sdp_pair->sdp->use_boundary){
+            boundary_row = next_region->boundary->row_list->pdata[0];
+            next_row = boundary_row->target_pos;
+        } else {
+            seed = sdp_pair->seed_list->pdata[next_region->first_seed];
+            next_row = HSP_target_cobs(seed->hsp);
+            }
+        return (region->target_reach + max_advance) < next_row;
+        }
+    seed = sdp_pair->seed_list->pdata[region->last_seed];
+    next_row = -HSP_target_cobs(seed->hsp);
+    return (next_region->target_reach + max_advance) < next_row;
+    }
+/* The scheduler only pulls in a seed within max_target_advance
+ * of the current row, so when the DP started from one region
+ * has died out before this, the next region starts afresh
+ * exactly as it would in a single pass.
+ */
+
+static gboolean SDP_Pair_merge_regions(SDP_Pair *sdp_pair,
+                                       GPtrArray *region_list,
+                                       gboolean is_forward){
+    register gint i;
+    register SDP_Region *region, *next_region;
+    register gboolean has_merged = FALSE;
+    for(i = region_list->len-2; i >= 0; i--){
+        region = region_list->pdata[i];
+        next_region = region_list->pdata[i+1];
+        if((!region->is_calculated) || (!next_region->is_calculated))
+            continue;
+        if(SDP_Region_is_independent(region, next_region,
+                                     sdp_pair, is_forward))
+            continue;
+        SDP_Region_reset(region, sdp_pair, is_forward);
+        SDP_Region_reset(next_region, sdp_pair, is_forward);
+        region->last_seed = next_region->last_seed;
+        if(is_forward && region->boundary)
+            Boundary_insert(region->boundary, next_region->boundary);
+        SDP_Region_destroy(next_region);
+        g_ptr_array_remove_index(region_list, i+1);
+        has_merged = TRUE;
+        }
+    return has_merged;
+    }
+/* Regions which interacted are joined and marked for recalculation.
+ * Pairs involving a region awaiting recalculation are checked
+ * on the next round.
+ */
+
+typedef struct {
+               gint  ref_count;
+           SDP_Pair *sdp_pair;
+        SDP_Region **region_list; /* Regions awaiting calculation */
+               gint  region_total;
+               gint  next_region;
+               gint  running_count;
+           gboolean  is_forward;
+    pthread_mutex_t  region_lock;
+     pthread_cond_t  region_cond;  /* Signalled when no jobs are running */
+} SDP_RegionQueue;
+/* Jobs which start after the calling thread has finished
+ * find no regions left, and only drop their reference.
+ */
+
+static SDP_RegionQueue *SDP_RegionQueue_create(SDP_Pair *sdp_pair,
+                                               GPtrArray *region_list,
+                                               gboolean is_forward){
+    register SDP_RegionQueue *srq = g_new(SDP_RegionQueue, 1);
+    register SDP_Region *region;
+    register gint i;
+    srq->ref_count = 1;
+    srq->sdp_pair = sdp_pair;
+    srq->region_list = g_new(SDP_Region*, region_list->len);
+    srq->region_total = 0;
+    for(i = 0; i < region_list->len; i++){
+        region = region_list->pdata[i];
+        if(!region->is_calculated)
+            srq->region_list[srq->region_total++] = region;
+        }
+    srq->next_region = 0;
+    srq->running_count = 0;
+    srq->is_forward = is_forward;
+    pthread_mutex_init(&srq->region_lock, NULL);
+    pthread_cond_init(&srq->region_cond, NULL);
+    return srq;
+    }
+
+static void SDP_RegionQueue_destroy(SDP_RegionQueue *srq){
+    register gint ref_count;
+    pthread_mutex_lock(&srq->region_lock);
+    ref_count = --srq->ref_count;
+    pthread_mutex_unlock(&srq->region_lock);
+    if(ref_count)
+        return;
+    pthread_mutex_destroy(&srq->region_lock);
+    pthread_cond_destroy(&srq->region_cond);
+    g_free(srq->region_list);
+    g_free(srq);
+    return;
+    }
+
+static SDP_Region *SDP_RegionQueue_next(SDP_RegionQueue *srq){
+    register SDP_Region *region = NULL;
+    pthread_mutex_lock(&srq->region_lock);
+    if(srq->next_region < srq->region_total)
+        region = srq->region_list[srq->next_region++];
+    pthread_mutex_unlock(&srq->region_lock);
+    return region;
+    }
+/* Returns the next region to calculate, or NULL */
+
+static gboolean SDP_RegionQueue_join(SDP_RegionQueue *srq){
+    register gboolean has_regions = FALSE;
+    pthread_mutex_lock(&srq->region_lock);
+    if(srq->next_region < srq->region_total){
+        srq->running_count++;
+        has_regions = TRUE;
+        }
+    pthread_mutex_unlock(&srq->region_lock);
+    return has_regions;
+    }
+
+static void SDP_RegionQueue_leave(SDP_RegionQueue *srq){
+    pthread_mutex_lock(&srq->region_lock);
+    if(!--srq->running_count)
+        pthread_cond_signal(&srq->region_cond);
+    pthread_mutex_unlock(&srq->region_lock);
+    return;
+    }
+/* A job only uses the sdp_pair between joining and leaving,
+ * so the caller waits for it until its user_data is destroyed.
+ */
+
+static void SDP_RegionQueue_job(gpointer data){
+    register SDP_RegionQueue *srq = data;
+    register SDP_Pair *sdp_pair = srq->sdp_pair;
+    register SDP_Region *region;
+    register gpointer user_data;
+    if(SDP_RegionQueue_join(srq)){
+        user_data = sdp_pair->create_data_func(sdp_pair->data_func_data);
+        while((region = SDP_RegionQueue_next(srq)))
+            SDP_Region_calculate(region, sdp_pair, srq->is_forward,
+                                 user_data);
+        sdp_pair->destroy_data_func(user_data, sdp_pair->data_func_data);
+        SDP_RegionQueue_leave(srq);
+        }
+    SDP_RegionQueue_destroy(srq);
+    return;
+    }
+
+static void SDP_Pair_calculate_regions(SDP_Pair *sdp_pair,
+                                       GPtrArray *region_list,
+                                       gboolean is_forward){
+    register SDP_RegionQueue *srq = SDP_RegionQueue_create(sdp_pair,
+                                                  region_list, is_forward);
+    register SDP_Region *region;
+    register gint i, job_total = 0;
+    if(sdp_pair->sdp->job_queue)
+        job_total = MIN(MIN(sdp_pair->sdp->sas->thread_count,
+                            sdp_pair->sdp->job_queue->thread_total),
+                        srq->region_total) - 1;
+    srq->ref_count += MAX(job_total, 0);
+    for(i = 0; i < job_total; i++) /* Run ahead of other comparisons */
+        JobQueue_submit(sdp_pair->sdp->job_queue, SDP_RegionQueue_job,
+                        srq, G_MININT);
+    /* The calling thread uses the original user_data */
+    while((region = SDP_RegionQueue_next(srq)))
+        SDP_Region_calculate(region, sdp_pair, is_forward,
+                             sdp_pair->user_data);
+    /* Only wait for jobs which have already started */
+    pthread_mutex_lock(&srq->region_lock);
+    while(srq->running_count)
+        pthread_cond_wait(&srq->region_cond, &srq->region_lock);
+    pthread_mutex_unlock(&srq->region_lock);
+    SDP_RegionQueue_destroy(srq);
+    return;
+    }
+/* Extra jobs are run on the JobQueue threads (at most --seedthreads
+ * at once for each comparison), so no threads are created here,
+ * and the calling thread never waits for a job which has not started.
+ */
+
+static int SDP_compare_seed_gap(const void *a, const void *b){
+    register gint *gap_a = (gint*)a,
+                  *gap_b = (gint*)b;
+    return gap_b[1] - gap_a[1];
+    }
+
+static int SDP_compare_seed_gap_pos(const void *a, const void *b){
+    register gint *gap_a = (gint*)a,
+                  *gap_b = (gint*)b;
+    return gap_a[0] - gap_b[0];
+    }
+
+static GPtrArray *SDP_Pair_split_regions(SDP_Pair *sdp_pair){
+    register gint i, gap, gap_count = 0, first_seed = 0;
+    register gint max_split = (sdp_pair->sdp->sas->thread_count << 2) - 1;
+    register gint max_advance = sdp_pair->sdp->model->max_target_advance;
+    register gint *gap_list = g_new(gint, sdp_pair->seed_list->len << 1);
+    register SDP_Seed *seed, *prev_seed = NULL;
+    register GPtrArray *region_list = g_ptr_array_new();
+    /* Find gaps between seeds which a region could end within */
     for(i = 0; i < sdp_pair->seed_list->len; i++){
         seed = sdp_pair->seed_list->pdata[i];
-        seed->max_start->score = C4_IMPOSSIBLY_LOW_SCORE;
-        if(!sdp_pair->sdp->use_boundary){
-            g_assert(seed->max_start->cell);
-            STraceback_Cell_destroy(seed->max_start->cell,
-                                    sdp_pair->rev_straceback);
-            seed->max_start->cell = NULL;
+        if(prev_seed){
+            gap = HSP_target_cobs(seed->hsp)
+                - HSP_target_cobs(prev_seed->hsp);
+            if(gap > max_advance){
+                gap_list[gap_count << 1] = i;
+                gap_list[(gap_count << 1) + 1] = gap;
+                gap_count++;
+                }
             }
+        prev_seed = seed;
+        }
+    /* Keep the widest gaps */
+    if(gap_count > max_split){
+        qsort(gap_list, gap_count, sizeof(gint) << 1,
+              SDP_compare_seed_gap);
+        gap_count = max_split;
+        qsort(gap_list, gap_count, sizeof(gint) << 1,
+              SDP_compare_seed_gap_pos);
+        }
+    for(i = 0; i < gap_count; i++){
+        g_ptr_array_add(region_list,
+                        SDP_Region_create(first_seed, gap_list[i << 1]-1));
+        first_seed = gap_list[i << 1];
         }
-    return SDP_Pair_find_start_points(sdp_pair);
+    g_ptr_array_add(region_list,
+        SDP_Region_create(first_seed, sdp_pair->seed_list->len-1));
+    g_free(gap_list);
+    return region_list;
     }
 
-static void SDP_Pair_update_ends(SDP_Pair *sdp_pair){
+static void SDP_Pair_find_region_points(SDP_Pair *sdp_pair,
+                                        GPtrArray *region_list){
+    register gint i;
+    register SDP_Region *region;
+    /* Regions read the subopt concurrently */
+    RangeTree_insert_recent(sdp_pair->subopt->range_tree);
+    /* Find start points */
+    do {
+        SDP_Pair_calculate_regions(sdp_pair, region_list, FALSE);
+    } while(SDP_Pair_merge_regions(sdp_pair, region_list, FALSE));
+    g_assert(!sdp_pair->boundary);
+    if(sdp_pair->sdp->use_boundary)
+        sdp_pair->boundary = Boundary_create();
+    for(i = 0; i < region_list->len; i++){
+        region = region_list->pdata[i];
+        if(sdp_pair->boundary && region->boundary->row_list->len)
+            Boundary_insert(sdp_pair->boundary, region->boundary);
+        STraceback_merge(sdp_pair->rev_straceback, region->straceback);
+        STraceback_destroy(region->straceback);
+        region->straceback = NULL;
+        region->is_calculated = FALSE;
+        }
+    /* Regions without a boundary have no end points to find */
+    if(sdp_pair->sdp->use_boundary)
+        for(i = region_list->len-1; i >= 0; i--){
+            region = region_list->pdata[i];
+            if(!region->boundary->row_list->len){
+                SDP_Region_destroy(region);
+                g_ptr_array_remove_index(region_list, i);
+                }
+            }
+    /* Find end points */
+    if(region_list->len){
+        do {
+            SDP_Pair_calculate_regions(sdp_pair, region_list, TRUE);
+        } while(SDP_Pair_merge_regions(sdp_pair, region_list, TRUE));
+        }
+    for(i = 0; i < region_list->len; i++){
+        region = region_list->pdata[i];
+        STraceback_merge(sdp_pair->fwd_straceback, region->straceback);
+        }
+    return;
+    }
+/* Each pass is calculated for the regions independently,
+ * then the region stracebacks are merged into those of the sdp_pair,
+ * and the region boundaries are combined in target order.
+ * Regions from the reverse pass cover disjoint rows,
+ * so they are reused for the forward pass.
+ */
+#endif /* USE_PTHREADS */
+
+static void SDP_Pair_find_points(SDP_Pair *sdp_pair){
+#ifdef USE_PTHREADS
+    register gint i;
+    register GPtrArray *region_list;
+    if((sdp_pair->sdp->sas->thread_count > 1)
+    && sdp_pair->sdp->job_queue
+    && sdp_pair->create_data_func){
+        region_list = SDP_Pair_split_regions(sdp_pair);
+        if(region_list->len > 1){
+            SDP_Pair_find_region_points(sdp_pair, region_list);
+            for(i = 0; i < region_list->len; i++)
+                SDP_Region_destroy(region_list->pdata[i]);
+            g_ptr_array_free(region_list, TRUE);
+            return;
+            }
+        SDP_Region_destroy(region_list->pdata[0]);
+        g_ptr_array_free(region_list, TRUE);
+        }
+#endif /* USE_PTHREADS */
+    g_assert(!sdp_pair->boundary);
+    sdp_pair->boundary = SDP_Pair_find_start_points(sdp_pair);
+    /* Boundary_print_gnuplot(sdp_pair->boundary, 1); */
+    SDP_Pair_find_end_points(sdp_pair);
+    return;
+    }
+
+/**/
+
+static void SDP_Pair_reset_points(SDP_Pair *sdp_pair){
     register gint i;
     register SDP_Seed *seed;
     g_assert(sdp_pair->seed_list->len);
-    /* Set max end scores low */
+    /* Set max start and end scores low */
     for(i = 0; i < sdp_pair->seed_list->len; i++){
         seed = sdp_pair->seed_list->pdata[i];
+        seed->max_start->score = C4_IMPOSSIBLY_LOW_SCORE;
+        if(!sdp_pair->sdp->use_boundary){
+            g_assert(seed->max_start->cell);
+            STraceback_Cell_destroy(seed->max_start->cell,
+                                    sdp_pair->rev_straceback);
+            seed->max_start->cell = NULL;
+            }
         seed->max_end->score = C4_IMPOSSIBLY_LOW_SCORE;
         if(seed->max_end->cell){
             STraceback_Cell_destroy(seed->max_end->cell,
@@ -631,7 +1064,10 @@ static void SDP_Pair_update_ends(SDP_Pair *sdp_pair){
             seed->max_end->cell = NULL;
             }
         }
-    SDP_Pair_find_end_points(sdp_pair);
+    if(sdp_pair->boundary){
+        Boundary_destroy(sdp_pair->boundary);
+        sdp_pair->boundary = NULL;
+        }
     return;
     }
 
@@ -747,16 +1183,11 @@ Alignment *SDP_Pair_next_path(SDP_Pair *sdp_pair, C4_Score threshold){
     /* Make the start and end points up to date */
     if(sdp_pair->alignment_count){
         if(!sdp_pair->sdp->sas->single_pass_subopt){ /* multipass */
-            if(sdp_pair->boundary)
-                Boundary_destroy(sdp_pair->boundary);
-            sdp_pair->boundary = SDP_Pair_update_starts(sdp_pair);
-            SDP_Pair_update_ends(sdp_pair);
+            SDP_Pair_reset_points(sdp_pair);
+            SDP_Pair_find_points(sdp_pair);
             }
     } else {
-        g_assert(!sdp_pair->boundary);
-        sdp_pair->boundary = SDP_Pair_find_start_points(sdp_pair);
-        /* Boundary_print_gnuplot(sdp_pair->boundary, 1); */
-        SDP_Pair_find_end_points(sdp_pair);
+        SDP_Pair_find_points(sdp_pair);
         if(sdp_pair->sdp->sas->single_pass_subopt){
             sdp_pair->seed_list_by_score = g_new(gpointer,
                                                  sdp_pair->seed_list->len);
@@ -35,11 +35,18 @@ extern "C" {
 #include "scheduler.h"
 #include "threadref.h"
 
+#ifdef USE_PTHREADS
+#include "jobqueue.h"
+#endif /* USE_PTHREADS */
+
 /**/
 
 typedef struct {
         gint dropoff;
     gboolean single_pass_subopt;
+#ifdef USE_PTHREADS
+        gint thread_count;
+#endif /* USE_PTHREADS */
 } SDP_ArgumentSet;
 
 SDP_ArgumentSet *SDP_ArgumentSet_create(Argument *arg);
@@ -73,33 +80,59 @@ typedef struct {
            gboolean  use_boundary;
           Scheduler *find_starts_scheduler;
           Scheduler *find_ends_scheduler;
+#ifdef USE_PTHREADS
+           JobQueue *job_queue;
+#endif /* USE_PTHREADS */
 } SDP;
 
 SDP *SDP_create(C4_Model *model);
 SDP *SDP_share(SDP *sdp);
 void SDP_destroy(SDP *sdp);
+#ifdef USE_PTHREADS
+void SDP_set_job_queue(SDP *sdp, JobQueue *job_queue);
+/* Independent seed regions are calculated by jobs on job_queue,
+ * so they share its threads with the other comparisons.
+ * Without a job_queue, the regions are calculated in turn.
+ */
+#endif /* USE_PTHREADS */
 GPtrArray *SDP_get_codegen_list(SDP *sdp);
 
 /**/
 
+typedef gpointer (*SDP_Pair_create_data_Func)(gpointer data);
+typedef void (*SDP_Pair_destroy_data_Func)(gpointer user_data,
+                                           gpointer data);
+
 typedef struct {
-              SDP *sdp;
-       Comparison *comparison;
-             gint  alignment_count; /* Number reported so far */
-         gpointer  user_data;
-           SubOpt *subopt;
-        GPtrArray *seed_list;
-         gpointer *seed_list_by_score; /* Sorted in score order */
-             gint  single_pass_pos;
-         Boundary *boundary;
-         C4_Score  last_score;
-       STraceback *fwd_straceback;
-       STraceback *rev_straceback;
+                       SDP *sdp;
+                Comparison *comparison;
+                      gint  alignment_count; /* Number reported so far */
+                  gpointer  user_data;
+ SDP_Pair_create_data_Func  create_data_func;
+SDP_Pair_destroy_data_Func  destroy_data_func;
+                  gpointer  data_func_data;
+                    SubOpt *subopt;
+                 GPtrArray *seed_list;
+                  gpointer *seed_list_by_score; /* Sorted by score */
+                RecycleBin *terminal_recycle;
+                      gint  single_pass_pos;
+                  Boundary *boundary;
+                  C4_Score  last_score;
+                STraceback *fwd_straceback;
+                STraceback *rev_straceback;
 } SDP_Pair;
 
 SDP_Pair *SDP_Pair_create(SDP *sdp, SubOpt *subopt,
                           Comparison *comparison, gpointer user_data);
 void SDP_Pair_destroy(SDP_Pair *sdp_pair);
+void SDP_Pair_set_data_funcs(SDP_Pair *sdp_pair,
+                             SDP_Pair_create_data_Func create_data_func,
+                             SDP_Pair_destroy_data_Func destroy_data_func,
+                             gpointer data_func_data);
+/* The data funcs provide a private copy of user_data for each
+ * extra job used to calculate independent seed regions.
+ * When they are not set, seeds are processed in a single thread.
+ */
 
 /**/
 
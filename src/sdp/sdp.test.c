@@ -14,9 +14,307 @@
 \****************************************************************/
 
 #include "sdp.h"
+#include "match.h"
+
+#ifdef USE_PTHREADS
+typedef struct {
+    Sequence *query;
+    Sequence *target;
+} Test_Data;
+
+static C4_Score test_match_calc_func(gint query_pos, gint target_pos,
+                                     gpointer user_data){
+    register Test_Data *td = user_data;
+    g_assert(query_pos < td->query->len);
+    g_assert(target_pos < td->target->len);
+    return (Sequence_get_symbol(td->query, query_pos)
+         == Sequence_get_symbol(td->target, target_pos)) ? 5 : -4;
+    }
+
+static C4_Score test_gap_open_calc_func(gint query_pos, gint target_pos,
+                                        gpointer user_data){
+    return -12;
+    }
+
+static C4_Score test_gap_extend_calc_func(gint query_pos, gint target_pos,
+                                          gpointer user_data){
+    return -4;
+    }
+
+static C4_Score test_switch_calc_func(gint query_pos, gint target_pos,
+                                      gpointer user_data){
+    return -1;
+    }
+
+static C4_Model *test_model_create(gboolean use_boundary){
+    register C4_Model *model = C4_Model_create("sdp.test");
+    register C4_State *match_state, *insert_state, *delete_state,
+                      *other_state;
+    register C4_Calc *match_calc, *gap_open_calc, *gap_extend_calc,
+                     *switch_calc;
+    match_state = C4_Model_add_state(model, "match");
+    insert_state = C4_Model_add_state(model, "insert");
+    delete_state = C4_Model_add_state(model, "delete");
+    match_calc = C4_Model_add_calc(model, "match", 5,
+        test_match_calc_func, "test_match_calc_func(%QP, %TP, user_data)",
+        NULL, NULL, NULL, NULL,
+        C4_Protect_NONE);
+    gap_open_calc = C4_Model_add_calc(model, "gap open", -12,
+        test_gap_open_calc_func, "-12", NULL, NULL, NULL, NULL,
+        C4_Protect_NONE);
+    gap_extend_calc = C4_Model_add_calc(model, "gap extend", -4,
+        test_gap_extend_calc_func, "-4", NULL, NULL, NULL, NULL,
+        C4_Protect_NONE);
+    C4_Model_add_transition(model, "start to match",
+                 NULL, match_state, 0, 0, NULL, C4_Label_NONE, NULL);
+    C4_Model_add_transition(model, "match to end",
+                 match_state, NULL, 0, 0, NULL, C4_Label_NONE, NULL);
+    C4_Model_add_transition(model, "match", match_state, match_state,
+                 1, 1, match_calc, C4_Label_MATCH, NULL);
+    C4_Model_add_transition(model, "match to insert",
+                 match_state, insert_state, 1, 0,
+                 gap_open_calc, C4_Label_GAP, NULL);
+    C4_Model_add_transition(model, "insert", insert_state, insert_state,
+                 1, 0, gap_extend_calc, C4_Label_GAP, NULL);
+    C4_Model_add_transition(model, "insert to match",
+                 insert_state, match_state, 0, 0,
+                 NULL, C4_Label_NONE, NULL);
+    C4_Model_add_transition(model, "match to delete",
+                 match_state, delete_state, 0, 1,
+                 gap_open_calc, C4_Label_GAP, NULL);
+    C4_Model_add_transition(model, "delete", delete_state, delete_state,
+                 0, 1, gap_extend_calc, C4_Label_GAP, NULL);
+    C4_Model_add_transition(model, "delete to match",
+                 delete_state, match_state, 0, 0,
+                 NULL, C4_Label_NONE, NULL);
+    if(use_boundary){ /* A second match state needs a boundary */
+        other_state = C4_Model_add_state(model, "other match");
+        switch_calc = C4_Model_add_calc(model, "switch", -1,
+            test_switch_calc_func, "-1", NULL, NULL, NULL, NULL,
+            C4_Protect_NONE);
+        C4_Model_add_transition(model, "start to other",
+                     NULL, other_state, 0, 0, NULL, C4_Label_NONE, NULL);
+        C4_Model_add_transition(model, "other match",
+                     other_state, other_state, 1, 1,
+                     match_calc, C4_Label_MATCH, NULL);
+        C4_Model_add_transition(model, "other to match",
+                     other_state, match_state, 0, 0,
+                     switch_calc, C4_Label_NONE, NULL);
+        }
+    C4_Model_add_portal(model, "match portal", match_calc, 1, 1);
+    C4_Model_configure_start_state(model, C4_Scope_ANYWHERE, NULL, NULL);
+    C4_Model_configure_end_state(model, C4_Scope_ANYWHERE, NULL, NULL);
+    C4_Model_close(model);
+    return model;
+    }
+/* A local affine DNA model.
+ * With use_boundary, the match portal has two transitions,
+ * so SDP uses a boundary between its reverse and forward passes.
+ */
+
+static gpointer test_create_data(gpointer data){
+    register Test_Data *td = data, *copy = g_new(Test_Data, 1);
+    copy->query = Sequence_share(td->query);
+    copy->target = Sequence_share(td->target);
+    return copy;
+    }
+
+static void test_destroy_data(gpointer user_data, gpointer data){
+    register Test_Data *td = user_data;
+    Sequence_destroy(td->query);
+    Sequence_destroy(td->target);
+    g_free(td);
+    return;
+    }
+
+static void test_random_seq(gchar *seq, gint len, guint32 *seed){
+    register gint i;
+    for(i = 0; i < len; i++){
+        (*seed) = (*seed)*1103515245+12345;
+        seq[i] = "ACGT"[((*seed)>>16)&3];
+        }
+    seq[len] = '\0';
+    return;
+    }
+
+typedef struct {
+    gint query_start;
+    gint target_start;
+    gint length;
+} Test_Block;
+
+static GPtrArray *test_find_alignments(C4_Model *model,
+                                       Comparison *comparison,
+                                       JobQueue *job_queue,
+                                       gint thread_count,
+                                       gboolean single_pass){
+    register SDP_ArgumentSet *sas = SDP_ArgumentSet_create(NULL);
+    register SDP *sdp = SDP_create(model);
+    register SubOpt *subopt = SubOpt_create(comparison->query->len,
+                                            comparison->target->len);
+    register SDP_Pair *sdp_pair;
+    register Alignment *alignment;
+    register GPtrArray *alignment_list = g_ptr_array_new();
+    Test_Data td;
+    td.query = comparison->query;
+    td.target = comparison->target;
+    sas->thread_count = thread_count;
+    sas->single_pass_subopt = single_pass;
+    SDP_set_job_queue(sdp, job_queue);
+    sdp_pair = SDP_Pair_create(sdp, subopt, comparison, &td);
+    SDP_Pair_set_data_funcs(sdp_pair, test_create_data,
+                            test_destroy_data, &td);
+    while((alignment = SDP_Pair_next_path(sdp_pair, 20))){
+        SubOpt_add_alignment(subopt, alignment);
+        g_ptr_array_add(alignment_list, alignment);
+        }
+    SDP_Pair_destroy(sdp_pair);
+    SubOpt_destroy(subopt);
+    SDP_destroy(sdp);
+    sas->thread_count = 1;
+    sas->single_pass_subopt = TRUE;
+    return alignment_list;
+    }
+
+static void test_compare_alignments(GPtrArray *serial_list,
+                                    GPtrArray *region_list){
+    register gint i, j;
+    register Alignment *serial, *region;
+    register AlignmentOperation *serial_op, *region_op;
+    g_assert(serial_list->len == region_list->len);
+    for(i = 0; i < serial_list->len; i++){
+        serial = serial_list->pdata[i];
+        region = region_list->pdata[i];
+        g_assert(serial->score == region->score);
+        g_assert(serial->region->query_start
+              == region->region->query_start);
+        g_assert(serial->region->target_start
+              == region->region->target_start);
+        g_assert(serial->region->query_length
+              == region->region->query_length);
+        g_assert(serial->region->target_length
+              == region->region->target_length);
+        g_assert(serial->operation_list->len
+              == region->operation_list->len);
+        for(j = 0; j < serial->operation_list->len; j++){
+            serial_op = serial->operation_list->pdata[j];
+            region_op = region->operation_list->pdata[j];
+            g_assert(serial_op->transition == region_op->transition);
+            g_assert(serial_op->length == region_op->length);
+            }
+        }
+    return;
+    }
+
+static void test_alignment_list_destroy(GPtrArray *alignment_list){
+    register gint i;
+    for(i = 0; i < alignment_list->len; i++)
+        Alignment_destroy(alignment_list->pdata[i]);
+    g_ptr_array_free(alignment_list, TRUE);
+    return;
+    }
+
+static void test_regions(Comparison_Param *comparison_param,
+                         JobQueue *job_queue, gboolean use_boundary,
+                         gboolean single_pass,
+                         Test_Block *block, gint block_total,
+                         gint query_len, gint target_len){
+    register Alphabet *alphabet = Alphabet_create(Alphabet_Type_DNA,
+                                                  FALSE);
+    register gchar *query_seq = g_new(gchar, query_len+1),
+                   *target_seq = g_new(gchar, target_len+1);
+    register Sequence *query, *target;
+    register Comparison *comparison;
+    register C4_Model *model = test_model_create(use_boundary);
+    register GPtrArray *serial_list, *region_list;
+    register gint i, thread_count;
+    guint32 seed = 17;
+    test_random_seq(query_seq, query_len, &seed);
+    test_random_seq(target_seq, target_len, &seed);
+    for(i = 0; i < block_total; i++)
+        strncpy(target_seq+block[i].target_start,
+                query_seq+block[i].query_start, block[i].length);
+    query = Sequence_create("qy", NULL, query_seq, 0,
+                            Sequence_Strand_FORWARD, alphabet);
+    target = Sequence_create("tg", NULL, target_seq, 0,
+                             Sequence_Strand_FORWARD, alphabet);
+    comparison = Comparison_create(comparison_param, query, target);
+    for(i = 0; i < block_total; i++)
+        HSPset_add_known_hsp(comparison->dna_hspset,
+                             block[i].query_start, block[i].target_start,
+                             block[i].length);
+    Comparison_finalise(comparison);
+    serial_list = test_find_alignments(model, comparison, NULL, 1,
+                                       single_pass);
+    g_assert(serial_list->len);
+    for(thread_count = 2; thread_count <= 4; thread_count++){
+        region_list = test_find_alignments(model, comparison, job_queue,
+                                           thread_count, single_pass);
+        test_compare_alignments(serial_list, region_list);
+        test_alignment_list_destroy(region_list);
+        }
+    test_alignment_list_destroy(serial_list);
+    Comparison_destroy(comparison);
+    C4_Model_destroy(model);
+    Sequence_destroy(query);
+    Sequence_destroy(target);
+    Alphabet_destroy(alphabet);
+    g_free(query_seq);
+    g_free(target_seq);
+    return;
+    }
+/* The alignments found with independent seed regions
+ * calculated by several jobs must match those from a single pass.
+ */
+
+static void test_region_cases(Comparison_Param *comparison_param,
+                              JobQueue *job_queue, gboolean use_boundary){
+    Test_Block independent[] = {
+        {  0,  200, 80},
+        {100, 1500, 80},
+        {200, 2800, 80}},
+               overlapping[] = {
+        {  0,  200, 80},
+        { 90,  300, 80}, /* Joined to the first with a gap */
+        {200, 1500, 80},
+        {290, 1600, 80}};
+    test_regions(comparison_param, job_queue, use_boundary, TRUE,
+                 independent, 3, 400, 3200);
+    test_regions(comparison_param, job_queue, use_boundary, TRUE,
+                 overlapping, 4, 400, 3200);
+    if(use_boundary) /* Later passes are blocked by earlier alignments */
+        test_regions(comparison_param, job_queue, use_boundary, FALSE,
+                     independent, 3, 400, 3200);
+    return;
+    }
+
+#endif /* USE_PTHREADS */
 
 int Argument_main(Argument *arg){
-    g_warning("[%s] does nothing", __FILE__);
+#ifdef USE_PTHREADS
+    register Match *match;
+    register HSP_Param *dna_hsp_param;
+    register Comparison_Param *comparison_param;
+    register JobQueue *job_queue;
+    Match_ArgumentSet_create(arg);
+    HSPset_ArgumentSet_create(arg);
+    SDP_ArgumentSet_create(arg);
+    Argument_process(arg, "sdp.test", NULL, NULL);
+    match = Match_find(Match_Type_DNA2DNA);
+    dna_hsp_param = HSP_Param_create(match, FALSE);
+    comparison_param = Comparison_Param_create(Alphabet_Type_DNA,
+                                               Alphabet_Type_DNA,
+                                               dna_hsp_param, NULL, NULL);
+    job_queue = JobQueue_create(3);
+    test_region_cases(comparison_param, job_queue, FALSE);
+    test_region_cases(comparison_param, job_queue, TRUE);
+    JobQueue_complete(job_queue);
+    JobQueue_destroy(job_queue);
+    HSP_Param_destroy(dna_hsp_param);
+    Comparison_Param_destroy(comparison_param);
+#else /* USE_PTHREADS */
+    g_warning("[%s] needs USE_PTHREADS", __FILE__);
+#endif /* USE_PTHREADS */
     return 0;
     }
 
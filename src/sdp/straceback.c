@@ -41,6 +41,16 @@ void STraceback_destroy(STraceback *straceback){
     return;
     }
 
+void STraceback_merge(STraceback *straceback, STraceback *src){
+    g_assert(straceback->is_forward == src->is_forward);
+    g_assert(straceback->model == src->model);
+    RecycleBin_merge(straceback->cell_recycle, src->cell_recycle);
+    return;
+    }
+/* Takes ownership of the cells allocated by src,
+ * so they can later be released against straceback.
+ */
+
 STraceback_Cell *STraceback_add(STraceback *straceback,
                                 C4_Transition *transition, gint length,
                                 STraceback_Cell *prev){
@@ -45,6 +45,8 @@ typedef struct {
      STraceback *STraceback_create(C4_Model *model, gboolean is_forward);
      STraceback *STraceback_share(STraceback *straceback);
            void  STraceback_destroy(STraceback *straceback);
+           void  STraceback_merge(STraceback *straceback,
+                                  STraceback *src);
 STraceback_Cell *STraceback_add(STraceback *straceback,
                                 C4_Transition *transition, gint length,
                                 STraceback_Cell *prev);
@@ -259,6 +259,11 @@ static gint Sequence_Subseq_get_symbol(gpointer data, gint pos){
     return Sequence_get_symbol(subseq->sequence, subseq->start+pos);
     }
 
+static gint Sequence_Subseq_IntMemory_get_symbol(gpointer data, gint pos){
+    register Sequence_Subseq *subseq = data;
+    return ((gchar*)subseq->sequence->data)[subseq->start+pos];
+    }
+
 Sequence *Sequence_subseq(Sequence *s, guint start, guint length){
     register Sequence *ns;
     register Sequence_Subseq *subseq;
@@ -276,7 +281,9 @@ Sequence *Sequence_subseq(Sequence *s, guint start, guint length){
     subseq->sequence = Sequence_share(s);
     subseq->start = start;
     ns->type = Sequence_Type_SUBSEQ;
-    ns->get_symbol = Sequence_Subseq_get_symbol;
+    ns->get_symbol = (s->type == Sequence_Type_INTMEM)
+                   ? Sequence_Subseq_IntMemory_get_symbol
+                   : Sequence_Subseq_get_symbol;
     ns->data = subseq;
     ns->len = length;
     return ns;
@@ -354,6 +361,12 @@ static gint Sequence_revcomp_get_symbol(gpointer data, gint pos){
     return sequence->alphabet->complement[ch];
     }
 
+static gint Sequence_revcomp_IntMemory_get_symbol(gpointer data, gint pos){
+    register Sequence *sequence = data;
+    register guchar ch = ((gchar*)sequence->data)[sequence->len-pos-1];
+    return sequence->alphabet->complement[ch];
+    }
+
 Sequence_Strand Sequence_Strand_revcomp(Sequence_Strand strand){
     g_assert((strand == Sequence_Strand_FORWARD)
            ||(strand == Sequence_Strand_REVCOMP));
@@ -410,7 +423,9 @@ Sequence *Sequence_revcomp(Sequence *s){
         }
     ns->data = Sequence_share(s);
     ns->type = Sequence_Type_REVCOMP;
-    ns->get_symbol = Sequence_revcomp_get_symbol;
+    ns->get_symbol = (s->type == Sequence_Type_INTMEM)
+                   ? Sequence_revcomp_IntMemory_get_symbol
+                   : Sequence_revcomp_get_symbol;
     return ns;
     }
 
@@ -450,6 +465,12 @@ static gint Sequence_Filter_get_symbol(gpointer data, gint pos){
           [Sequence_get_symbol(sequence_filter->sequence, pos)];
     }
 
+static gint Sequence_Filter_IntMemory_get_symbol(gpointer data, gint pos){
+    register Sequence_Filter *sequence_filter = data;
+    return sequence_filter->filter
+          [((guchar*)sequence_filter->sequence->data)[pos]];
+    }
+
 Sequence *Sequence_filter(Sequence *s,
                           Alphabet_Filter_Type filter_type){
     register Sequence *ns = Sequence_create(s->id, s->def, NULL,
@@ -461,7 +482,9 @@ Sequence *Sequence_filter(Sequence *s,
                   Alphabet_Filter_Type_get_name(filter_type));
     ns->data = sequence_filter;
     ns->type = Sequence_Type_FILTER;
-    ns->get_symbol = Sequence_Filter_get_symbol;
+    ns->get_symbol = (s->type == Sequence_Type_INTMEM)
+                   ? Sequence_Filter_IntMemory_get_symbol
+                   : Sequence_Filter_get_symbol;
     sequence_filter->sequence = Sequence_share(s);
     sequence_filter->filter = Alphabet_get_filter_by_type(s->alphabet,
                                                           filter_type);
@@ -494,7 +517,12 @@ typedef struct {
     Sequence *sequence;
         gint  frame;
    Translate *translate;
+       gchar *codon_profile; /* From sequence, or NULL */
 } Sequence_Translation;
+/* codon_profile is taken under seq_lock when the translation is made,
+ * so it can be read without the lock while another thread
+ * sets the profile of the sequence.
+ */
 
 static void Sequence_Translation_data_destroy(gpointer data){
     register Sequence_Translation *translation = data;
@@ -513,6 +541,13 @@ static gint Sequence_translate_get_symbol(gpointer data, gint pos){
                      Sequence_get_symbol(translation->sequence, p+2));
     }
 
+static gint Sequence_translate_IntMemory_get_symbol(gpointer data, gint pos){
+    register Sequence_Translation *translation = data;
+    register gchar *seq = ((gchar*)translation->sequence->data)
+                        + (pos*3)+(translation->frame-1);
+    return Translate_base(translation->translate, seq[0], seq[1], seq[2]);
+    }
+
 Sequence *Sequence_translate(Sequence *s, Translate *translate, gint frame){
     register Alphabet *protein_alphabet
            = Alphabet_create(Alphabet_Type_PROTEIN, FALSE);
@@ -531,10 +566,20 @@ Sequence *Sequence_translate(Sequence *s, Translate *translate, gint frame){
     translation->sequence = Sequence_share(s);
     translation->frame = frame;
     translation->translate = Translate_share(translate);
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&s->seq_lock);
+#endif /* USE_PTHREADS */
+    translation->codon_profile = (s->codon_translate == translate)
+                               ? s->codon_profile : NULL;
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&s->seq_lock);
+#endif /* USE_PTHREADS */
     ts->len = (s->len-(frame-1))/3;
     ts->data = translation;
     ts->type = Sequence_Type_TRANSLATE;
-    ts->get_symbol = Sequence_translate_get_symbol;
+    ts->get_symbol = (s->type == Sequence_Type_INTMEM)
+                   ? Sequence_translate_IntMemory_get_symbol
+                   : Sequence_translate_get_symbol;
     Alphabet_destroy(protein_alphabet);
     return ts;
     }
@@ -585,11 +630,32 @@ static void Sequence_print_type(Sequence *s){
 #endif /* 0 */
 
 
+static void Sequence_strncpy_translate(Sequence_Translation *translation,
+                                       gint start, gint length, gchar *dst){
+    register gint i, p = (start*3)+(translation->frame-1);
+    register Sequence *sequence = translation->sequence;
+    register gchar *codon_buf, *codon;
+    if(translation->codon_profile){
+        for(i = 0; i < length; i++)
+            dst[i] = translation->codon_profile[p+(i*3)];
+        return;
+        }
+    codon_buf = g_new(gchar, length*3);
+    Sequence_strncpy(sequence, p, length*3, codon_buf);
+    for(i = 0, codon = codon_buf; i < length; i++, codon += 3)
+        dst[i] = Translate_base(translation->translate,
+                                codon[0], codon[1], codon[2]);
+    g_free(codon_buf);
+    return;
+    }
+
 void Sequence_strncpy(Sequence *s, gint start, gint length, gchar *dst){
     register gint i;
     register gchar *str;
     register Sequence_Subseq *subseq;
     register SparseCache *cache;
+    register Sequence *sequence;
+    register Sequence_Filter *sequence_filter;
     g_assert(start >= 0);
     g_assert(s->len > 0);
     g_assert(start < s->len);
@@ -600,6 +666,8 @@ void Sequence_strncpy(Sequence *s, gint start, gint length, gchar *dst){
     Sequence_print_type(s);
     g_print("] [%d] [%d] [%s]\n", start, length, s->id);
 #endif /* 0 */
+    if(!length)
+        return;
     switch(s->type){
         case Sequence_Type_INTMEM:
             str = s->data;
@@ -614,6 +682,23 @@ void Sequence_strncpy(Sequence *s, gint start, gint length, gchar *dst){
             subseq = s->data;
             Sequence_strncpy(subseq->sequence, start+subseq->start, length, dst);
             return;
+        case Sequence_Type_REVCOMP:
+            sequence = s->data;
+            Sequence_strncpy(sequence, sequence->len-start-length,
+                             length, dst);
+            Sequence_reverse_in_place(dst, length);
+            for(i = 0; i < length; i++)
+                dst[i] = sequence->alphabet->complement[(guchar)dst[i]];
+            return;
+        case Sequence_Type_FILTER:
+            sequence_filter = s->data;
+            Sequence_strncpy(sequence_filter->sequence, start, length, dst);
+            for(i = 0; i < length; i++)
+                dst[i] = sequence_filter->filter[(guchar)dst[i]];
+            return;
+        case Sequence_Type_TRANSLATE:
+            Sequence_strncpy_translate(s->data, start, length, dst);
+            return;
         default:
             for(i = 0; i < length; i++)
                 dst[i] = Sequence_get_symbol(s, start+i);
@@ -621,11 +706,9 @@ void Sequence_strncpy(Sequence *s, gint start, gint length, gchar *dst){
         }
     return;
     }
-/* FIXME: optimisation : implement fast versions
- *                       for specific sequence types
- *                       target types:
- *                           subseq:extmem
- *                           intmem
+/* Each sequence type copies the window of the sequence it wraps
+ * in one call, then transforms the whole window,
+ * rather than making nested get_symbol calls for every position.
  */
 
 void Sequence_strcpy(Sequence *s, gchar *dst){
@@ -692,6 +775,8 @@ void Sequence_destroy(Sequence *s){
                 break;
             }
         }
+    if(s->codon_profile)
+        g_free(s->codon_profile);
     Alphabet_destroy(s->alphabet);
 #ifdef USE_PTHREADS
     pthread_mutex_destroy(&s->seq_lock);
@@ -798,10 +883,71 @@ gsize Sequence_memory_usage(Sequence *s){
          + sizeof(gchar)*strlen(s->id)
          + sizeof(gchar)*(s->def?strlen(s->def):0)
          + sizeof(Alphabet)
+         + (s->codon_profile?(sizeof(gchar)*s->len):0)
          + data_memory;
     }
 
 
+static gboolean Sequence_is_extmem(Sequence *s){
+    register Sequence_Subseq *subseq;
+    register Sequence_Filter *filter;
+    register Sequence_Translation *translation;
+    switch(s->type){
+        case Sequence_Type_INTMEM:
+            return FALSE;
+        case Sequence_Type_EXTMEM:
+            return TRUE;
+        case Sequence_Type_SUBSEQ:
+            subseq = s->data;
+            return Sequence_is_extmem(subseq->sequence);
+        case Sequence_Type_REVCOMP:
+            return Sequence_is_extmem((Sequence*)s->data);
+        case Sequence_Type_FILTER:
+            filter = s->data;
+            return Sequence_is_extmem(filter->sequence);
+        case Sequence_Type_TRANSLATE:
+            translation = s->data;
+            return Sequence_is_extmem(translation->sequence);
+        default:
+            g_error("Unknown Sequence type [%d]", s->type);
+            break;
+        }
+    return FALSE;
+    }
+
+void Sequence_set_codon_profile(Sequence *s, Translate *translate){
+    register gint i;
+    register gchar *seq, *profile;
+    g_assert(s);
+    g_assert(translate);
+    if((s->len < 3) || (!s->data) || Sequence_is_extmem(s))
+        return;
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&s->seq_lock);
+#endif /* USE_PTHREADS */
+    if(!s->codon_profile){
+        seq = Sequence_get_str(s);
+        profile = g_new0(gchar, s->len);
+        for(i = 2; i < s->len; i++)
+            profile[i-2] = Translate_base(translate,
+                                          seq[i-2], seq[i-1], seq[i]);
+        g_free(seq);
+        s->codon_translate = translate;
+        s->codon_profile = profile;
+        }
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&s->seq_lock);
+#endif /* USE_PTHREADS */
+    return;
+    }
+/* The profile is set once, and shared with any Sequence_share() copies.
+ * It is published under seq_lock, and only used by threads
+ * which have called this since (or were handed the sequence after),
+ * or by translations made after it is set.
+ * Positions closer than a codon to the end are left as NUL,
+ * but these are never scored as a codon.
+ */
+
 void Sequence_lock(Sequence *s){
     register Sequence_Subseq *subseq;
     register Sequence_Filter *filter;
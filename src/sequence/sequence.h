@@ -87,10 +87,14 @@ typedef struct {
                gpointer   data;
           Sequence_Type   type;
                    gint (*get_symbol)(gpointer data, gint pos);
+                  gchar  *codon_profile;
+              Translate  *codon_translate;
 #ifdef USE_PTHREADS
         pthread_mutex_t   seq_lock;
 #endif /* USE_PTHREADS */
 } Sequence;
+/* codon_profile is NULL unless set with Sequence_set_codon_profile()
+ */
 
 #define Sequence_get_symbol(sequence, pos) \
     ((sequence)->get_symbol((sequence)->data, pos))
@@ -141,6 +145,28 @@ Sequence *Sequence_filter(Sequence *s,
 Sequence *Sequence_translate(Sequence *s, Translate *translate, gint frame);
 
 Sequence *Sequence_mask(Sequence *s);
+
+    void  Sequence_set_codon_profile(Sequence *s, Translate *translate);
+/* Precomputes the translation of the codon starting at each position.
+ * This is not done for sequences backed by external memory,
+ * as it would require the whole sequence to be loaded.
+ */
+
+#define Sequence_get_codon_symbol(sequence, translate, pos)       \
+    ((((sequence)->codon_profile)                                 \
+   && ((sequence)->codon_translate == (translate)))               \
+    ? (sequence)->codon_profile[(pos)]                            \
+    : Translate_base((translate),                                 \
+                     Sequence_get_symbol((sequence), (pos)),      \
+                     Sequence_get_symbol((sequence), (pos)+1),    \
+                     Sequence_get_symbol((sequence), (pos)+2)))
+/* Returns the amino acid for the codon at pos..pos+2,
+ * using the codon_profile when available for this translate.
+ * The profile is read without seq_lock, so the caller must have called
+ * Sequence_set_codon_profile() (as Comparison_create() does),
+ * or have been handed the sequence by a thread which did.
+ */
+
 void Sequence_lock(Sequence *s);
 void Sequence_unlock(Sequence *s);
 
@@ -15,6 +15,20 @@
 
 #include "sequence.h"
 
+static void test_strncpy(Sequence *s){
+    register gint i, start, length;
+    register gchar *buf = g_new(gchar, s->len);
+    for(start = 0; start < s->len; start++)
+        for(length = 0; (start+length) <= s->len; length++){
+            Sequence_strncpy(s, start, length, buf);
+            for(i = 0; i < length; i++)
+                g_assert(buf[i] == Sequence_get_symbol(s, start+i));
+            }
+    g_free(buf);
+    return;
+    }
+/* Bulk copies must agree with per-symbol access */
+
 gint Argument_main(Argument *arg){
     register Alphabet *alphabet = Alphabet_create(Alphabet_Type_DNA,
                                                   TRUE);
@@ -22,8 +36,10 @@ gint Argument_main(Argument *arg){
     register Sequence *s = Sequence_create("testseq", NULL, seq, 0,
                                            Sequence_Strand_FORWARD,
                                            alphabet);
-    register Sequence *s2, *s3, *s4;
+    register Sequence *s2, *s3, *s4, *s5, *s6, *s7;
     register gchar *result;
+    register gint i;
+    register gchar expect;
     register Translate *translate = Translate_create(FALSE);
     s2 = Sequence_revcomp(s);
     s3 = Sequence_translate(s2, translate, 1);
@@ -32,11 +48,35 @@ gint Argument_main(Argument *arg){
     result = Sequence_get_str(s4);
     g_message("result [%s]", result);
     g_free(result);
+    s5 = Sequence_subseq(s2, 2, 20);
+    s6 = Sequence_translate(s, translate, 2);
+    test_strncpy(s);
+    test_strncpy(s2);
+    test_strncpy(s3);
+    test_strncpy(s4);
+    test_strncpy(s5);
+    test_strncpy(s6);
+    /* Codon profile must agree with direct translation */
+    Sequence_set_codon_profile(s2, translate);
+    g_assert(s2->codon_profile);
+    for(i = 0; (i+3) <= s2->len; i++){
+        expect = Translate_base(translate,
+                                Sequence_get_symbol(s2, i),
+                                Sequence_get_symbol(s2, i+1),
+                                Sequence_get_symbol(s2, i+2));
+        g_assert(Sequence_get_codon_symbol(s2, translate, i) == expect);
+        }
+    test_strncpy(s3); /* Made before the profile, so does not use it */
+    s7 = Sequence_translate(s2, translate, 2); /* Uses the profile */
+    test_strncpy(s7);
     /**/
     Sequence_destroy(s);
     Sequence_destroy(s2);
     Sequence_destroy(s3);
     Sequence_destroy(s4);
+    Sequence_destroy(s5);
+    Sequence_destroy(s6);
+    Sequence_destroy(s7);
     Alphabet_destroy(alphabet);
     Translate_destroy(translate);
     return 0;
@@ -0,0 +1,145 @@
+/****************************************************************\
+*                                                                *
+*  Library for radix sorting on integer keys                     *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#include <string.h> /* For memcpy() */
+
+#include "radixsort.h"
+
+#define RADIXSORT_DIGIT_BITS 8
+#define RADIXSORT_DIGIT_SIZE (1 << RADIXSORT_DIGIT_BITS)
+#define RADIXSORT_INSERTION_LIMIT 32
+
+typedef struct {
+    guint64 key;
+      gsize pos;
+} RadixSort_Item;
+
+static void RadixSort_insertion_sort(RadixSort_Item *item, gsize total){
+    register gsize i, j;
+    RadixSort_Item curr;
+    for(i = 1; i < total; i++){
+        curr = item[i];
+        for(j = i; (j > 0) && (item[j-1].key > curr.key); j--)
+            item[j] = item[j-1];
+        item[j] = curr;
+        }
+    return;
+    }
+
+static RadixSort_Item *RadixSort_items(RadixSort_Item *item,
+                                       RadixSort_Item *temp, gsize total){
+    register gsize i;
+    register guint64 min_key, max_key;
+    register gint shift, digit;
+    register RadixSort_Item *swap;
+    gsize count[RADIXSORT_DIGIT_SIZE], pos, next;
+    if(total <= RADIXSORT_INSERTION_LIMIT){
+        RadixSort_insertion_sort(item, total);
+        return item;
+        }
+    min_key = max_key = item[0].key;
+    for(i = 1; i < total; i++){
+        if(min_key > item[i].key)
+            min_key = item[i].key;
+        if(max_key < item[i].key)
+            max_key = item[i].key;
+        }
+    for(i = 0; i < total; i++)
+        item[i].key -= min_key;
+    max_key -= min_key;
+    for(shift = 0; (shift < 64) && (max_key >> shift);
+        shift += RADIXSORT_DIGIT_BITS){
+        for(digit = 0; digit < RADIXSORT_DIGIT_SIZE; digit++)
+            count[digit] = 0;
+        for(i = 0; i < total; i++)
+            count[(item[i].key >> shift) & (RADIXSORT_DIGIT_SIZE-1)]++;
+        if(count[(item[0].key >> shift) & (RADIXSORT_DIGIT_SIZE-1)]
+            == total)
+            continue; /* Every key has the same digit */
+        pos = 0;
+        for(digit = 0; digit < RADIXSORT_DIGIT_SIZE; digit++){
+            next = pos + count[digit];
+            count[digit] = pos;
+            pos = next;
+            }
+        for(i = 0; i < total; i++)
+            temp[count[(item[i].key >> shift)
+                      & (RADIXSORT_DIGIT_SIZE-1)]++] = item[i];
+        swap = item;
+        item = temp;
+        temp = swap;
+        }
+    return item;
+    }
+/* LSD radix sort on 8 bit digits, returning whichever
+ * of item or temp holds the sorted list.
+ * Keys are rebased on min_key, which is not restored.
+ */
+
+gsize RadixSort_memory_usage(gsize total, gsize size){
+    if(total < 2)
+        return 0;
+    return (sizeof(RadixSort_Item) * total * 2) + (total * size);
+    }
+
+void RadixSort_sort(gpointer base, gsize total, gsize size,
+                    RadixSort_Key_Func key_func, gpointer user_data){
+    register gsize i;
+    register gchar *data = base, *sorted_data;
+    register RadixSort_Item *item, *temp, *sorted;
+    if(total < 2)
+        return;
+    item = g_new(RadixSort_Item, total);
+    temp = g_new(RadixSort_Item, total);
+    for(i = 0; i < total; i++){
+        item[i].key = key_func(data + (i * size), user_data);
+        item[i].pos = i;
+        }
+    sorted = RadixSort_items(item, temp, total);
+    sorted_data = g_new(gchar, total * size);
+    for(i = 0; i < total; i++)
+        memcpy(sorted_data + (i * size), data + (sorted[i].pos * size), size);
+    memcpy(data, sorted_data, total * size);
+    g_free(sorted_data);
+    g_free(item);
+    g_free(temp);
+    return;
+    }
+
+void RadixSort_sort_pointers(gpointer *list, gsize total,
+                             RadixSort_Key_Func key_func,
+                             gpointer user_data){
+    register gsize i;
+    register gpointer *sorted_list;
+    register RadixSort_Item *item, *temp, *sorted;
+    if(total < 2)
+        return;
+    item = g_new(RadixSort_Item, total);
+    temp = g_new(RadixSort_Item, total);
+    for(i = 0; i < total; i++){
+        item[i].key = key_func(list[i], user_data);
+        item[i].pos = i;
+        }
+    sorted = RadixSort_items(item, temp, total);
+    sorted_list = g_new(gpointer, total);
+    for(i = 0; i < total; i++)
+        sorted_list[i] = list[sorted[i].pos];
+    memcpy(list, sorted_list, sizeof(gpointer) * total);
+    g_free(sorted_list);
+    g_free(item);
+    g_free(temp);
+    return;
+    }
+
@@ -0,0 +1,62 @@
+/****************************************************************\
+*                                                                *
+*  Library for radix sorting on integer keys                     *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#ifndef INCLUDED_RADIXSORT_H
+#define INCLUDED_RADIXSORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <glib.h>
+
+typedef guint64 (*RadixSort_Key_Func)(gconstpointer data,
+                                      gpointer user_data);
+
+void RadixSort_sort(gpointer base, gsize total, gsize size,
+                    RadixSort_Key_Func key_func, gpointer user_data);
+/* Sorts total elements of size bytes from base into ascending key order.
+ * key_func is called once per element with a pointer to the element.
+ */
+
+void RadixSort_sort_pointers(gpointer *list, gsize total,
+                             RadixSort_Key_Func key_func,
+                             gpointer user_data);
+/* As RadixSort_sort() for a list of pointers (eg. GPtrArray->pdata),
+ * but key_func is called with each pointer in the list.
+ */
+
+gsize RadixSort_memory_usage(gsize total, gsize size);
+/* Returns the peak temporary memory RadixSort_sort() will allocate
+ * for total elements of size bytes.
+ */
+
+#define RadixSort_pair_key(major, minor) \
+    ((((guint64)(guint32)(major)) << 32) | ((guint64)(guint32)(minor)))
+/* Combines two non-negative 32 bit values into a single key,
+ * ordered on major then minor.
+ */
+
+/* Both sorts are stable, so elements with equal keys keep their order.
+ * Only the significant bytes of (max_key - min_key) are used,
+ * so small key ranges need fewer passes.
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* INCLUDED_RADIXSORT_H */
+
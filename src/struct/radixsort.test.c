@@ -0,0 +1,87 @@
+/****************************************************************\
+*                                                                *
+*  Library for radix sorting on integer keys                     *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#include "radixsort.h"
+
+typedef struct {
+    gint major;
+    gint minor;
+    gint id;
+} Data;
+
+static guint64 test_data_key(gconstpointer data, gpointer user_data){
+    register const Data *d = data;
+    register gint *offset = user_data;
+    return RadixSort_pair_key(d->major + (*offset), d->minor);
+    }
+
+static guint64 test_pointer_key(gconstpointer data, gpointer user_data){
+    return test_data_key(data, user_data);
+    }
+
+static void test_check_order(Data *data, gint total){
+    register gint i;
+    for(i = 1; i < total; i++){
+        g_assert(data[i-1].major <= data[i].major);
+        if(data[i-1].major == data[i].major){
+            g_assert(data[i-1].minor <= data[i].minor);
+            if(data[i-1].minor == data[i].minor) /* Stable */
+                g_assert(data[i-1].id < data[i].id);
+            }
+        }
+    return;
+    }
+
+static void test_sort(gint total, gint major_range, gint minor_range){
+    register Data *data = g_new(Data, total);
+    register Data **list = g_new(Data*, total);
+    register Data *copy = g_new(Data, total);
+    register gint i;
+    register guint seed = total;
+    gint offset = major_range; /* Allow negative major values */
+    for(i = 0; i < total; i++){
+        seed = (seed * 1103515245) + 12345;
+        data[i].major = ((seed >> 8) % (major_range << 1)) - major_range;
+        seed = (seed * 1103515245) + 12345;
+        data[i].minor = (seed >> 8) % minor_range;
+        data[i].id = i;
+        list[i] = &data[i];
+        }
+    RadixSort_sort_pointers((gpointer*)list, total,
+                            test_pointer_key, &offset);
+    for(i = 0; i < total; i++)
+        copy[i] = *list[i];
+    test_check_order(copy, total);
+    RadixSort_sort(data, total, sizeof(Data), test_data_key, &offset);
+    test_check_order(data, total);
+    for(i = 0; i < total; i++){
+        g_assert(data[i].id == copy[i].id);
+        }
+    g_free(data);
+    g_free(list);
+    g_free(copy);
+    return;
+    }
+
+int main(void){
+    test_sort(0, 1, 1);
+    test_sort(1, 1, 1);
+    test_sort(20, 5, 3);
+    test_sort(1000, 1, 1);
+    test_sort(1000, 4, 1000000);
+    test_sort(50000, 100000, 7);
+    return 0;
+    }
+
@@ -119,8 +119,7 @@ static void RangeTree_insert(RangeTree *rt, RangeTree_Node *rtn){
     return;
     }
 
-
-static void RangeTree_insert_recent(RangeTree *rt){
+void RangeTree_insert_recent(RangeTree *rt){
     /* Remove root node with each iteration */
     while (rt->recent_data) {
         RangeTree_insert(rt, *((RangeTree_Node **)(rt->recent_data)));
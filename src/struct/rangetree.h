@@ -46,6 +46,11 @@ void RangeTree_destroy(RangeTree *rt, RangeTree_FreeFunc rtff,
 
 void RangeTree_add(RangeTree *rt, gint x, gint y, gpointer info);
 
+void RangeTree_insert_recent(RangeTree *rt);
+/* Moves points from RangeTree_add() into the tree,
+ * after which RangeTree_find() only reads the tree.
+ */
+
 typedef gboolean (*RangeTree_ReportFunc)(gint x, gint y, gpointer info,
                                          gpointer user_data);
 
@@ -18,6 +18,10 @@
 #include "recyclebin.h"
 
 static void *global_recycle_bin_tree = NULL;
+#ifdef USE_PTHREADS
+#include <pthread.h>
+static pthread_mutex_t global_recycle_bin_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif /* USE_PTHREADS */
 
 static int RecycleBin_compare(const void *a,
                               const void *b){
@@ -42,7 +46,17 @@ RecycleBin *RecycleBin_create(gchar *name, gsize node_size,
     recycle_bin->node_size = node_size;
     recycle_bin->count = 0;
     recycle_bin->recycle = NULL;
+    recycle_bin->pool = NULL;
+    recycle_bin->spare_list = g_ptr_array_new();
+    recycle_bin->spare_limit = -1;
+#ifdef USE_PTHREADS
+    pthread_mutex_init(&recycle_bin->pool_lock, NULL);
+    pthread_mutex_lock(&global_recycle_bin_lock);
+#endif /* USE_PTHREADS */
     tsearch((void *)recycle_bin, &global_recycle_bin_tree, RecycleBin_compare);
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&global_recycle_bin_lock);
+#endif /* USE_PTHREADS */
     return recycle_bin;
     }
 
@@ -50,13 +64,43 @@ void RecycleBin_destroy(RecycleBin *recycle_bin){
     register gint i;
     if(--recycle_bin->ref_count)
         return;
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&global_recycle_bin_lock);
+#endif /* USE_PTHREADS */
     g_assert(global_recycle_bin_tree);
     g_assert(tfind((void *)recycle_bin, &global_recycle_bin_tree, 
            RecycleBin_compare));
     tdelete((void *)recycle_bin, &global_recycle_bin_tree, RecycleBin_compare);
-    for(i = 0; i < recycle_bin->chunk_list->len; i++)
-        g_free(recycle_bin->chunk_list->pdata[i]);
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&global_recycle_bin_lock);
+#endif /* USE_PTHREADS */
+    if(recycle_bin->pool){ /* Give all chunks back to the pool */
+#ifdef USE_PTHREADS
+        pthread_mutex_lock(&recycle_bin->pool->pool_lock);
+#endif /* USE_PTHREADS */
+        for(i = 0; i < recycle_bin->chunk_list->len; i++){
+            if((recycle_bin->pool->spare_limit < 0)
+            || (recycle_bin->pool->spare_list->len
+                < recycle_bin->pool->spare_limit))
+                g_ptr_array_add(recycle_bin->pool->spare_list,
+                                recycle_bin->chunk_list->pdata[i]);
+            else
+                g_free(recycle_bin->chunk_list->pdata[i]);
+            }
+#ifdef USE_PTHREADS
+        pthread_mutex_unlock(&recycle_bin->pool->pool_lock);
+#endif /* USE_PTHREADS */
+    } else {
+        for(i = 0; i < recycle_bin->chunk_list->len; i++)
+            g_free(recycle_bin->chunk_list->pdata[i]);
+        }
+    for(i = 0; i < recycle_bin->spare_list->len; i++)
+        g_free(recycle_bin->spare_list->pdata[i]);
     g_ptr_array_free(recycle_bin->chunk_list, TRUE);
+    g_ptr_array_free(recycle_bin->spare_list, TRUE);
+#ifdef USE_PTHREADS
+    pthread_mutex_destroy(&recycle_bin->pool_lock);
+#endif /* USE_PTHREADS */
     g_free(recycle_bin->name);
     g_free(recycle_bin);
     return;
@@ -68,12 +112,66 @@ RecycleBin *RecycleBin_share(RecycleBin *recycle_bin){
     return recycle_bin;
     }
 
+RecycleBin *RecycleBin_create_local(RecycleBin *pool){
+    register RecycleBin *recycle_bin;
+    g_assert(pool);
+    g_assert(!pool->pool);
+    recycle_bin = RecycleBin_create(pool->name, pool->node_size,
+                                    pool->nodes_per_chunk);
+    recycle_bin->pool = pool;
+    return recycle_bin;
+    }
+
+void RecycleBin_set_spare_limit(RecycleBin *pool, gint spare_limit){
+    register gint i;
+    g_assert(pool);
+    g_assert(!pool->pool);
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&pool->pool_lock);
+#endif /* USE_PTHREADS */
+    pool->spare_limit = spare_limit;
+    if((spare_limit >= 0) && (pool->spare_list->len > spare_limit)){
+        for(i = spare_limit; i < pool->spare_list->len; i++)
+            g_free(pool->spare_list->pdata[i]);
+        g_ptr_array_set_size(pool->spare_list, spare_limit);
+        }
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&pool->pool_lock);
+#endif /* USE_PTHREADS */
+    return;
+    }
+
 gsize RecycleBin_memory_usage(RecycleBin *recycle_bin){
     g_assert(recycle_bin);
     return recycle_bin->node_size
          * recycle_bin->nodes_per_chunk
-         * recycle_bin->chunk_list->len;
+         * (recycle_bin->chunk_list->len + recycle_bin->spare_list->len);
+    }
+
+static gchar *RecycleBin_get_chunk(RecycleBin *recycle_bin){
+    register gchar *chunk = NULL;
+    if(recycle_bin->pool){
+#ifdef USE_PTHREADS
+        pthread_mutex_lock(&recycle_bin->pool->pool_lock);
+#endif /* USE_PTHREADS */
+        if(recycle_bin->pool->spare_list->len){
+            chunk = recycle_bin->pool->spare_list->pdata
+                   [recycle_bin->pool->spare_list->len-1];
+            g_ptr_array_set_size(recycle_bin->pool->spare_list,
+                                 recycle_bin->pool->spare_list->len-1);
+            }
+#ifdef USE_PTHREADS
+        pthread_mutex_unlock(&recycle_bin->pool->pool_lock);
+#endif /* USE_PTHREADS */
+        }
+    if(!chunk)
+        chunk = g_malloc(recycle_bin->nodes_per_chunk
+                       * recycle_bin->node_size);
+    return chunk;
     }
+/* The pool lock is only taken once per chunk,
+ * so local RecycleBins rarely contend for it.
+ */
 
 gpointer RecycleBin_alloc(RecycleBin *recycle_bin){
     register RecycleBin_Node *node;
@@ -84,8 +182,7 @@ gpointer RecycleBin_alloc(RecycleBin *recycle_bin){
         recycle_bin->recycle = node->next;
     } else {
         if(recycle_bin->chunk_pos == recycle_bin->nodes_per_chunk){
-            chunk = g_malloc(recycle_bin->nodes_per_chunk
-                           * recycle_bin->node_size);
+            chunk = RecycleBin_get_chunk(recycle_bin);
             g_ptr_array_add(recycle_bin->chunk_list, chunk);
             recycle_bin->chunk_pos = 1;
             node = (RecycleBin_Node*)chunk;
@@ -116,6 +213,50 @@ void RecycleBin_recycle(RecycleBin *recycle_bin, gpointer data){
     return;
     }
 
+void RecycleBin_merge(RecycleBin *recycle_bin, RecycleBin *src){
+    register gint i;
+    register gpointer last_chunk;
+    register RecycleBin_Node *node;
+    g_assert(recycle_bin != src);
+    g_assert(recycle_bin->node_size == src->node_size);
+    g_assert((!recycle_bin->pool)
+          || (recycle_bin->nodes_per_chunk == src->nodes_per_chunk));
+    if(!src->chunk_list->len)
+        return;
+    /* Insert chunks before the last, so chunk_pos stays valid */
+    last_chunk = recycle_bin->chunk_list->len
+               ? recycle_bin->chunk_list->pdata
+                 [recycle_bin->chunk_list->len-1]
+               : NULL;
+    if(last_chunk)
+        g_ptr_array_set_size(recycle_bin->chunk_list,
+                             recycle_bin->chunk_list->len-1);
+    for(i = 0; i < src->chunk_list->len; i++)
+        g_ptr_array_add(recycle_bin->chunk_list, src->chunk_list->pdata[i]);
+    if(last_chunk){
+        g_ptr_array_add(recycle_bin->chunk_list, last_chunk);
+    } else {
+        recycle_bin->chunk_pos = src->chunk_pos;
+        recycle_bin->nodes_per_chunk = src->nodes_per_chunk;
+        }
+    /* Append the free list of src */
+    if(src->recycle){
+        for(node = src->recycle; node->next; node = node->next);
+        node->next = recycle_bin->recycle;
+        recycle_bin->recycle = src->recycle;
+        }
+    recycle_bin->count += src->count;
+    g_ptr_array_set_size(src->chunk_list, 0);
+    src->chunk_pos = src->nodes_per_chunk;
+    src->count = 0;
+    src->recycle = NULL;
+    return;
+    }
+/* Moves all the memory of src into recycle_bin,
+ * so nodes allocated from src may outlive it.
+ * The unused tail of the last chunk of src is not reused.
+ */
+
 static void RecycleBin_profile_traverse(const void *ptr,
                                              VISIT order,
                                                int level){
@@ -131,10 +272,16 @@ static void RecycleBin_profile_traverse(const void *ptr,
 
 void RecycleBin_profile(void){
     g_message("BEGIN RecycleBin profile");
+#ifdef USE_PTHREADS
+    pthread_mutex_lock(&global_recycle_bin_lock);
+#endif /* USE_PTHREADS */
     if(global_recycle_bin_tree)
         twalk(global_recycle_bin_tree, RecycleBin_profile_traverse);
     else
         g_message("no active RecycleBins");
+#ifdef USE_PTHREADS
+    pthread_mutex_unlock(&global_recycle_bin_lock);
+#endif /* USE_PTHREADS */
     g_message("END RecycleBin profile");
     return;
     }
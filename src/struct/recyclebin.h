@@ -22,11 +22,15 @@ extern "C" {
 
 #include <glib.h>
 
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif /* USE_PTHREADS */
+
 typedef struct RecycleBin_Node {
      struct RecycleBin_Node *next;
 } RecycleBin_Node;
 
-typedef struct {
+typedef struct RecycleBin {
                 gint  ref_count;
                gchar *name;
            GPtrArray *chunk_list;
@@ -35,18 +39,36 @@ typedef struct {
                gsize  node_size;
                 gint  count;
      RecycleBin_Node *recycle;
+   struct RecycleBin *pool;       /* Shared pool for a local cache */
+           GPtrArray *spare_list; /* Unused chunks held by a pool  */
+                gint  spare_limit; /* Max spare chunks (-1 for any) */
+#ifdef USE_PTHREADS
+     pthread_mutex_t  pool_lock;
+#endif /* USE_PTHREADS */
 } RecycleBin;
 
 RecycleBin *RecycleBin_create(gchar *name, gsize node_size,
                               gint nodes_per_chunk);
       void  RecycleBin_destroy(RecycleBin *recycle_bin);
 RecycleBin *RecycleBin_share(RecycleBin *recycle_bin);
+RecycleBin *RecycleBin_create_local(RecycleBin *pool);
+/* A local RecycleBin is used by a single thread without locking.
+ * It takes new chunks from the spare chunks of the pool,
+ * and gives all of its chunks back to the pool when destroyed.
+ * The pool must outlive the local RecycleBins created from it.
+ */
+
+void RecycleBin_set_spare_limit(RecycleBin *pool, gint spare_limit);
+/* Chunks given back to the pool beyond spare_limit are freed,
+ * so the pool does not hold on to its peak usage.
+ */
 
    gsize RecycleBin_memory_usage(RecycleBin *recycle_bin);
 
 gpointer RecycleBin_alloc(RecycleBin *recycle_bin);
 gpointer RecycleBin_alloc_blank(RecycleBin *recycle_bin);
     void RecycleBin_recycle(RecycleBin *recycle_bin, gpointer data);
+    void RecycleBin_merge(RecycleBin *recycle_bin, RecycleBin *src);
     void RecycleBin_profile(void);
 #define  RecycleBin_total(rb) ((rb)->count)
 
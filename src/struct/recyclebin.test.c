@@ -17,14 +17,56 @@
 
 int main(void){
     register RecycleBin *rb = RecycleBin_create("test",
-                                     sizeof(gpointer), 3);
+                                     sizeof(gpointer), 3),
+                        *src = RecycleBin_create("src",
+                                     sizeof(gpointer), 3),
+                        *pool = RecycleBin_create("pool",
+                                     sizeof(gpointer), 3),
+                        *local;
     register gint i;
     register GPtrArray *list = g_ptr_array_new();
     for(i = 0; i < 12; i++)
         g_ptr_array_add(list, RecycleBin_alloc(rb));
     for(i = 0; i < 12; i++)
         RecycleBin_recycle(rb, list->pdata[i]);
+    g_ptr_array_set_size(list, 0);
+    /* Merge nodes from src, then release them against rb */
+    for(i = 0; i < 7; i++)
+        g_ptr_array_add(list, RecycleBin_alloc(src));
+    RecycleBin_merge(rb, src);
+    g_assert(RecycleBin_total(rb) == 7);
+    g_assert(RecycleBin_total(src) == 0);
+    RecycleBin_destroy(src);
+    for(i = 0; i < 7; i++)
+        RecycleBin_recycle(rb, list->pdata[i]);
+    g_assert(RecycleBin_total(rb) == 0);
     RecycleBin_destroy(rb);
+    /* Chunks of a local RecycleBin are reused through its pool */
+    local = RecycleBin_create_local(pool);
+    for(i = 0; i < 10; i++)
+        RecycleBin_alloc(local);
+    g_assert(local->chunk_list->len == 4);
+    RecycleBin_destroy(local);
+    g_assert(pool->spare_list->len == 4);
+    local = RecycleBin_create_local(pool);
+    for(i = 0; i < 5; i++)
+        RecycleBin_alloc(local);
+    g_assert(local->chunk_list->len == 2);
+    g_assert(pool->spare_list->len == 2);
+    RecycleBin_destroy(local);
+    g_assert(pool->spare_list->len == 4);
+    g_assert(RecycleBin_memory_usage(pool) == (sizeof(gpointer) * 3 * 4));
+    /* Spare chunks beyond the limit are freed */
+    RecycleBin_set_spare_limit(pool, 3);
+    g_assert(pool->spare_list->len == 3);
+    local = RecycleBin_create_local(pool);
+    for(i = 0; i < 15; i++)
+        RecycleBin_alloc(local);
+    g_assert(local->chunk_list->len == 5);
+    g_assert(pool->spare_list->len == 0);
+    RecycleBin_destroy(local);
+    g_assert(pool->spare_list->len == 3);
+    RecycleBin_destroy(pool);
     g_ptr_array_free(list, TRUE);
     return 0;
     }
@@ -13,6 +13,8 @@
 *                                                                *
 \****************************************************************/
 
+#include <string.h> /* For strcmp() */
+
 #include "argument.h"
 #include "dataset.h"
 #include "index.h"
@@ -20,14 +22,14 @@
 int Argument_main(Argument *arg){
     register ArgumentSet *as
            = ArgumentSet_create("Input and Output Options");
-    gchar *dataset_path, *index_path;
+    gchar *dataset_path, *index_path, *seed_pattern;
     register Dataset *dataset;
     register Index *index;
     gboolean is_translated = FALSE;
     register gint word_length;
     gint dna_word_length, protein_word_length,
          word_jump, word_ambiguity,
-         saturate_threshold, memory_limit;
+         saturate_threshold, memory_limit, minimizer_window;
     /**/
     ArgumentSet_add_option(as, 'd', "dataset", "path",
         "Exonerate dataset file", NULL,
@@ -52,6 +54,12 @@ int Argument_main(Argument *arg){
     ArgumentSet_add_option(as, 0, "wordambiguity", NULL,
         "Number of ambiguous words to index", "1",
         Argument_parse_int, &word_ambiguity);
+    ArgumentSet_add_option(as, 0, "seedpattern", "pattern",
+        "Spaced seed pattern for database words", "none",
+        Argument_parse_string, &seed_pattern);
+    ArgumentSet_add_option(as, 0, "minimizerwindow", NULL,
+        "Only index the minimizer of each window of words (0 for all words)",
+        "0", Argument_parse_int, &minimizer_window);
     ArgumentSet_add_option(as, 0, "saturatethreshold", NULL,
         "Word saturation threshold", "10",
         Argument_parse_int, &saturate_threshold);
@@ -74,11 +82,13 @@ int Argument_main(Argument *arg){
     if((word_ambiguity > 1)
     && (dataset->alphabet->type == Alphabet_Type_PROTEIN))
         g_error("Protein ambuigity symbols not implemented");
+    if(!strcmp(seed_pattern, "none"))
+        seed_pattern = NULL;
     g_message("Building index");
     index = Index_create(dataset, is_translated, word_length,
                          word_jump, word_ambiguity,
                          saturate_threshold, index_path, dataset_path,
-                         memory_limit);
+                         memory_limit, seed_pattern, minimizer_window);
     Index_destroy(index);
     Dataset_destroy(dataset);
     g_message("-- completed");
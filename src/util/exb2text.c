@@ -0,0 +1,69 @@
+/****************************************************************\
+*                                                                *
+*  exb2text : convert binary exonerate output to text            *
+*                                                                *
+*  Guy St.C. Slater..   mailto:guy@ebi.ac.uk                     *
+*  Copyright (C) 2000-2009.  All Rights Reserved.                *
+*                                                                *
+*  This source code is distributed under the terms of the        *
+*  GNU General Public License, version 3. See the file COPYING   *
+*  or http://www.gnu.org/licenses/gpl.txt for details            *
+*                                                                *
+*  If you use this code, please keep this notice intact.         *
+*                                                                *
+\****************************************************************/
+
+#include <stdio.h>
+#include <string.h> /* For strcmp() */
+
+#include "argument.h"
+#include "alignmentrecord.h"
+
+int Argument_main(Argument *arg){
+    register ArgumentSet *as
+           = ArgumentSet_create("Binary Input Options");
+    register FILE *fp;
+    register AlignmentRecord *ar;
+    gchar *input_path;
+    gboolean show_sugar, show_cigar, show_vulgar;
+    ArgumentSet_add_option(as, 'i', "input", "path",
+        "Binary alignment input file (- for stdin)", "-",
+        Argument_parse_string, &input_path);
+    ArgumentSet_add_option(as, 0, "showsugar", NULL,
+        "Include 'sugar' format output", "FALSE",
+        Argument_parse_boolean, &show_sugar);
+    ArgumentSet_add_option(as, 0, "showcigar", NULL,
+        "Include 'cigar' format output", "FALSE",
+        Argument_parse_boolean, &show_cigar);
+    ArgumentSet_add_option(as, 0, "showvulgar", NULL,
+        "Include 'vulgar' format output", "TRUE",
+        Argument_parse_boolean, &show_vulgar);
+    Argument_absorb_ArgumentSet(arg, as);
+    Argument_process(arg, "exb2text",
+        "A utility to convert binary exonerate output to text\n"
+        "Guy St.C. Slater. guy@ebi.ac.uk. 2000-2009.\n", NULL);
+    if(strcmp(input_path, "-")){
+        fp = fopen(input_path, "r");
+        if(!fp)
+            g_error("Could not open binary alignment file [%s]",
+                    input_path);
+    } else {
+        fp = stdin;
+        }
+    if(!AlignmentRecord_read_header(fp))
+        g_error("Input is not binary exonerate output");
+    ar = AlignmentRecord_create();
+    while(AlignmentRecord_read(ar, fp)){
+        if(show_sugar)
+            AlignmentRecord_display_sugar(ar, stdout);
+        if(show_cigar)
+            AlignmentRecord_display_cigar(ar, stdout);
+        if(show_vulgar)
+            AlignmentRecord_display_vulgar(ar, stdout);
+        }
+    AlignmentRecord_destroy(ar);
+    if(fp != stdin)
+        fclose(fp);
+    return 0;
+    }
+